@@ -0,0 +1,129 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "buffer_mgr.h"
+#include "policy_sim.h"
+
+/*
+ * Replays a page access trace dumped with dumpPoolTrace against every
+ * replacement strategy the simulator knows, at a range of pool sizes, and
+ * prints the hit ratio curves as tab separated columns:
+ *
+ *   bm_sim <trace file> [max frames] [step]
+ *
+ * Only pins count as accesses. Without max frames the curve goes up to the
+ * number of distinct pages in the trace, where every strategy is optimal.
+ */
+
+static int compareKeys (const void *a, const void *b)
+{
+	long long left = *(const long long *) a, right = *(const long long *) b;
+	return (left > right) - (left < right);
+}
+
+// Read the pins of a trace file as page keys
+static RC readTrace (const char *fileName, long long **keys, int *numKeys)
+{
+	int header[2];
+	BM_TraceEvent event;
+
+	FILE *traceFile = fopen(fileName, "rb");
+	if (traceFile == NULL)
+		return RC_FILE_NOT_FOUND;
+	if (fread(header, sizeof(int), 2, traceFile) != 2 || header[0] != BM_TRACE_MAGIC || header[1] < 0)
+	{
+		fclose(traceFile);
+		return RC_READING_FAILED;
+	}
+
+	*keys = malloc(sizeof(long long) * (header[1] > 0 ? header[1] : 1));
+	*numKeys = 0;
+	if (*keys == NULL)
+	{
+		fclose(traceFile);
+		return RC_ERROR;
+	}
+	for (int i = 0; i < header[1]; i++)
+	{
+		if (fread(&event, sizeof(BM_TraceEvent), 1, traceFile) != 1)
+		{
+			free(*keys);
+			fclose(traceFile);
+			return RC_READING_FAILED;
+		}
+		if (event.type == TE_PIN)
+			(*keys)[(*numKeys)++] = PS_KEY(event.fileId, event.pageNum);
+	}
+
+	fclose(traceFile);
+	return RC_OK;
+}
+
+static int countDistinct (const long long *keys, int numKeys)
+{
+	long long *sorted = malloc(sizeof(long long) * (numKeys > 0 ? numKeys : 1));
+	int distinct = 0;
+
+	if (sorted == NULL)
+		return numKeys;
+	memcpy(sorted, keys, sizeof(long long) * numKeys);
+	qsort(sorted, numKeys, sizeof(long long), compareKeys);
+	for (int i = 0; i < numKeys; i++)
+		if (i == 0 || sorted[i] != sorted[i - 1])
+			distinct++;
+	free(sorted);
+	return distinct;
+}
+
+int
+main (int argc, char *argv[])
+{
+	long long *keys;
+	int numKeys;
+
+	if (argc < 2 || argc > 4)
+	{
+		fprintf(stderr, "usage: %s <trace file> [max frames] [step]\n", argv[0]);
+		return 1;
+	}
+	if (readTrace(argv[1], &keys, &numKeys) != RC_OK)
+	{
+		fprintf(stderr, "%s: can not read trace file %s\n", argv[0], argv[1]);
+		return 1;
+	}
+
+	int maxFrames = (argc > 2) ? atoi(argv[2]) : countDistinct(keys, numKeys);
+	int step = (argc > 3) ? atoi(argv[3]) : maxFrames / 10;
+	if (maxFrames < 1)
+		maxFrames = 1;
+	if (step < 1)
+		step = 1;
+
+	printf("# %d pins, %d distinct pages\n", numKeys, countDistinct(keys, numKeys));
+	printf("frames");
+	for (int s = 0; s < PS_NUM_STRATEGIES; s++)
+		printf("\t%s", psStrategyName(psStrategies[s]));
+	printf("\n");
+
+	for (int frames = step; frames <= maxFrames; frames += step)
+	{
+		printf("%d", frames);
+		for (int s = 0; s < PS_NUM_STRATEGIES; s++)
+		{
+			PS_Cache cache;
+			if (psInit(&cache, frames, psStrategies[s]) != RC_OK)
+			{
+				free(keys);
+				return 1;
+			}
+			for (int i = 0; i < numKeys; i++)
+				psAccess(&cache, keys[i]);
+			printf("\t%.4f", psHitRatio(&cache));
+			psShutdown(&cache);
+		}
+		printf("\n");
+	}
+
+	free(keys);
+	return 0;
+}
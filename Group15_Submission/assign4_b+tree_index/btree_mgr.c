@@ -204,6 +204,22 @@ int saInsert(dynamicArr *arr, int elem) {
     return fitOn;
 }
 
+// Insert an element after the ones equal to it, returns where or -1 if the array is full
+int saInsertLast(dynamicArr *arr, int elem) {
+    if (arr->fill >= arr->size) {
+        return -1;
+    }
+
+    int fitOn;
+    int index = dynamicArrSearch(arr, elem, &fitOn);
+    if (index >= 0) {
+        while (fitOn < arr->fill && arr->elems[fitOn] == elem) {
+            fitOn++;
+        }
+    }
+    return saInsertAt(arr, elem, fitOn);
+}
+
 void saDeleteAt(dynamicArr *arr, int index, int count) {
     if (index < 0 || index >= arr->fill || count <= 0) {
         return;  // Invalid input
@@ -396,9 +412,12 @@ static void printNonLeafNodeData(BT_Node *node, char *result) {
     sprintf(result + strlen(result), "%d", node->childrenPages->elems[i]);
 }
 
+// Ring the nodes are read through while loadBtree runs, NULL otherwise
+static BM_AccessRing *loadRing = NULL;
+
 // Static helper function prototypes
 static RC pinAndGetPage(BTreeHandle *tree, BM_PageHandle **handleOfPage, int pageNum);
-static void readNodeHeader(char *ptr, intptr_t *leafIs, intptr_t *filler);
+static void readNodeHeader(char *ptr, int *leafIs, int *filler);
 static void readNodeData(BT_Node *node, char *ptr, int filler, int leafIs);
 static void readLeafNodeData(BT_Node *node, char *ptr, int index);
 static void readNonLeafNodeData(BT_Node *node, char *ptr, int index);
@@ -415,7 +434,7 @@ RC readNode(BT_Node **bTreeNode, BTreeHandle *tree, int pageNum) {
     }
 
     char *ptr = handleOfPage->data;
-    intptr_t leafIs, filler;
+    int leafIs, filler;
     readNodeHeader(ptr, &leafIs, &filler);
 
     BT_Node *_bTreeNode = createBTNode(tree->size, leafIs, pageNum);
@@ -429,7 +448,9 @@ RC readNode(BT_Node **bTreeNode, BTreeHandle *tree, int pageNum) {
 
 static RC pinAndGetPage(BTreeHandle *tree, BM_PageHandle **handleOfPage, int pageNum) {
     *handleOfPage = new(BM_PageHandle);
-    RC pinResult = pinPage(tree->mgmtData, *handleOfPage, pageNum);
+    RC pinResult = (loadRing != NULL)
+            ? pinPageRing(tree->mgmtData, *handleOfPage, pageNum, loadRing)
+            : pinPage(tree->mgmtData, *handleOfPage, pageNum);
     if (pinResult != RC_OK) {
         free(*handleOfPage);
         return pinResult;
@@ -437,20 +458,23 @@ static RC pinAndGetPage(BTreeHandle *tree, BM_PageHandle **handleOfPage, int pag
     return RC_OK;
 }
 
-static void readNodeHeader(char *ptr, intptr_t *leafIs, intptr_t *filler) {
-    *leafIs = (intptr_t)ptr;
+static void readNodeHeader(char *ptr, int *leafIs, int *filler) {
+    memcpy(leafIs, ptr, SIZE_INT);
     ptr += SIZE_INT;
-    *filler = (intptr_t)ptr;
+    memcpy(filler, ptr, SIZE_INT);
 }
 
+// A leaf entry is the RID and the key, an inner node entry the child page left of the
+// key and the key, followed by the last child page
 static void readNodeData(BT_Node *node, char *ptr, int filler, int leafIs) {
     for (int q = 0; q < filler; q++) {
         if (leafIs) {
             readLeafNodeData(node, ptr, q);
+            ptr += 3 * SIZE_INT;
         } else {
             readNonLeafNodeData(node, ptr, q);
+            ptr += 2 * SIZE_INT;
         }
-        ptr += 3 * SIZE_INT;
     }
     if (!leafIs) {
         int childPage;
@@ -501,18 +525,22 @@ static void writeNodeHeader(char *ptr, BT_Node *node) {
     memcpy(ptr, &node->vals->fill, SIZE_INT);
 }
 
+// Same layout readNodeData reads
 static void writeNodeData(char *ptr, BT_Node *node) {
     for (int i = 0; i < node->vals->fill; i++) {
-        int index = (node->isLeaf) ? i : (node->vals->fill - i - 1);
-        memcpy(ptr, (node->isLeaf) ? &node->leafRIDPages->elems[index] : &node->childrenPages->elems[index], SIZE_INT);
+        if (node->isLeaf) {
+            memcpy(ptr, &node->leafRIDPages->elems[i], SIZE_INT);
+            ptr += SIZE_INT;
+            memcpy(ptr, &node->leafRIDSlots->elems[i], SIZE_INT);
+        } else {
+            memcpy(ptr, &node->childrenPages->elems[i], SIZE_INT);
+        }
         ptr += SIZE_INT;
-        memcpy(ptr, (node->isLeaf) ? &node->leafRIDSlots->elems[index] : &node->vals->elems[index], SIZE_INT);
+        memcpy(ptr, &node->vals->elems[i], SIZE_INT);
         ptr += SIZE_INT;
     }
     if (!node->isLeaf) {
         memcpy(ptr, &node->childrenPages->elems[node->vals->fill], SIZE_INT);
-    } else {
-        memcpy(ptr, &node->leafRIDPages->elems[node->vals->fill], SIZE_INT);
     }
 }
 
@@ -615,14 +643,13 @@ static void updateSiblingPointersForLoading(BT_Node *left, BT_Node *current) {
     }
 }
 
+// The leftmost leaf a key can be in. Records may share a key, so the keys equal to a
+// key of an inner node can be on both sides of it.
 static BT_Node *findLeafNode(BTreeHandle *tree, int key) {
     BT_Node *current = tree->root;
-    int index, fitOn;
+    int fitOn;
     while(current != NULL && !current->isLeaf) {
-        index = dynamicArrSearch(current->vals, key, &fitOn);
-        if (index >= 0) {
-            fitOn += 1;
-        }
+        dynamicArrSearch(current->vals, key, &fitOn);
         current = current->children[fitOn];
     }
     return current;
@@ -632,7 +659,7 @@ BT_Node *findNodeByKey(BTreeHandle *tree, int key) {
     return findLeafNode(tree, key);
 }
 
-RC loadBtree(BTreeHandle *tree) {
+static RC readBtree(BTreeHandle *tree) {
     RC err;
     tree->root = NULL;
     if (tree->depth) {
@@ -651,6 +678,22 @@ RC loadBtree(BTreeHandle *tree) {
     return RC_OK;
 }
 
+RC loadBtree(BTreeHandle *tree) {
+    BM_AccessRing ring;
+
+    // The whole tree is kept in memory, so its pages are read once through
+    // a small ring instead of pushing other pages out of a shared pool
+    if (tree->depth && initAccessRing(&ring, SCAN_RING_SIZE) == RC_OK) {
+        loadRing = &ring;
+    }
+    RC err = readBtree(tree);
+    if (loadRing != NULL) {
+        shutdownAccessRing(loadRing);
+        loadRing = NULL;
+    }
+    return err;
+}
+
 static RC initializeLeftOnLevel(BT_Node **leftOnLevel, int depth) {
     for (int i = 0; i < depth; i++) {
         leftOnLevel[i] = NULL;
@@ -700,7 +743,7 @@ static RC writeTreeHeaderToPage(BTreeHandle *tree, char *ptr) {
 // Function prototypes
 static BT_Node* createNewRoot(BTreeHandle* tree, BT_Node* left);
 static RC insertIntoNonFullParent(BT_Node* parent, BT_Node* right, int index, BTreeHandle* tree);
-static RC handleParentOverflow(BTreeHandle* tree, BT_Node* parent, BT_Node* right, int key);
+static RC handleParentOverflow(BTreeHandle* tree, BT_Node* parent, BT_Node* right, int key, int index);
 static BT_Node* createOverflowedNode(BTreeHandle* tree, BT_Node* parent);
 static void insertIntoOverflowedNode(BT_Node* overflowed, BT_Node* right, int key, int index);
 static BT_Node* splitOverflowedNode(BTreeHandle* tree, BT_Node* parent, BT_Node* overflowed);
@@ -716,12 +759,16 @@ RC insPropagateParent(BTreeHandle *tree, BT_Node *left, BT_Node *right, int key)
 
     right->parent = parent;
     left->parent = parent;
-    index = saInsert(parent->vals, key);
 
-    if (index >= 0) {
+    // The key goes right after the left node, other keys of the parent may be equal to it
+    index = 0;
+    while (parent->children[index] != left) {
+        index++;
+    }
+    if (saInsertAt(parent->vals, key, index) >= 0) {
         return insertIntoNonFullParent(parent, right, index, tree);
     } else {
-        return handleParentOverflow(tree, parent, right, key);
+        return handleParentOverflow(tree, parent, right, key, index);
     }
 }
 
@@ -748,9 +795,9 @@ static RC insertIntoNonFullParent(BT_Node* parent, BT_Node* right, int index, BT
     return writeNode(parent, tree);
 }
 
-static RC handleParentOverflow(BTreeHandle* tree, BT_Node* parent, BT_Node* right, int key) {
+static RC handleParentOverflow(BTreeHandle* tree, BT_Node* parent, BT_Node* right, int key, int index) {
     BT_Node* overflowed = createOverflowedNode(tree, parent);
-    int index = saInsert(overflowed->vals, key);
+    saInsertAt(overflowed->vals, key, index);
     insertIntoOverflowedNode(overflowed, right, key, index);
 
     BT_Node* rightParent = splitOverflowedNode(tree, parent, overflowed);
@@ -843,6 +890,13 @@ static BT_Node* splitOverflowedNode(BTreeHandle* tree, BT_Node* parent, BT_Node*
            overflowed->children + leftPtrSize,
            sizeof(BT_Node*) * rightParent->childrenPages->fill);
 
+    // The children that moved over get the right node as their parent
+    for (int i = 0; i < rightParent->childrenPages->fill; i++) {
+        if (rightParent->children[i] != NULL) {
+            rightParent->children[i]->parent = rightParent;
+        }
+    }
+
     // Clean up and return
     destroyBTNode(overflowed);
     return rightParent;
@@ -910,11 +964,16 @@ void freeNodes(BT_Node* root) {
     }
 }
 
+// Buffer pool shared by all indexes, NULL if every index gets its own pool
+static BM_SharedPool *indexPool = NULL;
 RC shutdownIndexManager() {
+    indexPool = NULL;
     return RC_OK;
 }
 
 RC initIndexManager(void *mgmtData) {
+    // mgmtData may hand us a buffer pool to cache all the indexes in
+    indexPool = (BM_SharedPool *)mgmtData;
     return RC_OK;
 }
 
@@ -977,7 +1036,14 @@ RC openBtree(BTreeHandle **tree, char *idxId) {
         return RC_ERROR;
     }
 
-    RC rc = initBufferPool(bufferPool, idxId, PER_IDX_BUF_SIZE, RS_LRU, NULL);
+    // An index in a shared pool may use as many frames as it needs, and table
+    // traffic does not push its pages out while there are table pages to replace
+    BM_PoolOptions indexOptions;
+    memset(&indexOptions, 0, sizeof(BM_PoolOptions));
+    indexOptions.priority = INDEX_POOL_PRIORITY;
+    RC rc = (indexPool != NULL)
+            ? attachBufferPoolWithOptions(bufferPool, indexPool, idxId, 0, &indexOptions)
+            : initBufferPool(bufferPool, idxId, PER_IDX_BUF_SIZE, RS_LRU, NULL);
     if (rc != RC_OK) {
         free(bufferPool);
         free(newTree);
@@ -1094,26 +1160,68 @@ RC getKeyType(BTreeHandle *tree, DataType *result) {
     return RC_OK;
 }
 
+// The first entry with a key, found in the leaf findLeafNode leads to or one right of
+// it. If there is none, node and index are where the next larger key is, node is NULL
+// past the last leaf.
+static bool findFirstEntry(BTreeHandle *tree, int key, BT_Node **node, int *index) {
+    BT_Node *leaf = findLeafNode(tree, key);
+    int fitOn = 0;
+
+    while (leaf != NULL) {
+        int found = dynamicArrSearch(leaf->vals, key, &fitOn);
+        if (found >= 0) {
+            *node = leaf;
+            *index = found;
+            return true;
+        }
+        if (fitOn < leaf->vals->fill) {
+            break;
+        }
+        leaf = leaf->right;
+        fitOn = 0;
+    }
+    *node = leaf;
+    *index = fitOn;
+    return false;
+}
+
+// The entry of a key and a RID, the entries with the same key follow each other
+static bool findEntry(BTreeHandle *tree, int key, RID rid, BT_Node **node, int *index) {
+    BT_Node *leaf;
+    int i;
+
+    if (!findFirstEntry(tree, key, &leaf, &i)) {
+        return false;
+    }
+    for (; leaf != NULL; leaf = leaf->right, i = 0) {
+        for (; i < leaf->vals->fill; i++) {
+            if (leaf->vals->elems[i] != key) {
+                return false;
+            }
+            if (leaf->leafRIDPages->elems[i] == rid.page && leaf->leafRIDSlots->elems[i] == rid.slot) {
+                *node = leaf;
+                *index = i;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
 RC findKey(BTreeHandle *tree, Value *key, RID *result) {
     if (tree == NULL || key == NULL || result == NULL) {
         return RC_INVALID_PARAMETER;
     }
 
-    BT_Node *targetNode = findNodeByKey(tree, key->v.intV);
-    if (targetNode == NULL) {
+    BT_Node *targetNode;
+    int foundIndex;
+    if (!findFirstEntry(tree, key->v.intV, &targetNode, &foundIndex)) {
         return RC_IM_KEY_NOT_FOUND;
     }
 
-    int targetIndex;
-    int foundIndex = dynamicArrSearch(targetNode->vals, key->v.intV, &targetIndex);
-
-    if (foundIndex >= 0) {
-        result->page = targetNode->leafRIDPages->elems[foundIndex];
-        result->slot = targetNode->leafRIDSlots->elems[foundIndex];
-        return RC_OK;
-    }
-
-    return RC_IM_KEY_NOT_FOUND;
+    result->page = targetNode->leafRIDPages->elems[foundIndex];
+    result->slot = targetNode->leafRIDSlots->elems[foundIndex];
+    return RC_OK;
 }
 
 static RC initializeNewNode(BTreeHandle *tree, BT_Node *targetNode);
@@ -1121,7 +1229,8 @@ static RC insertIntoNonFullNode(BTreeHandle *tree, BT_Node *targetNode, Value *k
 static RC splitAndInsertIntoFullNode(BTreeHandle *tree, BT_Node *targetNode, Value *key, RID rid);
 static void copyNodeData(BT_Node *dest, BT_Node *src, int start, int count);
 
-RC insertKey(BTreeHandle *tree, Value *key, RID rid)
+// Put an entry into the leaf its key leads to, after the entries with the same key
+static RC insertIntoLeaf(BTreeHandle *tree, Value *key, RID rid)
 {
     BT_Node *targetNode = findNodeByKey(tree, key->v.intV);
 
@@ -1131,14 +1240,7 @@ RC insertKey(BTreeHandle *tree, Value *key, RID rid)
         initializeNewNode(tree, targetNode);
     }
 
-    int target = 0;
-    int i = dynamicArrSearch(targetNode->vals, key->v.intV, &target);
-    if (i >= 0)
-    {
-        return RC_IM_KEY_ALREADY_EXISTS;
-    }
-
-    i = saInsert(targetNode->vals, key->v.intV);
+    int i = saInsertLast(targetNode->vals, key->v.intV);
 
     if (i >= 0)
     {
@@ -1150,6 +1252,23 @@ RC insertKey(BTreeHandle *tree, Value *key, RID rid)
     }
 }
 
+RC insertKey(BTreeHandle *tree, Value *key, RID rid)
+{
+    BT_Node *node;
+    int index;
+
+    if (findFirstEntry(tree, key->v.intV, &node, &index))
+    {
+        return RC_IM_KEY_ALREADY_EXISTS;
+    }
+    return insertIntoLeaf(tree, key, rid);
+}
+
+RC insertEntry(BTreeHandle *tree, Value *key, RID rid)
+{
+    return insertIntoLeaf(tree, key, rid);
+}
+
 static RC initializeNewNode(BTreeHandle *tree, BT_Node *targetNode)
 {
     tree->root = targetNode;
@@ -1167,7 +1286,7 @@ static RC insertIntoNonFullNode(BTreeHandle *tree, BT_Node *targetNode, Value *k
     saInsertAt(targetNode->leafRIDSlots, rid.slot, index);
     tree->numEntries = tree->numEntries + 1;
     writeBtreeHeader(tree);
-    return RC_OK;
+    return writeNode(targetNode, tree);
 }
 
 static NodeSplitConfig calculateSplitConfig(int totalElements) {
@@ -1197,7 +1316,7 @@ static BT_Node* prepareTempNode(BTreeHandle* tree, BT_Node* sourceNode, Value* k
     copyNodeData(tempNode, sourceNode, 0, sourceNode->vals->fill);
 
     // Insert new data
-    int insertIndex = saInsert(tempNode->vals, key->v.intV);
+    int insertIndex = saInsertLast(tempNode->vals, key->v.intV);
     saInsertAt(tempNode->leafRIDPages, rid.page, insertIndex);
     saInsertAt(tempNode->leafRIDSlots, rid.slot, insertIndex);
 
@@ -1264,18 +1383,7 @@ static void copyNodeData(BT_Node *dest, BT_Node *src, int start, int count)
     memcpy(dest->leafRIDSlots->elems, src->leafRIDSlots->elems + start, SIZE_INT * count);
 }
 
-RC deleteKey(BTreeHandle *tree, Value *key) {
-    BT_Node *targetNode = findNodeByKey(tree, key->v.intV);
-    if (targetNode == NULL) {
-        return RC_OK;
-    }
-
-    int target;
-    int i = dynamicArrSearch(targetNode->vals, key->v.intV, &target);
-    if (i < 0) {
-        return RC_OK;
-    }
-
+static void removeEntry(BTreeHandle *tree, BT_Node *targetNode, int i) {
     saDeleteAt(targetNode->vals, i, 1);
     saDeleteAt(targetNode->leafRIDPages, i, 1);
     saDeleteAt(targetNode->leafRIDSlots, i, 1);
@@ -1283,6 +1391,26 @@ RC deleteKey(BTreeHandle *tree, Value *key) {
 
     writeNode(targetNode, tree);
     writeBtreeHeader(tree);
+}
+
+RC deleteKey(BTreeHandle *tree, Value *key) {
+    BT_Node *targetNode;
+    int i;
+
+    if (findFirstEntry(tree, key->v.intV, &targetNode, &i)) {
+        removeEntry(tree, targetNode, i);
+    }
+    return RC_OK;
+}
+
+RC deleteEntry(BTreeHandle *tree, Value *key, RID rid) {
+    BT_Node *targetNode;
+    int i;
+
+    if (!findEntry(tree, key->v.intV, rid, &targetNode, &i)) {
+        return RC_IM_KEY_NOT_FOUND;
+    }
+    removeEntry(tree, targetNode, i);
     return RC_OK;
 }
 
@@ -1309,11 +1437,40 @@ RC openTreeScan(BTreeHandle *tree, BT_ScanHandle **handle) {
 
     bt_scanHandle->mgmtData = scanMgmDetails;
     scanMgmDetails->elementIndex = 0;
+    scanMgmDetails->bounded = false;
     *handle = bt_scanHandle;
 
     return RC_OK;
 }
 
+RC openTreeRangeScan(BTreeHandle *tree, Value *low, Value *high, BT_ScanHandle **handle) {
+    RC rc = openTreeScan(tree, handle);
+    if (rc != RC_OK) {
+        return rc;
+    }
+
+    ScanMgmtInfo *scanMgmtInfo = (*handle)->mgmtData;
+    if (high != NULL) {
+        scanMgmtInfo->bounded = true;
+        scanMgmtInfo->high = high->v.intV;
+    }
+
+    // Start at the first key that is not smaller than low, or after the last leaf
+    if (low != NULL) {
+        BT_Node *node;
+        findFirstEntry(tree, low->v.intV, &node, &scanMgmtInfo->elementIndex);
+        if (node == NULL) {
+            node = scanMgmtInfo->currentNode;
+            while (node->right != NULL) {
+                node = node->right;
+            }
+            scanMgmtInfo->elementIndex = node->vals->fill;
+        }
+        scanMgmtInfo->currentNode = node;
+    }
+    return RC_OK;
+}
+
 RC closeTreeScan(BT_ScanHandle *handle) {
     if (handle) {
         free(handle->mgmtData);
@@ -1326,17 +1483,22 @@ RC closeTreeScan(BT_ScanHandle *handle) {
 RC nextEntry(BT_ScanHandle *handle, RID *result) {
     ScanMgmtInfo *scanMgmtInfo = handle->mgmtData;
 
-    // Check for overflow and move to next node if necessary
-    if (scanMgmtInfo->elementIndex >= scanMgmtInfo->currentNode->leafRIDPages->fill) {
-        if (scanMgmtInfo->elementIndex == scanMgmtInfo->currentNode->vals->fill) {
-            if (scanMgmtInfo->currentNode->right == NULL) {
-                return RC_IM_NO_MORE_ENTRIES;
-            }
-            scanMgmtInfo->currentNode = scanMgmtInfo->currentNode->right;
+    // Check for overflow and move to next node if necessary, a leaf deletes emptied
+    // is passed over
+    while (scanMgmtInfo->elementIndex >= scanMgmtInfo->currentNode->vals->fill) {
+        if (scanMgmtInfo->currentNode->right == NULL) {
+            return RC_IM_NO_MORE_ENTRIES;
         }
+        scanMgmtInfo->currentNode = scanMgmtInfo->currentNode->right;
         scanMgmtInfo->elementIndex = 0;
     }
 
+    // A range scan ends at the first key past its upper bound
+    if (scanMgmtInfo->bounded &&
+        scanMgmtInfo->currentNode->vals->elems[scanMgmtInfo->elementIndex] > scanMgmtInfo->high) {
+        return RC_IM_NO_MORE_ENTRIES;
+    }
+
     // Update the result
     result->page = scanMgmtInfo->currentNode->leafRIDPages->elems[scanMgmtInfo->elementIndex];
     result->slot = scanMgmtInfo->currentNode->leafRIDSlots->elems[scanMgmtInfo->elementIndex];
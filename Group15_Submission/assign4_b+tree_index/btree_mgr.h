@@ -77,6 +77,8 @@ typedef struct BT_ScanHandle {
 typedef struct ScanMgmtInfo {
   BT_Node *currentNode;
   int elementIndex;
+  bool bounded; // the scan ends after the key high
+  int high;
 } ScanMgmtInfo;
 
 typedef struct NodeSplitConfig {
@@ -111,7 +113,13 @@ extern RC getKeyType (BTreeHandle *tree, DataType *result);
 extern RC findKey (BTreeHandle *tree, Value *key, RID *result);
 extern RC insertKey (BTreeHandle *tree, Value *key, RID rid);
 extern RC deleteKey (BTreeHandle *tree, Value *key);
+// entries of keys several records share: insertEntry adds a key with a RID even if the
+// key is in the tree already, the RID must not be, deleteEntry takes out the one with that RID
+extern RC insertEntry (BTreeHandle *tree, Value *key, RID rid);
+extern RC deleteEntry (BTreeHandle *tree, Value *key, RID rid);
 extern RC openTreeScan (BTreeHandle *tree, BT_ScanHandle **handle);
+// scan the entries with keys from low to high in key order, NULL for no bound
+extern RC openTreeRangeScan (BTreeHandle *tree, Value *low, Value *high, BT_ScanHandle **handle);
 extern RC nextEntry (BT_ScanHandle *handle, RID *result);
 extern RC closeTreeScan (BT_ScanHandle *handle);
 
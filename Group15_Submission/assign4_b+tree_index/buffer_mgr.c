@@ -1,8 +1,27 @@
 #include<stdio.h>
 #include<stdlib.h>
+// The pinPage of this file is the function, not the macro that records the call site
+#define BM_NO_PIN_SITES
 #include "buffer_mgr.h"
 #include "storage_mgr.h"
+#include "policy_sim.h"
 #include <math.h>
+#include <string.h>
+#include <time.h>
+#include <limits.h>
+
+// Sidecar file that keeps the resident page set of a pool for a warm restart
+#define WARM_FILE_SUFFIX ".warm"
+#define WARM_FILE_MAGIC 0x5741524d
+
+// Strategies an adaptive pool simulates and may switch between. Each is simulated
+// by a ghost list, which costs O(1) per pin, so LFU is not one of them.
+#define NUM_ADAPTIVE_STRATEGIES 3
+static const ReplacementStrategy adaptiveStrategies[NUM_ADAPTIVE_STRATEGIES] = {
+	RS_FIFO, RS_LRU, RS_CLOCK
+};
+
+struct BufferPoolMgmt;
 
 // This structure represents one page frame in buffer pool (memory).
 typedef struct Page
@@ -11,75 +30,610 @@ typedef struct Page
 	PageNumber pageNum; // An identification integer given to each page
 	int dirtyBit; // Used to indicate whether the contents of the page has been modified by the client
 	int fixCount; // Used to indicate the number of clients using that page at a given instance
-	int hitNum;   // Used by LRU algorithm to get the least recently used page	
+	int hitNum;   // Used by LRU algorithm to get the least recently used page
+	int lastHit;  // Access counter at the latest pin, so LRU can take over from another strategy
+	int loadedAt; // Read counter when the page was read, used by FIFO to find the oldest page
 	int refNum;   // Used by LFU algorithm to get the least frequently used page
+	long long pinStartNs; // When the first client pinned the page, used for pin duration statistics
+	int pinCount; // Number of times the page was pinned since it was read, saved as its heat on a warm restart
+	struct BufferPoolMgmt *owner; // Page file (attached pool) the page belongs to, NULL if the frame is empty
+	struct PinSite *pinSites; // Where the pins still held were taken, if its file tracks pins
+	int numPinSites;
+	int pinSiteCapacity;
 } PageFrame;
 
-int bufferSize = 0;
-int rearIndex = 0;
-int writeCount = 0;
-int hit = 0;
-int clockPointer = 0;
-int lfuPointer = 0;
+// Where a client pinned a page, kept for each pin until it is given back
+typedef struct PinSite
+{
+	BM_PinSite site;
+	const BM_PageHandle *handle; // Handle the page was pinned through, unpinPage looks for it
+} PinSite;
+
+// Compressed copy of a clean page that was evicted from the frames
+typedef struct TierPage
+{
+	int fileId;
+	PageNumber pageNum;
+	char *data;             // Page encoded by compressPage
+	int size;               // Encoded size in bytes
+	struct TierPage *chain; // Next page in the same hash bucket
+	struct TierPage *older, *newer; // Neighbours in the order the pages were stored
+} TierPage;
+
+// Second tier of a pool, a bounded amount of memory for compressed pages
+typedef struct CompressedTier
+{
+	TierPage **buckets; // (fileId, pageNum) hashed to the first page of a chain
+	int numBuckets;     // Power of two
+	TierPage *oldest, *newest;
+	long usedBytes;     // Encoded bytes held right now
+	long maxBytes;      // Encoded bytes the tier may hold
+} CompressedTier;
+
+// Ids of the pages a candidate strategy would keep in a pool of the same size.
+// It holds no page data, a slot is a page id and the links the strategy needs.
+typedef struct GhostList
+{
+	ReplacementStrategy strategy;
+	long long *keys;   // PS_KEY of the page in each slot
+	int *chain;        // Next slot in the same hash bucket
+	int *older, *newer; // Neighbours in FIFO or LRU order
+	char *referenced;  // Second chance bits of CLOCK
+	int *buckets;      // Page id hashed to the first slot of a chain
+	int numBuckets;    // Power of two, at least twice the number of slots
+	int capacity;      // Number of slots, the size of the pool
+	int used;          // Slots filled so far, they fill up in order
+	int oldest, newest; // Ends of the FIFO or LRU order
+	int hand;          // Clock hand
+	long hits;         // Pins the strategy would have served from the pool
+} GhostList;
+
+// Bookkeeping for the page frames, stored in BM_SharedPool->mgmtData.
+// A private pool created by initBufferPool has one of these all to itself.
+typedef struct SharedPoolMgmt
+{
+	PageFrame *frames; // The page frames of this pool
+	int bufferSize;    // Number of page frames in the pool
+	int freeFrames;    // Number of frames that do not hold a page
+	ReplacementStrategy strategy; // Strategy used to find a victim among all the frames
+	int numReads;      // Number of pages read into the pool, stamps the order they came in
+	int hit;           // Access counter, used by LRU to timestamp page frames
+	int clockPointer;  // Clock hand of the CLOCK algorithm
+	int lfuPointer;    // Frame where LFU starts looking for a victim
+	int *buckets;      // Page table, (fileId, pageNum) hashed to the first frame of a chain
+	int *nextInBucket; // Next frame in the same chain, one entry per frame
+	int numBuckets;    // Power of two, at least twice the number of frames
+	int numAttached;   // Number of page files attached to the pool
+	int nextFileId;    // Id handed to the next page file that attaches
+	bool privatePool;  // Created by initBufferPool and freed by shutdownBufferPool
+	int adaptiveWindow;   // Pins between two reviews of the strategy, 0 if it is fixed
+	GhostList *ghosts;    // Simulation of each adaptive strategy at the size of the pool
+	long *windowStartHits; // Simulated hits of each strategy when the current window started
+	int windowPins;       // Pins seen in the current window
+	int leader;           // Strategy that beat the active one in the last window, -1 if none
+	int leaderWindows;    // Windows in a row the leader did so
+	long policySwitches;  // Number of times the strategy was changed
+	int lastPlaced;       // Frame the latest page was placed in
+	CompressedTier *tier; // Compressed copies of evicted clean pages, NULL if there is no tier
+	int reservedFrames;   // Sum of the minimum frames reserved by the attached files
+	int reservedFree;     // Reserved frames their files do not use yet, kept free for them
+	int victimPriority;   // Highest priority whose pages the current victim search may replace
+} SharedPoolMgmt;
+
+// Bookkeeping for one page file using a pool, stored in BM_BufferPool->mgmtData
+typedef struct BufferPoolMgmt
+{
+	SharedPoolMgmt *pool; // The frames this page file is cached in
+	char *pageFile;    // Page file the cached pages are read from and written to
+	int fileId;        // Identifies the pages of this file in the page table
+	int maxFrames;     // Most frames the pages of this file may take up, 0 for the whole pool
+	int usedFrames;    // Frames holding a page of this file right now
+	int readCount;     // Number of pages read from disk
+	int writeCount;    // Number of pages written back to disk
+	BM_PoolOptions options; // Optional behaviour asked for when the pool was set up
+	BM_TraceEvent *trace;   // Ring buffer of the last options.traceEvents page accesses
+	long traceNext;         // Number of accesses recorded so far, the next one goes to traceNext % traceEvents
+	BM_PoolStats stats;    // Counters reported by getPoolStats
+	long long totalPinNs;  // Sum of the pin durations counted in stats.completedPins
+} BufferPoolMgmt;
+
+// Bookkeeping for an access ring, stored in BM_AccessRing->mgmtData
+typedef struct AccessRingMgmt
+{
+	int *frames;        // Frame each slot of the ring read its latest page into, -1 if none
+	PageNumber *pages;  // Page the ring read into that frame
+	BufferPoolMgmt *user; // Attached pool the ring reads pages for
+	int numFrames;      // Number of slots
+	int next;           // Slot used by the next miss
+} AccessRingMgmt;
+
+static long long currentTimeNs(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (long long)now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+// Account for a frame whose fixCount just went from 0 to 1
+static void notePinned(BufferPoolMgmt *mgmt, PageFrame *frame)
+{
+	frame->pinStartNs = currentTimeNs();
+	mgmt->stats.pinnedFrames++;
+	if (mgmt->stats.pinnedFrames > mgmt->stats.pinnedHighWater)
+		mgmt->stats.pinnedHighWater = mgmt->stats.pinnedFrames;
+}
 
+// Account for a frame whose fixCount just went back to 0
+static void noteUnpinned(BufferPoolMgmt *mgmt, PageFrame *frame)
+{
+	mgmt->totalPinNs += currentTimeNs() - frame->pinStartNs;
+	mgmt->stats.completedPins++;
+	mgmt->stats.pinnedFrames--;
+}
 
-extern void FIFO(BM_BufferPool *const bm, PageFrame *page)
+// Record a page access in the trace ring buffer, if the pool keeps one
+static void traceEvent(BufferPoolMgmt *mgmt, PageNumber pageNum, BM_TraceEventType type)
 {
-    PageFrame *pageFrame = (PageFrame *)bm->mgmtData;
-    int frontIndex = rearIndex % bufferSize;
+	if (mgmt->trace == NULL)
+		return;
 
-    // Iterate through all page frames in the buffer pool
-    for (int i = 0; i < bufferSize; i++)
-    {
-        if (pageFrame[frontIndex].fixCount == 0)
-        {
-            // If the page in memory has been modified, write it to disk
-            if (pageFrame[frontIndex].dirtyBit == 1)
-            {
-                SM_FileHandle fh;
-                openPageFile(bm->pageFile, &fh);
-                writeBlock(pageFrame[frontIndex].pageNum, &fh, pageFrame[frontIndex].data);
-                writeCount++; // Increment write count
-            }
+	BM_TraceEvent *event = &mgmt->trace[mgmt->traceNext++ % mgmt->options.traceEvents];
+	event->pageNum = pageNum;
+	event->fileId = (short)mgmt->fileId;
+	event->type = (short)type;
+}
 
-            // Replace the page frame's content with the new page's content
-            pageFrame[frontIndex].data = page->data;
-            pageFrame[frontIndex].pageNum = page->pageNum;
-            pageFrame[frontIndex].dirtyBit = page->dirtyBit;
-            pageFrame[frontIndex].fixCount = page->fixCount;
-            break;
-        }
-        else
+// Remember where a pin of the page in a frame was taken, the pin holds without it if
+// there is no memory for it
+static void addPinSite(PageFrame *frame, const BM_PageHandle *handle, const char *file, int line)
+{
+	if (frame->numPinSites == frame->pinSiteCapacity)
+	{
+		int capacity = (frame->pinSiteCapacity > 0) ? 2 * frame->pinSiteCapacity : 4;
+		PinSite *sites = realloc(frame->pinSites, sizeof(PinSite) * capacity);
+		if (sites == NULL)
+			return;
+		frame->pinSites = sites;
+		frame->pinSiteCapacity = capacity;
+	}
+	PinSite *pin = &frame->pinSites[frame->numPinSites++];
+	pin->site.file = file;
+	pin->site.line = line;
+	pin->handle = handle;
+}
+
+// Forget the site of the pin an unpin gave back: the latest one taken through the same
+// handle, or else the latest one if the frame has more sites than pins left. A pin
+// taken without a site takes none with it.
+static void dropPinSite(PageFrame *frame, const BM_PageHandle *handle)
+{
+	int index = -1;
+	for (int i = frame->numPinSites - 1; i >= 0 && index == -1; i--)
+	{
+		if (frame->pinSites[i].handle == handle)
+			index = i;
+	}
+	if (index == -1)
+	{
+		if (frame->numPinSites <= frame->fixCount)
+			return;
+		index = frame->numPinSites - 1;
+	}
+	memmove(&frame->pinSites[index], &frame->pinSites[index + 1],
+			sizeof(PinSite) * (frame->numPinSites - index - 1));
+	frame->numPinSites--;
+}
+
+// Print the pinned pages of mgmt, or of every file in the pool, and where each pin was taken
+static void reportPinnedPages(BufferPoolMgmt *mgmt, const char *context, bool allFiles)
+{
+	SharedPoolMgmt *pool = mgmt->pool;
+
+	for (int i = 0; i < pool->bufferSize; i++)
+	{
+		PageFrame *frame = &pool->frames[i];
+		if (frame->owner == NULL || frame->fixCount == 0 || (!allFiles && frame->owner != mgmt))
+			continue;
+		fprintf(stderr, "%s: page %d of %s pinned %d time(s)\n", context,
+				frame->pageNum, frame->owner->pageFile, frame->fixCount);
+		// Pins taken without a call site, through the functions, show up as ?
+		for (int k = 0; k < frame->fixCount; k++)
+		{
+			if (k < frame->numPinSites)
+				fprintf(stderr, "  pinned at %s:%d\n", frame->pinSites[k].site.file, frame->pinSites[k].site.line);
+			else
+				fprintf(stderr, "  pinned at ?\n");
+		}
+	}
+}
+
+bool isPageFrameEmpty(const PageFrame *frame){
+		return frame->pageNum == -1;
+	}
+
+static unsigned int hashPage(int fileId, PageNumber pageNum)
+{
+	unsigned int h = (unsigned int)fileId * 2654435761u ^ (unsigned int)pageNum * 40503u;
+	return h ^ (h >> 15);
+}
+
+static int pageTableBucket(SharedPoolMgmt *pool, int fileId, PageNumber pageNum)
+{
+	return (int)(hashPage(fileId, pageNum) & (unsigned int)(pool->numBuckets - 1));
+}
+
+// Returns the frame holding the page of the given file, or -1 if it is not cached
+static int findFrame(BufferPoolMgmt *mgmt, PageNumber pageNum)
+{
+	SharedPoolMgmt *pool = mgmt->pool;
+	int index = pool->buckets[pageTableBucket(pool, mgmt->fileId, pageNum)];
+
+	while (index != -1)
+	{
+		mgmt->stats.lookupScanSteps++;
+		if (pool->frames[index].owner == mgmt && pool->frames[index].pageNum == pageNum)
+			return index;
+		index = pool->nextInBucket[index];
+	}
+	return -1;
+}
+
+// Store the page in the given (empty) frame and make it findable through the page table
+static void placePage(SharedPoolMgmt *pool, int index, PageFrame *page)
+{
+	int bucket = pageTableBucket(pool, page->owner->fileId, page->pageNum);
+
+	pool->frames[index] = *page;
+	pool->nextInBucket[index] = pool->buckets[bucket];
+	pool->buckets[bucket] = index;
+	pool->freeFrames--;
+	pool->lastPlaced = index;
+	if (page->owner->usedFrames++ < page->owner->options.minFrames)
+		pool->reservedFree--;
+}
+
+// Release the page held in the given frame, its owner must have written it back already
+static void releaseFrame(SharedPoolMgmt *pool, int index)
+{
+	PageFrame *frame = &pool->frames[index];
+	int *link = &pool->buckets[pageTableBucket(pool, frame->owner->fileId, frame->pageNum)];
+
+	// Unlink the frame from its chain in the page table
+	while (*link != index)
+		link = &pool->nextInBucket[*link];
+	*link = pool->nextInBucket[index];
+	pool->nextInBucket[index] = -1;
+
+	if (--frame->owner->usedFrames < frame->owner->options.minFrames)
+		pool->reservedFree++;
+	free(frame->data);
+	frame->data = NULL;
+	frame->pageNum = NO_PAGE;
+	frame->dirtyBit = 0;
+	frame->fixCount = 0;
+	frame->hitNum = 0;
+	frame->refNum = 0;
+	frame->pinCount = 0;
+	frame->owner = NULL;
+	free(frame->pinSites);
+	frame->pinSites = NULL;
+	frame->numPinSites = 0;
+	frame->pinSiteCapacity = 0;
+	pool->freeFrames++;
+}
+
+// Zero-run-length encoding of a page into out (PAGE_SIZE bytes). A control byte
+// below 128 is followed by that many plus one literal bytes, a control byte of
+// 128 or more stands for that many minus 127 zero bytes. Returns the encoded size,
+// or 0 if the page does not get smaller.
+static int compressPage(const char *page, char *out)
+{
+	int in = 0, pos = 0;
+
+	while (in < PAGE_SIZE)
+	{
+		int zeros = 0;
+		while (in + zeros < PAGE_SIZE && zeros < 128 && page[in + zeros] == 0)
+			zeros++;
+
+		// Two zeros or more are worth a control byte of their own
+		if (zeros >= 2)
+		{
+			if (pos + 1 >= PAGE_SIZE)
+				return 0;
+			out[pos++] = (char)(127 + zeros);
+			in += zeros;
+			continue;
+		}
+
+		// Copy the bytes up to the next two zeros
+		int len = 1;
+		while (in + len < PAGE_SIZE && len < 128 &&
+		       !(page[in + len] == 0 && in + len + 1 < PAGE_SIZE && page[in + len + 1] == 0))
+			len++;
+		if (pos + 1 + len >= PAGE_SIZE)
+			return 0;
+		out[pos++] = (char)(len - 1);
+		memcpy(out + pos, page + in, len);
+		pos += len;
+		in += len;
+	}
+	return pos;
+}
+
+static void decompressPage(const char *in, int size, char *page)
+{
+	int pos = 0, out = 0;
+
+	while (pos < size)
+	{
+		unsigned char control = (unsigned char)in[pos++];
+		if (control >= 128)
+		{
+			memset(page + out, 0, control - 127);
+			out += control - 127;
+		}
+		else
+		{
+			memcpy(page + out, in + pos, control + 1);
+			out += control + 1;
+			pos += control + 1;
+		}
+	}
+}
+
+// Returns the link in the tier that points to the page, it points to NULL if the page is not there
+static TierPage **findTierLink(CompressedTier *tier, int fileId, PageNumber pageNum)
+{
+	TierPage **link = &tier->buckets[hashPage(fileId, pageNum) & (unsigned int)(tier->numBuckets - 1)];
+
+	while (*link != NULL && ((*link)->fileId != fileId || (*link)->pageNum != pageNum))
+		link = &(*link)->chain;
+	return link;
+}
+
+static void dropTierPage(CompressedTier *tier, TierPage **link)
+{
+	TierPage *entry = *link;
+
+	*link = entry->chain;
+	if (entry->older != NULL) entry->older->newer = entry->newer; else tier->oldest = entry->newer;
+	if (entry->newer != NULL) entry->newer->older = entry->older; else tier->newest = entry->older;
+	tier->usedBytes -= entry->size;
+	free(entry->data);
+	free(entry);
+}
+
+// Keep a compressed copy of a clean page that leaves the frames, making room
+// by dropping the pages stored first. Pages that do not compress are not kept.
+static void storeInTier(SharedPoolMgmt *pool, PageFrame *frame)
+{
+	CompressedTier *tier = pool->tier;
+	char encoded[PAGE_SIZE];
+
+	int size = compressPage(frame->data, encoded);
+	if (size == 0 || size > tier->maxBytes)
+		return;
+
+	TierPage *entry = malloc(sizeof(TierPage));
+	char *data = malloc(size);
+	if (entry == NULL || data == NULL)
+	{
+		free(entry);
+		free(data);
+		return;
+	}
+	while (tier->usedBytes + size > tier->maxBytes)
+		dropTierPage(tier, findTierLink(tier, tier->oldest->fileId, tier->oldest->pageNum));
+
+	memcpy(data, encoded, size);
+	entry->fileId = frame->owner->fileId;
+	entry->pageNum = frame->pageNum;
+	entry->data = data;
+	entry->size = size;
+	TierPage **link = findTierLink(tier, entry->fileId, entry->pageNum);
+	entry->chain = NULL;
+	*link = entry;
+	entry->older = tier->newest;
+	entry->newer = NULL;
+	if (tier->newest != NULL) tier->newest->newer = entry; else tier->oldest = entry;
+	tier->newest = entry;
+	tier->usedBytes += size;
+	frame->owner->stats.tierStores++;
+}
+
+// Decompress the page into data if the tier has it. The page leaves the tier,
+// it is going back into a frame.
+static bool takeFromTier(SharedPoolMgmt *pool, BufferPoolMgmt *mgmt, PageNumber pageNum, char *data)
+{
+	TierPage **link = findTierLink(pool->tier, mgmt->fileId, pageNum);
+
+	if (*link == NULL)
+		return false;
+	decompressPage((*link)->data, (*link)->size, data);
+	dropTierPage(pool->tier, link);
+	return true;
+}
+
+// Drop every page of a page file that detaches, the file may change before it comes back
+static void dropFileFromTier(CompressedTier *tier, int fileId)
+{
+	TierPage *entry = tier->oldest;
+
+	while (entry != NULL)
+	{
+		TierPage *newer = entry->newer;
+		if (entry->fileId == fileId)
+			dropTierPage(tier, findTierLink(tier, fileId, entry->pageNum));
+		entry = newer;
+	}
+}
+
+// Whether the page file may take one more frame
+static bool isWithinBudget(BufferPoolMgmt *mgmt)
+{
+	return mgmt->maxFrames == 0 || mgmt->usedFrames < mgmt->maxFrames;
+}
+
+// Number of empty frames the page file may take, leaving those reserved for other files
+static int freeFramesFor(BufferPoolMgmt *mgmt)
+{
+	SharedPoolMgmt *pool = mgmt->pool;
+	int ownReserved = mgmt->options.minFrames - mgmt->usedFrames;
+	int available = pool->freeFrames - pool->reservedFree + (ownReserved > 0 ? ownReserved : 0);
+
+	if (mgmt->maxFrames > 0 && mgmt->maxFrames - mgmt->usedFrames < available)
+		available = mgmt->maxFrames - mgmt->usedFrames;
+	return (available > 0) ? available : 0;
+}
+
+// Whether the page in the frame may be replaced by a page of mgmt. A page file that
+// used up its budget may only replace its own pages, and the pages another file holds
+// within its reserved minimum are off limits.
+static bool isEvictable(BufferPoolMgmt *mgmt, PageFrame *frame)
+{
+	if (frame->owner == NULL || frame->fixCount > 0)
+		return false;
+	if (frame->owner == mgmt)
+		return true;
+	return isWithinBudget(mgmt) && frame->owner->usedFrames > frame->owner->options.minFrames;
+}
+
+// Whether a replacement strategy may pick this frame as the victim for a page of mgmt.
+// Only pages of the lowest priority that can be replaced at all are candidates.
+static bool isVictimCandidate(BufferPoolMgmt *mgmt, PageFrame *frame)
+{
+	return isEvictable(mgmt, frame) && frame->owner->options.priority <= mgmt->pool->victimPriority;
+}
+
+// Lowest priority among the pages mgmt may replace, the bar for the next victim search
+static int lowestVictimPriority(BufferPoolMgmt *mgmt)
+{
+	SharedPoolMgmt *pool = mgmt->pool;
+	int lowest = INT_MAX;
+
+	for (int i = 0; i < pool->bufferSize; i++)
+	{
+		if (isEvictable(mgmt, &pool->frames[i]) && pool->frames[i].owner->options.priority < lowest)
+			lowest = pool->frames[i].owner->options.priority;
+	}
+	return lowest;
+}
+
+// Write the page in the frame back to the file it came from if it is dirty and release the frame.
+// A page that could not be written back stays in its frame, still dirty.
+static RC writeBackFrame(SharedPoolMgmt *pool, int index)
+{
+	PageFrame *victim = &pool->frames[index];
+
+	if (victim->dirtyBit == 1)
+	{
+		SM_FileHandle fh;
+		RC status = openPageFile(victim->owner->pageFile, &fh);
+		if (status == RC_OK)
+			status = writeBlock(victim->pageNum, &fh, victim->data);
+		if (status != RC_OK)
+			return status;
+		victim->owner->writeCount++;
+		victim->owner->stats.dirtyWriteBacks++;
+	}
+	else if (pool->tier != NULL)
+	{
+		storeInTier(pool, victim);
+	}
+	releaseFrame(pool, index);
+	return RC_OK;
+}
+
+// Write the victim chosen by a replacement strategy back to disk if it is dirty,
+// release its page memory and record the eviction and the frames scanned to find it
+static RC evictFrame(BufferPoolMgmt *mgmt, int index, int scanned)
+{
+	SharedPoolMgmt *pool = mgmt->pool;
+
+	// The victim may belong to another page file, so it is written to the file it came from
+	RC status = writeBackFrame(pool, index);
+	if (status != RC_OK)
+		return status;
+
+	mgmt->stats.evictions[pool->strategy]++;
+	mgmt->stats.victimScans++;
+	mgmt->stats.victimScanSteps += scanned;
+	if (scanned > mgmt->stats.maxVictimScan)
+		mgmt->stats.maxVictimScan = scanned;
+	return RC_OK;
+}
+
+
+extern RC FIFO(BM_BufferPool *const bm, PageFrame *page)
+{
+    BufferPoolMgmt *mgmt = (BufferPoolMgmt *)bm->mgmtData;
+    SharedPoolMgmt *pool = mgmt->pool;
+    PageFrame *pageFrame = pool->frames;
+    int frontIndex = -1;
+
+    // Find the page that was read first among the frames not in use. Frames do not
+    // fill up in order once pages are released or the pool is resized, so go by read order.
+    for (int i = 0; i < pool->bufferSize; i++)
+    {
+        if (isVictimCandidate(mgmt, &pageFrame[i]) &&
+            (frontIndex == -1 || pageFrame[i].loadedAt < pageFrame[frontIndex].loadedAt))
         {
-            // Move to the next location if the current page frame is in use
-            frontIndex = (frontIndex + 1) % bufferSize;
+            frontIndex = i;
         }
     }
+
+    // Every frame is pinned
+    if (frontIndex == -1)
+    {
+        return RC_NO_SPACE_IN_POOL;
+    }
+
+    // If the page in memory has been modified, write it to disk
+    RC status = evictFrame(mgmt, frontIndex, pool->bufferSize);
+    if (status != RC_OK)
+    {
+        return status;
+    }
+
+    // Replace the page frame's content with the new page's content
+    placePage(pool, frontIndex, page);
+    return RC_OK;
 }
 
-extern void LFU(BM_BufferPool *const bm, PageFrame *page)
+extern RC LFU(BM_BufferPool *const bm, PageFrame *page)
 {
-    PageFrame *pageFrame = (PageFrame *)bm->mgmtData;
-    int leastFreqIndex = lfuPointer;
-    int leastFreqRef;
+    BufferPoolMgmt *mgmt = (BufferPoolMgmt *)bm->mgmtData;
+    SharedPoolMgmt *pool = mgmt->pool;
+    PageFrame *pageFrame = pool->frames;
+    int leastFreqIndex = pool->lfuPointer;
+    int leastFreqRef = -1;
+    int scanned = pool->bufferSize;
 
     // Find the first unpinned page
-    for (int i = 0; i < bufferSize; i++)
+    for (int i = 0; i < pool->bufferSize; i++)
     {
-        int index = (leastFreqIndex + i) % bufferSize;
-        if (pageFrame[index].fixCount == 0)
+        int index = (leastFreqIndex + i) % pool->bufferSize;
+        if (isVictimCandidate(mgmt, &pageFrame[index]))
         {
+            scanned += i + 1;
             leastFreqIndex = index;
             leastFreqRef = pageFrame[index].refNum;
             break;
         }
     }
 
+    // Every frame is pinned
+    if (leastFreqRef == -1)
+    {
+        return RC_NO_SPACE_IN_POOL;
+    }
+
     // Find the least frequently used unpinned page
-    for (int i = 0; i < bufferSize; i++)
+    for (int i = 0; i < pool->bufferSize; i++)
     {
-        int index = (leastFreqIndex + i + 1) % bufferSize;
-        if (pageFrame[index].fixCount == 0 && pageFrame[index].refNum < leastFreqRef)
+        int index = (leastFreqIndex + i + 1) % pool->bufferSize;
+        if (isVictimCandidate(mgmt, &pageFrame[index]) && pageFrame[index].refNum < leastFreqRef)
         {
             leastFreqIndex = index;
             leastFreqRef = pageFrame[index].refNum;
@@ -87,210 +641,1042 @@ extern void LFU(BM_BufferPool *const bm, PageFrame *page)
     }
 
     // If the page in memory has been modified, write it to disk
-    if (pageFrame[leastFreqIndex].dirtyBit == 1)
+    RC status = evictFrame(mgmt, leastFreqIndex, scanned);
+    if (status != RC_OK)
     {
-        SM_FileHandle fh;
-        openPageFile(bm->pageFile, &fh);
-        writeBlock(pageFrame[leastFreqIndex].pageNum, &fh, pageFrame[leastFreqIndex].data);
-        writeCount++; // Increment write count
+        return status;
     }
 
     // Replace the page frame's content with the new page's content
-    pageFrame[leastFreqIndex].data = page->data;
-    pageFrame[leastFreqIndex].pageNum = page->pageNum;
-    pageFrame[leastFreqIndex].dirtyBit = page->dirtyBit;
-    pageFrame[leastFreqIndex].fixCount = page->fixCount;
-    lfuPointer = (leastFreqIndex + 1) % bufferSize;
+    placePage(pool, leastFreqIndex, page);
+    pool->lfuPointer = (leastFreqIndex + 1) % pool->bufferSize;
+    return RC_OK;
 }
 
-extern void LRU(BM_BufferPool *const bm, PageFrame *page) {
-    PageFrame *pageFrame = (PageFrame *)bm->mgmtData;
-    int leastHitIndex = 0, leastHitNum = 0;
+extern RC LRU(BM_BufferPool *const bm, PageFrame *page) {
+    BufferPoolMgmt *mgmt = (BufferPoolMgmt *)bm->mgmtData;
+    SharedPoolMgmt *pool = mgmt->pool;
+    PageFrame *pageFrame = pool->frames;
+    int leastHitIndex = -1, leastHitNum = 0;
+    int scanned = 0;
 
     // Find the first unused page frame
-    for (int i = 0; i < bufferSize; i++) {
-        if (pageFrame[i].fixCount == 0) {
+    for (int i = 0; i < pool->bufferSize; i++) {
+        if (isVictimCandidate(mgmt, &pageFrame[i])) {
+            scanned = i + 1;
             leastHitIndex = i;
             leastHitNum = pageFrame[i].hitNum;
             break;
         }
     }
 
+    // Every frame is pinned
+    if (leastHitIndex == -1) {
+        return RC_NO_SPACE_IN_POOL;
+    }
+
     // Find the least recently used page frame among unused frames
-    for (int i = leastHitIndex + 1; i < bufferSize; i++) {
-        if (pageFrame[i].fixCount == 0 && pageFrame[i].hitNum < leastHitNum) {
+    scanned += pool->bufferSize - leastHitIndex - 1;
+    for (int i = leastHitIndex + 1; i < pool->bufferSize; i++) {
+        if (isVictimCandidate(mgmt, &pageFrame[i]) && pageFrame[i].hitNum < leastHitNum) {
             leastHitIndex = i;
             leastHitNum = pageFrame[i].hitNum;
         }
     }
 
     // Write dirty page to disk if necessary
-    if (pageFrame[leastHitIndex].dirtyBit) {
-        SM_FileHandle fh;
-        openPageFile(bm->pageFile, &fh);
-        writeBlock(pageFrame[leastHitIndex].pageNum, &fh, pageFrame[leastHitIndex].data);
-        writeCount++;
+    RC status = evictFrame(mgmt, leastHitIndex, scanned);
+    if (status != RC_OK) {
+        return status;
     }
 
     // Replace the page frame with new content
-    pageFrame[leastHitIndex] = *page;
+    placePage(pool, leastHitIndex, page);
+    return RC_OK;
 }
 
-extern void CLOCK(BM_BufferPool *const bm, PageFrame *page) {
-    PageFrame *pageFrame = (PageFrame *)bm->mgmtData;
+extern RC CLOCK(BM_BufferPool *const bm, PageFrame *page) {
+    BufferPoolMgmt *mgmt = (BufferPoolMgmt *)bm->mgmtData;
+    SharedPoolMgmt *pool = mgmt->pool;
+    PageFrame *pageFrame = pool->frames;
+    int scanned = 0;
+
+    // Two full rounds clear every reference bit, so stop if no frame was free by then
+    while (scanned < 2 * pool->bufferSize) {
+        scanned++;
 
-    while (true) {
         // Reset clock pointer if it completes a full round
-        if (clockPointer % bufferSize == 0) {
-            clockPointer = 0;
-        }
+        pool->clockPointer %= pool->bufferSize;
 
+        // Frames in use by a client (or out of this file's reach) are never replaced
+        if (!isVictimCandidate(mgmt, &pageFrame[pool->clockPointer])) {
+            pool->clockPointer++;
+        }
         // If the current frame is not recently used, replace it
-        if (pageFrame[clockPointer].hitNum == 0) {
+        else if (pageFrame[pool->clockPointer].hitNum == 0) {
             // Write to disk if the page is dirty
-            if (pageFrame[clockPointer].dirtyBit) {
-                SM_FileHandle fh;
-                openPageFile(bm->pageFile, &fh);
-                writeBlock(pageFrame[clockPointer].pageNum, &fh, pageFrame[clockPointer].data);
-                writeCount++;
+            RC status = evictFrame(mgmt, pool->clockPointer, scanned);
+            if (status != RC_OK) {
+                return status;
             }
 
             // Replace the page frame with new content
-            pageFrame[clockPointer] = *page;
+            placePage(pool, pool->clockPointer, page);
 
             // Move the clock hand
-            clockPointer++;
-            break;
+            pool->clockPointer++;
+            return RC_OK;
         } else {
             // Give the page a second chance and move to the next frame
-            pageFrame[clockPointer].hitNum = 0;
-            clockPointer++;
+            pageFrame[pool->clockPointer].hitNum = 0;
+            pool->clockPointer++;
         }
     }
+
+    // Every frame is pinned
+    return RC_NO_SPACE_IN_POOL;
 }
 
-extern RC initBufferPool(BM_BufferPool *const bm, const char *const pageFileName, 
-                         const int numPages, ReplacementStrategy strategy,
-                         void *stratData)
+// A resident page and how often it was pinned, as kept in the warm restart file
+typedef struct WarmPage
 {
-    // Initialize buffer pool properties
-    bm->strategy = strategy;
-    bm->numPages = numPages;
-    bm->pageFile = (char *)pageFileName;
+	PageNumber pageNum;
+	int heat;
+} WarmPage;
+
+static int compareWarmPagesByHeat(const void *a, const void *b) {
+    const WarmPage *left = (const WarmPage *)a;
+    const WarmPage *right = (const WarmPage *)b;
+    return (left->heat < right->heat) - (left->heat > right->heat);
+}
+
+static int compareWarmPagesByPage(const void *a, const void *b) {
+    const WarmPage *left = (const WarmPage *)a;
+    const WarmPage *right = (const WarmPage *)b;
+    return (left->pageNum > right->pageNum) - (left->pageNum < right->pageNum);
+}
+
+static char *warmFileName(const char *pageFile) {
+    char *fileName = malloc(strlen(pageFile) + strlen(WARM_FILE_SUFFIX) + 1);
+    if (fileName != NULL) {
+        strcpy(fileName, pageFile);
+        strcat(fileName, WARM_FILE_SUFFIX);
+    }
+    return fileName;
+}
+
+// Write the pages this file has in the pool, with their heat, to the warm restart file
+static RC saveResidentPages(BufferPoolMgmt *mgmt) {
+    SharedPoolMgmt *pool = mgmt->pool;
+    int header[2] = { WARM_FILE_MAGIC, 0 };
+
+    WarmPage *warmPages = malloc(sizeof(WarmPage) * pool->bufferSize);
+    char *fileName = warmFileName(mgmt->pageFile);
+    char *tmpName = malloc(strlen(mgmt->pageFile) + strlen(WARM_FILE_SUFFIX) + 5);
+    if (warmPages == NULL || fileName == NULL || tmpName == NULL) {
+        free(warmPages);
+        free(fileName);
+        free(tmpName);
+        return RC_ERROR;
+    }
+    for (int i = 0; i < pool->bufferSize; i++) {
+        if (pool->frames[i].owner == mgmt) {
+            warmPages[header[1]].pageNum = pool->frames[i].pageNum;
+            warmPages[header[1]].heat = pool->frames[i].pinCount;
+            header[1]++;
+        }
+    }
+
+    // Write a temporary file first so a crash never leaves half a page list behind
+    sprintf(tmpName, "%s.tmp", fileName);
+    RC status = RC_WRITE_FAILED;
+    FILE *warmFile = fopen(tmpName, "wb");
+    if (warmFile != NULL) {
+        if (fwrite(header, sizeof(int), 2, warmFile) == 2 &&
+            fwrite(warmPages, sizeof(WarmPage), header[1], warmFile) == (size_t)header[1]) {
+            status = RC_OK;
+        }
+        if (fclose(warmFile) != 0) {
+            status = RC_WRITE_FAILED;
+        }
+        if (status == RC_OK && rename(tmpName, fileName) != 0) {
+            status = RC_WRITE_FAILED;
+        }
+        if (status != RC_OK) {
+            remove(tmpName);
+        }
+    }
+
+    free(warmPages);
+    free(fileName);
+    free(tmpName);
+    return status;
+}
+
+// Read the hottest pages listed in the warm restart file back into free frames.
+// They are read in page order with vectored reads; a missing or stale file just
+// leaves the pool cold.
+static void loadResidentPages(BufferPoolMgmt *mgmt) {
+    SharedPoolMgmt *pool = mgmt->pool;
+    int header[2];
+    WarmPage *warmPages = NULL;
+    WarmPage *byPage = NULL;
+    int *pageNums = NULL;
+    SM_PageHandle *pageData = NULL;
+    int numPages = 0;
+
+    char *fileName = warmFileName(mgmt->pageFile);
+    FILE *warmFile = (fileName != NULL) ? fopen(fileName, "rb") : NULL;
+    free(fileName);
+    if (warmFile == NULL) {
+        return;
+    }
+    if (fread(header, sizeof(int), 2, warmFile) != 2 || header[0] != WARM_FILE_MAGIC ||
+        header[1] <= 0 || header[1] > (1 << 24)) {
+        fclose(warmFile);
+        return;
+    }
+    warmPages = malloc(sizeof(WarmPage) * header[1]);
+    if (warmPages == NULL || fread(warmPages, sizeof(WarmPage), header[1], warmFile) != (size_t)header[1]) {
+        free(warmPages);
+        fclose(warmFile);
+        return;
+    }
+    fclose(warmFile);
+
+    // Keep the hottest pages that still exist and fit in the frames this file may use
+    SM_FileHandle fh;
+    if (openPageFile(mgmt->pageFile, &fh) != RC_OK) {
+        free(warmPages);
+        return;
+    }
+    int room = freeFramesFor(mgmt);
+    qsort(warmPages, header[1], sizeof(WarmPage), compareWarmPagesByHeat);
+    for (int i = 0; i < header[1] && numPages < room; i++) {
+        if (warmPages[i].pageNum >= 0 && warmPages[i].pageNum < fh.totalNumPages) {
+            warmPages[numPages++] = warmPages[i];
+        }
+    }
+    if (numPages == 0) {
+        free(warmPages);
+        return;
+    }
+
+    // Read the pages in page order
+    byPage = malloc(sizeof(WarmPage) * numPages);
+    pageNums = malloc(sizeof(int) * numPages);
+    pageData = calloc(numPages, sizeof(SM_PageHandle));
+    bool allocated = (byPage != NULL && pageNums != NULL && pageData != NULL);
+    if (allocated) {
+        memcpy(byPage, warmPages, sizeof(WarmPage) * numPages);
+        qsort(byPage, numPages, sizeof(WarmPage), compareWarmPagesByPage);
+    }
+    for (int i = 0; allocated && i < numPages; i++) {
+        pageNums[i] = byPage[i].pageNum;
+        pageData[i] = malloc(PAGE_SIZE);
+        allocated = (pageData[i] != NULL);
+    }
+
+    // Place them coldest first, so LRU sees the hottest page as the most recently used
+    if (allocated && readBlocks(numPages, pageNums, &fh, pageData) == RC_OK) {
+        int j = 0;
+        for (int i = numPages - 1; i >= 0; i--) {
+            WarmPage *read = bsearch(&warmPages[i], byPage, numPages, sizeof(WarmPage), compareWarmPagesByPage);
+            int k = (int)(read - byPage);
+            PageFrame page;
+            memset(&page, 0, sizeof(PageFrame));
+            page.data = pageData[k];
+            page.pageNum = pageNums[k];
+            page.pinCount = warmPages[i].heat;
+            page.refNum = page.pinCount;
+            page.lastHit = ++pool->hit;
+            page.loadedAt = ++pool->numReads;
+            page.hitNum = (pool->strategy == RS_CLOCK) ? 1 : page.lastHit;
+            page.owner = mgmt;
+
+            while (!isPageFrameEmpty(&pool->frames[j])) {
+                j++;
+            }
+            placePage(pool, j, &page);
+            pageData[k] = NULL;
+        }
+        mgmt->readCount += numPages;
+    }
+
+    for (int i = 0; pageData != NULL && i < numPages; i++) {
+        free(pageData[i]);
+    }
+    free(pageData);
+    free(pageNums);
+    free(byPage);
+    free(warmPages);
+}
+
+// Switch the pool to another strategy, carrying over what the frames already
+// tell about recency and frequency
+static void switchStrategy(SharedPoolMgmt *pool, ReplacementStrategy strategy)
+{
+    for (int i = 0; i < pool->bufferSize; i++) {
+        if (strategy == RS_CLOCK)
+            pool->frames[i].hitNum = 1;
+        else if (strategy == RS_LRU)
+            pool->frames[i].hitNum = pool->frames[i].lastHit;
+    }
+    pool->strategy = strategy;
+    pool->clockPointer = 0;
+    pool->lfuPointer = 0;
+    pool->policySwitches++;
+}
+
+static void freeGhostList(GhostList *ghost)
+{
+    free(ghost->keys);
+    free(ghost->chain);
+    free(ghost->older);
+    free(ghost->newer);
+    free(ghost->referenced);
+    free(ghost->buckets);
+    memset(ghost, 0, sizeof(GhostList));
+}
+
+static RC initGhostList(GhostList *ghost, int capacity, ReplacementStrategy strategy)
+{
+    int numBuckets = 1;
+    while (numBuckets < 2 * capacity) {
+        numBuckets <<= 1;
+    }
+
+    memset(ghost, 0, sizeof(GhostList));
+    ghost->keys = malloc(sizeof(long long) * capacity);
+    ghost->chain = malloc(sizeof(int) * capacity);
+    ghost->older = malloc(sizeof(int) * capacity);
+    ghost->newer = malloc(sizeof(int) * capacity);
+    ghost->referenced = calloc(capacity, sizeof(char));
+    ghost->buckets = malloc(sizeof(int) * numBuckets);
+    if (ghost->keys == NULL || ghost->chain == NULL || ghost->older == NULL ||
+        ghost->newer == NULL || ghost->referenced == NULL || ghost->buckets == NULL) {
+        freeGhostList(ghost);
+        return RC_ERROR;
+    }
+    for (int i = 0; i < numBuckets; i++) {
+        ghost->buckets[i] = -1;
+    }
+    ghost->strategy = strategy;
+    ghost->numBuckets = numBuckets;
+    ghost->capacity = capacity;
+    ghost->oldest = ghost->newest = -1;
+    return RC_OK;
+}
+
+static int ghostBucket(GhostList *ghost, long long key)
+{
+    return (int)(hashPage((int)(key >> 32), (PageNumber)key) & (unsigned int)(ghost->numBuckets - 1));
+}
+
+static void unlinkGhost(GhostList *ghost, int slot)
+{
+    if (ghost->older[slot] != -1) ghost->newer[ghost->older[slot]] = ghost->newer[slot]; else ghost->oldest = ghost->newer[slot];
+    if (ghost->newer[slot] != -1) ghost->older[ghost->newer[slot]] = ghost->older[slot]; else ghost->newest = ghost->older[slot];
+}
+
+static void appendGhost(GhostList *ghost, int slot)
+{
+    ghost->older[slot] = ghost->newest;
+    ghost->newer[slot] = -1;
+    if (ghost->newest != -1) ghost->newer[ghost->newest] = slot; else ghost->oldest = slot;
+    ghost->newest = slot;
+}
+
+// Replay a pin on the ghost list, a hit if the strategy would still hold the page
+static void ghostAccess(GhostList *ghost, long long key)
+{
+    int bucket = ghostBucket(ghost, key);
+    int slot = ghost->buckets[bucket];
+
+    while (slot != -1 && ghost->keys[slot] != key) {
+        slot = ghost->chain[slot];
+    }
+    if (slot != -1) {
+        ghost->hits++;
+        ghost->referenced[slot] = 1;
+        // LRU moves the page to the recent end, FIFO and CLOCK leave it where it is
+        if (ghost->strategy == RS_LRU) {
+            unlinkGhost(ghost, slot);
+            appendGhost(ghost, slot);
+        }
+        return;
+    }
+
+    // Miss: take the next unused slot, or the one of the page the strategy replaces
+    if (ghost->used < ghost->capacity) {
+        slot = ghost->used++;
+    } else {
+        if (ghost->strategy == RS_CLOCK) {
+            while (ghost->referenced[ghost->hand]) {
+                ghost->referenced[ghost->hand] = 0;
+                ghost->hand = (ghost->hand + 1) % ghost->capacity;
+            }
+            slot = ghost->hand;
+            ghost->hand = (ghost->hand + 1) % ghost->capacity;
+        } else {
+            slot = ghost->oldest;
+            unlinkGhost(ghost, slot);
+        }
+        int *link = &ghost->buckets[ghostBucket(ghost, ghost->keys[slot])];
+        while (*link != slot) {
+            link = &ghost->chain[*link];
+        }
+        *link = ghost->chain[slot];
+    }
+
+    ghost->keys[slot] = key;
+    ghost->chain[slot] = ghost->buckets[bucket];
+    ghost->buckets[bucket] = slot;
+    ghost->referenced[slot] = 1;
+    if (ghost->strategy != RS_CLOCK) {
+        appendGhost(ghost, slot);
+    }
+}
+
+// Feed a pin to the ghost lists and, at the end of a window, switch to the
+// strategy that would have had the most hits if it did so in two windows in a row
+static void reviewStrategy(SharedPoolMgmt *pool, long long key)
+{
+    long windowHits[NUM_ADAPTIVE_STRATEGIES];
+    int active = -1, best = 0;
 
-    // Allocate memory for page frames
+    for (int s = 0; s < NUM_ADAPTIVE_STRATEGIES; s++) {
+        ghostAccess(&pool->ghosts[s], key);
+    }
+    if (++pool->windowPins < pool->adaptiveWindow) {
+        return;
+    }
+    pool->windowPins = 0;
+
+    for (int s = 0; s < NUM_ADAPTIVE_STRATEGIES; s++) {
+        windowHits[s] = pool->ghosts[s].hits - pool->windowStartHits[s];
+        pool->windowStartHits[s] = pool->ghosts[s].hits;
+        if (adaptiveStrategies[s] == pool->strategy)
+            active = s;
+        if (windowHits[s] > windowHits[best])
+            best = s;
+    }
+
+    // Small differences are noise, the candidate has to win by 1% of the window
+    long activeHits = (active == -1) ? -1 : windowHits[active];
+    if (best == active || windowHits[best] <= activeHits + pool->adaptiveWindow / 100) {
+        pool->leader = -1;
+        pool->leaderWindows = 0;
+        return;
+    }
+    pool->leaderWindows = (best == pool->leader) ? pool->leaderWindows + 1 : 1;
+    pool->leader = best;
+    if (pool->leaderWindows >= 2) {
+        switchStrategy(pool, adaptiveStrategies[best]);
+        pool->leader = -1;
+        pool->leaderWindows = 0;
+    }
+}
+
+extern RC initSharedPool(BM_SharedPool *const sp, const int numPages,
+                         ReplacementStrategy strategy, void *stratData)
+{
+    return initSharedPoolWithOptions(sp, numPages, strategy, stratData, NULL);
+}
+
+extern RC initSharedPoolWithOptions(BM_SharedPool *const sp, const int numPages,
+                                    ReplacementStrategy strategy, void *stratData,
+                                    const BM_PoolOptions *options)
+{
+    if (sp == NULL || numPages <= 0) {
+        return RC_ERROR;
+    }
+
+    // Allocate memory for the pool bookkeeping, the page frames and the page table
+    int numBuckets = 1;
+    while (numBuckets < 2 * numPages) {
+        numBuckets <<= 1;
+    }
+    SharedPoolMgmt *pool = malloc(sizeof(SharedPoolMgmt));
     PageFrame *pageFrames = malloc(sizeof(PageFrame) * numPages);
-    if (pageFrames == NULL) {
+    int *buckets = malloc(sizeof(int) * numBuckets);
+    int *nextInBucket = malloc(sizeof(int) * numPages);
+    if (pool == NULL || pageFrames == NULL || buckets == NULL || nextInBucket == NULL) {
+        free(pool);
+        free(pageFrames);
+        free(buckets);
+        free(nextInBucket);
         return RC_ERROR;
     }
+    memset(pool, 0, sizeof(SharedPoolMgmt));
 
-    // Set global buffer size
-    bufferSize = numPages;
+    pool->frames = pageFrames;
+    pool->bufferSize = numPages;
+    pool->freeFrames = numPages;
+    pool->strategy = strategy;
+    pool->buckets = buckets;
+    pool->nextInBucket = nextInBucket;
+    pool->numBuckets = numBuckets;
 
     // Initialize each page frame
-    for (int i = 0; i < bufferSize; i++) {
+    for (int i = 0; i < pool->bufferSize; i++) {
         pageFrames[i].data = NULL;
         pageFrames[i].pageNum = -1;
         pageFrames[i].dirtyBit = 0;
         pageFrames[i].fixCount = 0;
         pageFrames[i].hitNum = 0;
         pageFrames[i].refNum = 0;
+        pageFrames[i].pinStartNs = 0;
+        pageFrames[i].pinCount = 0;
+        pageFrames[i].lastHit = 0;
+        pageFrames[i].loadedAt = 0;
+        pageFrames[i].owner = NULL;
+        pageFrames[i].pinSites = NULL;
+        pageFrames[i].numPinSites = 0;
+        pageFrames[i].pinSiteCapacity = 0;
+        nextInBucket[i] = -1;
+    }
+    for (int i = 0; i < numBuckets; i++) {
+        buckets[i] = -1;
+    }
+
+    // An adaptive pool simulates every strategy it may switch to at its own size
+    pool->leader = -1;
+    if (options != NULL && options->adaptiveWindow > 0) {
+        pool->ghosts = calloc(NUM_ADAPTIVE_STRATEGIES, sizeof(GhostList));
+        pool->windowStartHits = calloc(NUM_ADAPTIVE_STRATEGIES, sizeof(long));
+        bool ready = (pool->ghosts != NULL && pool->windowStartHits != NULL);
+        for (int s = 0; ready && s < NUM_ADAPTIVE_STRATEGIES; s++) {
+            ready = (initGhostList(&pool->ghosts[s], numPages, adaptiveStrategies[s]) == RC_OK);
+        }
+        if (!ready) {
+            BM_SharedPool failed = { numPages, strategy, pool };
+            shutdownSharedPool(&failed);
+            return RC_ERROR;
+        }
+        pool->adaptiveWindow = options->adaptiveWindow;
+    }
+
+    // The tier gets a page table sized for pages that shrink to about a tenth
+    if (options != NULL && options->compressedTierBytes > 0) {
+        CompressedTier *tier = calloc(1, sizeof(CompressedTier));
+        int tierBuckets = 1;
+        while (tierBuckets < 2 * (options->compressedTierBytes / (PAGE_SIZE / 10) + 1)) {
+            tierBuckets <<= 1;
+        }
+        if (tier != NULL) {
+            tier->buckets = calloc(tierBuckets, sizeof(TierPage *));
+        }
+        if (tier == NULL || tier->buckets == NULL) {
+            free(tier);
+            BM_SharedPool failed = { numPages, strategy, pool };
+            shutdownSharedPool(&failed);
+            return RC_ERROR;
+        }
+        tier->numBuckets = tierBuckets;
+        tier->maxBytes = options->compressedTierBytes;
+        pool->tier = tier;
+    }
+
+    sp->numPages = numPages;
+    sp->strategy = strategy;
+    sp->mgmtData = pool;
+
+    return RC_OK;
+}
+
+extern RC shutdownSharedPool(BM_SharedPool *const sp)
+{
+    if (sp == NULL || sp->mgmtData == NULL) {
+        return RC_ERROR;
+    }
+    SharedPoolMgmt *pool = (SharedPoolMgmt *)sp->mgmtData;
+
+    // Every page file has to be detached (with shutdownBufferPool) first
+    if (pool->numAttached > 0) {
+        return RC_BUFFER_POOL_IN_USE;
+    }
+
+    for (int s = 0; pool->ghosts != NULL && s < NUM_ADAPTIVE_STRATEGIES; s++) {
+        freeGhostList(&pool->ghosts[s]);
+    }
+    free(pool->ghosts);
+    free(pool->windowStartHits);
+    if (pool->tier != NULL) {
+        while (pool->tier->oldest != NULL) {
+            TierPage *oldest = pool->tier->oldest;
+            dropTierPage(pool->tier, findTierLink(pool->tier, oldest->fileId, oldest->pageNum));
+        }
+        free(pool->tier->buckets);
+        free(pool->tier);
+    }
+    free(pool->frames);
+    free(pool->buckets);
+    free(pool->nextInBucket);
+    free(pool);
+    sp->mgmtData = NULL;
+
+    return RC_OK;
+}
+
+// Evict the unpinned pages that were used least recently until no more than
+// keepFrames are resident, counting only the pages of owner unless it is NULL.
+// Stops at the first dirty page that can not be written back.
+static RC evictDownTo(SharedPoolMgmt *pool, BufferPoolMgmt *owner, int keepFrames)
+{
+    int resident = (owner != NULL) ? owner->usedFrames : pool->bufferSize - pool->freeFrames;
+
+    while (resident > keepFrames) {
+        int victim = -1;
+        for (int i = 0; i < pool->bufferSize; i++) {
+            PageFrame *frame = &pool->frames[i];
+            if (frame->owner == NULL || frame->fixCount > 0 || (owner != NULL && frame->owner != owner))
+                continue;
+            if (victim == -1 || frame->lastHit < pool->frames[victim].lastHit)
+                victim = i;
+        }
+        // The rest is pinned
+        if (victim == -1) {
+            return RC_OK;
+        }
+        BufferPoolMgmt *victimOwner = pool->frames[victim].owner;
+        RC status = writeBackFrame(pool, victim);
+        if (status != RC_OK) {
+            return status;
+        }
+        victimOwner->stats.evictions[pool->strategy]++;
+        resident--;
+    }
+    return RC_OK;
+}
+
+// Index a frame gets after the pool was resized, frames keep their order
+static int movedFrame(const int *newIndex, int oldSize, int pointer, int newSize)
+{
+    pointer %= oldSize;
+    while (pointer < oldSize && newIndex[pointer] == -1)
+        pointer++;
+    return (pointer < oldSize) ? newIndex[pointer] % newSize : 0;
+}
+
+// Change the number of frames of the pool. Shrinking evicts the least recently used
+// unpinned pages first and moves the remaining ones to the front of the frames.
+static RC resizePool(SharedPoolMgmt *pool, int newSize)
+{
+    int oldSize = pool->bufferSize;
+    int pinned = 0;
+
+    for (int i = 0; i < oldSize; i++) {
+        if (pool->frames[i].owner != NULL && pool->frames[i].fixCount > 0)
+            pinned++;
+    }
+    if (pinned > newSize) {
+        return RC_PINNED_PAGES_IN_BUFFER;
+    }
+    // The frames reserved by the attached files have to fit
+    if (newSize < pool->reservedFrames) {
+        return RC_NO_SPACE_IN_POOL;
+    }
+
+    int numBuckets = 1;
+    while (numBuckets < 2 * newSize) {
+        numBuckets <<= 1;
+    }
+    PageFrame *frames = malloc(sizeof(PageFrame) * newSize);
+    int *buckets = malloc(sizeof(int) * numBuckets);
+    int *nextInBucket = malloc(sizeof(int) * newSize);
+    int *newIndex = malloc(sizeof(int) * oldSize);
+    GhostList ghosts[NUM_ADAPTIVE_STRATEGIES];
+    bool ready = (frames != NULL && buckets != NULL && nextInBucket != NULL && newIndex != NULL);
+    int numGhosts = 0;
+    while (ready && pool->ghosts != NULL && numGhosts < NUM_ADAPTIVE_STRATEGIES) {
+        ready = (initGhostList(&ghosts[numGhosts], newSize, adaptiveStrategies[numGhosts]) == RC_OK);
+        if (ready)
+            numGhosts++;
+    }
+    RC status = ready ? evictDownTo(pool, NULL, newSize) : RC_ERROR;
+    if (status != RC_OK) {
+        for (int s = 0; s < numGhosts; s++)
+            freeGhostList(&ghosts[s]);
+        free(frames);
+        free(buckets);
+        free(nextInBucket);
+        free(newIndex);
+        return status;
+    }
+
+    // A growing pool keeps every page where it is, a shrinking one packs them to the front
+    int used = 0;
+    for (int i = 0; i < oldSize; i++) {
+        if (newSize >= oldSize)
+            newIndex[i] = i;
+        else
+            newIndex[i] = (pool->frames[i].owner != NULL) ? used++ : -1;
+    }
+    for (int i = 0; i < newSize; i++) {
+        frames[i].data = NULL;
+        frames[i].pageNum = NO_PAGE;
+        frames[i].dirtyBit = 0;
+        frames[i].fixCount = 0;
+        frames[i].hitNum = 0;
+        frames[i].refNum = 0;
+        frames[i].pinStartNs = 0;
+        frames[i].pinCount = 0;
+        frames[i].lastHit = 0;
+        frames[i].loadedAt = 0;
+        frames[i].owner = NULL;
+        frames[i].pinSites = NULL;
+        frames[i].numPinSites = 0;
+        frames[i].pinSiteCapacity = 0;
+        nextInBucket[i] = -1;
+    }
+    for (int i = 0; i < numBuckets; i++) {
+        buckets[i] = -1;
+    }
+
+    // The hands point to the first page at or after the one they pointed to before
+    pool->clockPointer = movedFrame(newIndex, oldSize, pool->clockPointer, newSize);
+    pool->lfuPointer = movedFrame(newIndex, oldSize, pool->lfuPointer, newSize);
+
+    PageFrame *oldFrames = pool->frames;
+    free(pool->buckets);
+    free(pool->nextInBucket);
+    pool->frames = frames;
+    pool->buckets = buckets;
+    pool->nextInBucket = nextInBucket;
+    pool->numBuckets = numBuckets;
+    pool->bufferSize = newSize;
+    pool->freeFrames = newSize;
+    for (int i = 0; i < oldSize; i++) {
+        if (oldFrames[i].owner != NULL) {
+            // placePage counts the page as if it was new to the pool and its owner
+            BufferPoolMgmt *owner = oldFrames[i].owner;
+            if (--owner->usedFrames < owner->options.minFrames)
+                pool->reservedFree++;
+            placePage(pool, newIndex[i], &oldFrames[i]);
+        }
+    }
+    free(oldFrames);
+    free(newIndex);
+
+    // The ghost lists start over at the new size
+    for (int s = 0; s < numGhosts; s++) {
+        freeGhostList(&pool->ghosts[s]);
+        pool->ghosts[s] = ghosts[s];
+        pool->windowStartHits[s] = 0;
+    }
+    pool->windowPins = 0;
+    pool->leader = -1;
+    pool->leaderWindows = 0;
+
+    return RC_OK;
+}
+
+extern RC resizeSharedPool(BM_SharedPool *const sp, const int newNumPages)
+{
+    if (sp == NULL || sp->mgmtData == NULL || newNumPages <= 0) {
+        return RC_ERROR;
+    }
+
+    RC status = resizePool((SharedPoolMgmt *)sp->mgmtData, newNumPages);
+    if (status == RC_OK) {
+        sp->numPages = newNumPages;
+    }
+    return status;
+}
+
+extern RC attachBufferPool(BM_BufferPool *const bm, BM_SharedPool *const sp,
+                           const char *const pageFileName, const int maxPages)
+{
+    return attachBufferPoolWithOptions(bm, sp, pageFileName, maxPages, NULL);
+}
+
+extern RC attachBufferPoolWithOptions(BM_BufferPool *const bm, BM_SharedPool *const sp,
+                                      const char *const pageFileName, const int maxPages,
+                                      const BM_PoolOptions *options)
+{
+    if (bm == NULL || sp == NULL || sp->mgmtData == NULL) {
+        return RC_ERROR;
+    }
+    SharedPoolMgmt *pool = (SharedPoolMgmt *)sp->mgmtData;
+
+    BufferPoolMgmt *mgmt = malloc(sizeof(BufferPoolMgmt));
+    if (mgmt == NULL) {
+        return RC_ERROR;
+    }
+    memset(mgmt, 0, sizeof(BufferPoolMgmt));
+
+    // 0 means no budget, a budget larger than the pool only matters once the pool grows
+    mgmt->pool = pool;
+    mgmt->pageFile = (char *)pageFileName;
+    mgmt->fileId = pool->nextFileId++;
+    mgmt->maxFrames = (maxPages < 0) ? 0 : maxPages;
+    if (options != NULL) {
+        mgmt->options = *options;
+    }
+    // The frames this file reserves are kept free for it until it uses them
+    if (mgmt->options.minFrames < 0 ||
+        mgmt->options.minFrames > pool->bufferSize - pool->reservedFrames) {
+        free(mgmt);
+        return RC_NO_SPACE_IN_POOL;
+    }
+    if (mgmt->options.traceEvents > 0) {
+        mgmt->trace = malloc(sizeof(BM_TraceEvent) * mgmt->options.traceEvents);
+        if (mgmt->trace == NULL) {
+            free(mgmt);
+            return RC_ERROR;
+        }
+    }
+    pool->numAttached++;
+    pool->reservedFrames += mgmt->options.minFrames;
+    pool->reservedFree += mgmt->options.minFrames;
+
+    // Start with the pages that were resident when the file was detached last time
+    if (mgmt->options.warmRestart) {
+        loadResidentPages(mgmt);
+    }
+
+    // The attached pool shows all the frames, those holding other files' pages look empty
+    bm->strategy = pool->strategy;
+    bm->numPages = pool->bufferSize;
+    bm->pageFile = (char *)pageFileName;
+    bm->mgmtData = mgmt;
+
+    return RC_OK;
+}
+
+extern RC initBufferPool(BM_BufferPool *const bm, const char *const pageFileName,
+                         const int numPages, ReplacementStrategy strategy,
+                         void *stratData)
+{
+    return initBufferPoolWithOptions(bm, pageFileName, numPages, strategy, stratData, NULL);
+}
+
+extern RC initBufferPoolWithOptions(BM_BufferPool *const bm, const char *const pageFileName,
+                                    const int numPages, ReplacementStrategy strategy,
+                                    void *stratData, const BM_PoolOptions *options)
+{
+    BM_SharedPool sp;
+
+    // A private pool is a shared pool with a single page file attached to it
+    RC status = initSharedPoolWithOptions(&sp, numPages, strategy, stratData, options);
+    if (status != RC_OK) {
+        return status;
+    }
+    ((SharedPoolMgmt *)sp.mgmtData)->privatePool = true;
+
+    status = attachBufferPoolWithOptions(bm, &sp, pageFileName, 0, options);
+    if (status != RC_OK) {
+        shutdownSharedPool(&sp);
+    }
+    return status;
+}
+
+extern RC shutdownBufferPool(BM_BufferPool *const bm) {
+    BufferPoolMgmt *mgmt = (BufferPoolMgmt *)bm->mgmtData;
+    SharedPoolMgmt *pool = mgmt->pool;
+    PageFrame *pageFrames = pool->frames;
+
+    // Flush dirty pages to disk
+    RC flushStatus = forceFlushPool(bm);
+    if (flushStatus != RC_OK) {
+        return flushStatus;
+    }
+
+    // Check for pinned pages
+    for (int i = 0; i < pool->bufferSize; i++) {
+        if (pageFrames[i].owner == mgmt && pageFrames[i].fixCount != 0) {
+            if (mgmt->options.trackPins) {
+                reportPinnedPages(mgmt, "shutdownBufferPool: leaked pin", false);
+            }
+            return RC_PINNED_PAGES_IN_BUFFER;
+        }
+    }
+
+    // Remember the resident pages for the next start, the pool works without them
+    if (mgmt->options.warmRestart) {
+        saveResidentPages(mgmt);
+    }
+
+    // Give the frames of this page file back to the pool
+    for (int i = 0; i < pool->bufferSize; i++) {
+        if (pageFrames[i].owner == mgmt) {
+            releaseFrame(pool, i);
+        }
+    }
+    if (pool->tier != NULL) {
+        dropFileFromTier(pool->tier, mgmt->fileId);
+    }
+    pool->numAttached--;
+    pool->reservedFrames -= mgmt->options.minFrames;
+    pool->reservedFree -= mgmt->options.minFrames;
+    free(mgmt->trace);
+    free(mgmt);
+    bm->mgmtData = NULL;
+
+    // Free the frames as well if nobody else can use them
+    if (pool->privatePool) {
+        BM_SharedPool sp = { pool->bufferSize, pool->strategy, pool };
+        shutdownSharedPool(&sp);
+    }
+
+    return RC_OK;
+}
+
+extern RC resizeBufferPool(BM_BufferPool *const bm, const int newNumPages)
+{
+    if (bm == NULL || bm->mgmtData == NULL || newNumPages <= 0) {
+        return RC_ERROR;
+    }
+    BufferPoolMgmt *mgmt = (BufferPoolMgmt *)bm->mgmtData;
+    SharedPoolMgmt *pool = mgmt->pool;
+
+    // A private pool changes its frames
+    if (pool->privatePool) {
+        RC status = resizePool(pool, newNumPages);
+        if (status == RC_OK) {
+            bm->numPages = newNumPages;
+        }
+        return status;
+    }
+
+    // A file attached to a shared pool changes its budget and gives back the frames above it
+    int pinned = 0;
+    for (int i = 0; i < pool->bufferSize; i++) {
+        if (pool->frames[i].owner == mgmt && pool->frames[i].fixCount > 0)
+            pinned++;
+    }
+    if (pinned > newNumPages) {
+        return RC_PINNED_PAGES_IN_BUFFER;
+    }
+    // The budget stays as it was if a page above the new one can not be written back
+    int oldMaxFrames = mgmt->maxFrames;
+    mgmt->maxFrames = newNumPages;
+    RC status = evictDownTo(pool, mgmt, newNumPages);
+    if (status != RC_OK) {
+        mgmt->maxFrames = oldMaxFrames;
     }
 
-    // Set management data and initialize global counters
-    bm->mgmtData = pageFrames;
-    lfuPointer = writeCount = clockPointer = 0;
+    return status;
+}
 
-    return RC_OK;
+// A dirty frame waiting to be written back by forceFlushPool
+typedef struct DirtyPage
+{
+	PageNumber pageNum;
+	int frameIndex;
+} DirtyPage;
+
+static int compareDirtyPages(const void *a, const void *b) {
+    const DirtyPage *left = (const DirtyPage *)a;
+    const DirtyPage *right = (const DirtyPage *)b;
+    return (left->pageNum > right->pageNum) - (left->pageNum < right->pageNum);
 }
 
-extern RC shutdownBufferPool(BM_BufferPool *const bm) {
-    PageFrame *pageFrames = (PageFrame *)bm->mgmtData;
+extern RC forceFlushPool(BM_BufferPool *const bm) {
+    BufferPoolMgmt *mgmt = (BufferPoolMgmt *)bm->mgmtData;
+    SharedPoolMgmt *pool = mgmt->pool;
+    PageFrame *pageFrames = pool->frames;
 
-    // Flush dirty pages to disk
-    RC flushStatus = forceFlushPool(bm);
-    if (flushStatus != RC_OK) {
-        return flushStatus;
+    // Collect the dirty pages of this file that are not in use by any client
+    DirtyPage *dirtyPages = malloc(sizeof(DirtyPage) * pool->bufferSize);
+    if (dirtyPages == NULL) {
+        return RC_ERROR;
     }
 
-    // Check for pinned pages
-    for (int i = 0; i < bufferSize; i++) {
-        if (pageFrames[i].fixCount != 0) {
-            return RC_PINNED_PAGES_IN_BUFFER;
+    int numDirty = 0;
+    for (int i = 0; i < pool->bufferSize; i++) {
+        if (pageFrames[i].owner == mgmt && pageFrames[i].fixCount == 0 && pageFrames[i].dirtyBit == 1) {
+            dirtyPages[numDirty].pageNum = pageFrames[i].pageNum;
+            dirtyPages[numDirty].frameIndex = i;
+            numDirty++;
         }
     }
 
-    // Free allocated memory and reset management data
-    free(pageFrames);
-    bm->mgmtData = NULL;
+    // Nothing to write, so there is no need to touch the page file
+    if (numDirty == 0) {
+        free(dirtyPages);
+        return RC_OK;
+    }
 
-    return RC_OK;
-}
+    // Sort by page number so that runs of adjacent pages go out as single writes
+    qsort(dirtyPages, numDirty, sizeof(DirtyPage), compareDirtyPages);
 
-extern RC forceFlushPool(BM_BufferPool *const bm) {
-    PageFrame *pageFrames = (PageFrame *)bm->mgmtData;
-    SM_FileHandle fileHandle;
+    int *pageNums = malloc(sizeof(int) * numDirty);
+    SM_PageHandle *pageData = malloc(sizeof(SM_PageHandle) * numDirty);
+    if (pageNums == NULL || pageData == NULL) {
+        free(pageNums);
+        free(pageData);
+        free(dirtyPages);
+        return RC_ERROR;
+    }
+    for (int i = 0; i < numDirty; i++) {
+        pageNums[i] = dirtyPages[i].pageNum;
+        pageData[i] = pageFrames[dirtyPages[i].frameIndex].data;
+    }
 
-    // Open the page file
-    RC openStatus = openPageFile(bm->pageFile, &fileHandle);
-    if (openStatus != RC_OK) {
-        return openStatus;
+    // Open the page file and write the whole batch with one sync at the end
+    SM_FileHandle fileHandle;
+    RC status = openPageFile(mgmt->pageFile, &fileHandle);
+    if (status == RC_OK) {
+        status = writeBlocks(numDirty, pageNums, &fileHandle, pageData);
+        closePageFile(&fileHandle);
     }
 
-    // Flush dirty pages to disk
-    for (int i = 0; i < bm->numPages; i++) {
-        if (pageFrames[i].fixCount == 0 && pageFrames[i].dirtyBit == 1) {
-            RC writeStatus = writeBlock(pageFrames[i].pageNum, &fileHandle, pageFrames[i].data);
-            if (writeStatus != RC_OK) {
-                closePageFile(&fileHandle);
-                return writeStatus;
-            }
-            pageFrames[i].dirtyBit = 0;
-            writeCount++;
+    // Only mark the pages clean once they have reached the disk
+    if (status == RC_OK) {
+        for (int i = 0; i < numDirty; i++) {
+            pageFrames[dirtyPages[i].frameIndex].dirtyBit = 0;
         }
+        mgmt->writeCount += numDirty;
+        mgmt->stats.dirtyWriteBacks += numDirty;
     }
 
-    // Close the page file
-    return closePageFile(&fileHandle);
+    free(pageNums);
+    free(pageData);
+    free(dirtyPages);
+    return status;
 }
 
 
 extern RC markDirty (BM_BufferPool *const bm, BM_PageHandle *const page)
 {
-	PageFrame *pageFrame = (PageFrame *)bm->mgmtData;
-	
-	int i = 0;
-	// Iterating through all the pages in the buffer pool
-	while (i < bufferSize)
-	{
-		// If the current page is the page to be marked dirty, then set dirtyBit = 1 (page has been modified) for that page
-		if (pageFrame[i].pageNum == page->pageNum){
-			pageFrame[i].dirtyBit = 1;
-			return RC_OK;
-		}
+	BufferPoolMgmt *mgmt = (BufferPoolMgmt *)bm->mgmtData;
+	PageFrame *pageFrame = mgmt->pool->frames;
 
-		i++;
+	// Look the page up in the page table and set dirtyBit = 1 (page has been modified) for that page
+	int i = findFrame(mgmt, page->pageNum);
+	if (i != -1)
+	{
+		pageFrame[i].dirtyBit = 1;
+		traceEvent(mgmt, page->pageNum, TE_DIRTY);
+		return RC_OK;
 	}
-		
+
 	return RC_ERROR;
 }
 
 
 extern RC unpinPage(BM_BufferPool *const bm, BM_PageHandle *const page)
 {
-    PageFrame *frameOfPage = (PageFrame *)bm->mgmtData;
+    BufferPoolMgmt *mgmt = (BufferPoolMgmt *)bm->mgmtData;
+    PageFrame *frameOfPage = mgmt->pool->frames;
 
-    int j = 0;
-    // Repeat this process for each page in the buffer pool.
-    while (j < bufferSize)
+    // Find the frame holding the page to be unpinned
+    int j = findFrame(mgmt, page->pageNum);
+    if (j != -1 && frameOfPage[j].fixCount > 0)
     {
-        // Check if the current page is the page to be unpinned
-        if (frameOfPage[j].pageNum == page->pageNum)
-        {
-            frameOfPage[j].fixCount--;
-            break; // Verify that the page being unpinned is the current page.
-        }
-        j++;
+        if (--frameOfPage[j].fixCount == 0)
+            noteUnpinned(mgmt, &frameOfPage[j]);
+        dropPinSite(&frameOfPage[j], page);
+        traceEvent(mgmt, page->pageNum, TE_UNPIN);
+    }
+    // An unpin without a pin means a pin was given back twice, or by the wrong client
+    else
+    {
+        mgmt->stats.unbalancedUnpins++;
+        if (mgmt->options.trackPins)
+            fprintf(stderr, "unpinPage: page %d of %s is not pinned\n", page->pageNum, mgmt->pageFile);
     }
 
     return RC_OK;
@@ -299,193 +1685,694 @@ extern RC unpinPage(BM_BufferPool *const bm, BM_PageHandle *const page)
 
 extern RC forcePage (BM_BufferPool *const bm, BM_PageHandle *const page)
 {
-	PageFrame *pageFrame = (PageFrame *)bm->mgmtData;
-	
-	int i = 0;
-	// Iterating through all the pages in the buffer pool
-	while (i < bufferSize)
-	{	
-		// If the current page = page to be written to disk, then right the page to the disk using the storage manager functions
-		if (pageFrame[i].pageNum == page->pageNum)
-		{
-			SM_FileHandle fh;
-			openPageFile(bm->pageFile, &fh);
-			writeBlock(pageFrame[i].pageNum, &fh, pageFrame[i].data);
-
-			// Mark page as undirty because the modified page has been written to disk
-			pageFrame[i].dirtyBit = 0;
+	BufferPoolMgmt *mgmt = (BufferPoolMgmt *)bm->mgmtData;
+	PageFrame *pageFrame = mgmt->pool->frames;
 
-			// Increase the writeCount which records the number of writes done by the buffer manager.
-			writeCount++;
-
-			break;
-		}
-		i++;
+	// If the page is in the pool, then write the page to the disk using the storage manager functions
+	int i = findFrame(mgmt, page->pageNum);
+	if (i != -1)
+	{
+		SM_FileHandle fh;
+		RC status = openPageFile(mgmt->pageFile, &fh);
+		if (status == RC_OK)
+			status = writeBlock(pageFrame[i].pageNum, &fh, pageFrame[i].data);
+		// A page that could not be written stays dirty
+		if (status != RC_OK)
+			return status;
+
+		// Mark page as undirty because the modified page has been written to disk
+		pageFrame[i].dirtyBit = 0;
+
+		// Increase the writeCount which records the number of writes done by the buffer manager.
+		mgmt->writeCount++;
+		mgmt->stats.dirtyWriteBacks++;
 	}
-	
+
 	return RC_OK;
 }
 
 
-bool isPageFrameEmpty(const PageFrame *frame){
-		return frame->pageNum == -1;
-	}
+// Whether the frame in the given slot of the ring can take the next page the ring reads
+static bool isRingFrameReusable(BufferPoolMgmt *mgmt, AccessRingMgmt *ring, int slot)
+{
+	int index = ring->frames[slot];
+	if (index < 0 || index >= mgmt->pool->bufferSize || ring->user != mgmt)
+		return false;
+
+	PageFrame *frame = &mgmt->pool->frames[index];
+	return frame->owner == mgmt && frame->pageNum == ring->pages[slot] && frame->fixCount == 0;
+}
 
+static RC pinPageThroughRing (BM_BufferPool *const bm, BM_PageHandle *const page,
+	    const PageNumber pageNum, AccessRingMgmt *ring);
 
 extern RC pinPage (BM_BufferPool *const bm, BM_PageHandle *const page,
 	    const PageNumber pageNum)
 {
-	PageFrame *frameOfPage = (PageFrame *)bm->mgmtData;
+	return pinPageThroughRing(bm, page, pageNum, NULL);
+}
+
+// Remember the call site of a pin in the frame it holds, if the file tracks pins
+static void notePinSite (BM_BufferPool *const bm, BM_PageHandle *const page, const char *file, int line)
+{
+	BufferPoolMgmt *mgmt = (BufferPoolMgmt *)bm->mgmtData;
+	if (!mgmt->options.trackPins)
+		return;
+
+	int index = findFrame(mgmt, page->pageNum);
+	if (index != -1)
+		addPinSite(&mgmt->pool->frames[index], page, file, line);
+}
+
+extern RC pinPageAt (BM_BufferPool *const bm, BM_PageHandle *const page,
+	    const PageNumber pageNum, const char *file, int line)
+{
+	RC status = pinPageThroughRing(bm, page, pageNum, NULL);
+	if (status == RC_OK)
+		notePinSite(bm, page, file, line);
+	return status;
+}
+
+extern RC pinPageRingAt (BM_BufferPool *const bm, BM_PageHandle *const page,
+	    const PageNumber pageNum, BM_AccessRing *const ring, const char *file, int line)
+{
+	RC status = pinPageRing(bm, page, pageNum, ring);
+	if (status == RC_OK)
+		notePinSite(bm, page, file, line);
+	return status;
+}
+
+extern RC pinPageRing (BM_BufferPool *const bm, BM_PageHandle *const page,
+	    const PageNumber pageNum, BM_AccessRing *const ring)
+{
+	if (ring == NULL || ring->mgmtData == NULL)
+		return RC_ERROR;
 
+	AccessRingMgmt *ringMgmt = (AccessRingMgmt *)ring->mgmtData;
 
-	// Ascertaining that this is the first page to be pinned and that the buffer pool is empty
-	if(isPageFrameEmpty(&frameOfPage[0]))
+	// A ring serves one pool at a time, forget frames of the previous one
+	if (ringMgmt->user != bm->mgmtData)
 	{
-		// Reading a page from the disk and starting the buffer pool with the contents of the page frame
-		SM_FileHandle fh;
-		openPageFile(bm->pageFile, &fh);
+		for (int i = 0; i < ring->numFrames; i++)
+			ringMgmt->frames[i] = -1;
+		ringMgmt->user = (BufferPoolMgmt *)bm->mgmtData;
+		ringMgmt->next = 0;
+	}
+	return pinPageThroughRing(bm, page, pageNum, ringMgmt);
+}
+
+extern RC initAccessRing (BM_AccessRing *const ring, const int numFrames)
+{
+	if (ring == NULL || numFrames <= 0)
+		return RC_ERROR;
+
+	AccessRingMgmt *ringMgmt = malloc(sizeof(AccessRingMgmt));
+	int *frames = malloc(sizeof(int) * numFrames);
+	PageNumber *pages = malloc(sizeof(PageNumber) * numFrames);
+	if (ringMgmt == NULL || frames == NULL || pages == NULL)
+	{
+		free(ringMgmt);
+		free(frames);
+		free(pages);
+		return RC_ERROR;
+	}
+	for (int i = 0; i < numFrames; i++)
+	{
+		frames[i] = -1;
+		pages[i] = NO_PAGE;
+	}
+	ringMgmt->frames = frames;
+	ringMgmt->pages = pages;
+	ringMgmt->user = NULL;
+	ringMgmt->numFrames = numFrames;
+	ringMgmt->next = 0;
+
+	ring->numFrames = numFrames;
+	ring->mgmtData = ringMgmt;
+	return RC_OK;
+}
+
+extern RC shutdownAccessRing (BM_AccessRing *const ring)
+{
+	if (ring == NULL || ring->mgmtData == NULL)
+		return RC_ERROR;
+
+	// The pages read through the ring stay in the pool like any other page
+	AccessRingMgmt *ringMgmt = (AccessRingMgmt *)ring->mgmtData;
+	free(ringMgmt->frames);
+	free(ringMgmt->pages);
+	free(ringMgmt);
+	ring->mgmtData = NULL;
+	return RC_OK;
+}
+
+// Note a pin before the page is looked up: trace it, let an adaptive pool review its
+// strategy and show the client the current strategy and size of the pool
+static void beginPin (BM_BufferPool *const bm, const PageNumber pageNum)
+{
+	BufferPoolMgmt *mgmt = (BufferPoolMgmt *)bm->mgmtData;
+	SharedPoolMgmt *pool = mgmt->pool;
+
+	traceEvent(mgmt, pageNum, TE_PIN);
+
+	// An adaptive pool may have changed its strategy since this file last pinned a page
+	if (pool->ghosts != NULL)
+		reviewStrategy(pool, PS_KEY(mgmt->fileId, pageNum));
+
+	// Somebody else may have switched the strategy or resized the pool in the meantime
+	bm->strategy = pool->strategy;
+	bm->numPages = pool->bufferSize;
+}
+
+// Pin the page held in frame j
+static void pinCachedPage (BufferPoolMgmt *mgmt, int j, BM_PageHandle *const page)
+{
+	SharedPoolMgmt *pool = mgmt->pool;
+	PageFrame *frameOfPage = pool->frames;
+
+	// Updating fixCount i.e., a new client has just accessed this page.
+	if(frameOfPage[j].fixCount++ == 0)
+		notePinned(mgmt, &frameOfPage[j]);
+	frameOfPage[j].pinCount++;
+	mgmt->stats.hits++;
+	pool->hit++; // Increasing the hit (the LRU method uses the hit to find the least recently used page).
+	frameOfPage[j].lastHit = pool->hit;
+
+	// Increasing referenceThe number represents the addition of one more usages to the page usage count (referenced).
+	// It is kept up for every strategy so that LFU can take over.
+	frameOfPage[j].refNum++;
+
+	if(pool->strategy == RS_CLOCK)
+		// hitNum is set to 1 to signify that this was the final page frame checked before adding it to the buffer pool.
+		frameOfPage[j].hitNum = 1;
+	else if(pool->strategy == RS_LRU)
+		// The least recently used page is determined by the LRU algorithm using the hit value.
+		frameOfPage[j].hitNum = pool->hit;
+
+	pool->clockPointer++;
+	page->data = frameOfPage[j].data;
+	page->pageNum = frameOfPage[j].pageNum;
+}
+
+// Set up a frame for a page that is not in the pool, pinned by the client that asked
+// for it. The page reads as zeros until the caller fills in its data.
+static RC newPinnedPage (BufferPoolMgmt *mgmt, const PageNumber pageNum, PageFrame *newPage)
+{
+	SharedPoolMgmt *pool = mgmt->pool;
+
+	newPage->data = (SM_PageHandle) malloc(PAGE_SIZE);
+	if (newPage->data == NULL)
+		return RC_ERROR;
+	memset(newPage->data, 0, PAGE_SIZE);
+
+	newPage->pageNum = pageNum;
+	newPage->dirtyBit = 0;
+	newPage->refNum = 0;
+	newPage->fixCount = 1;
+	newPage->pinCount = 1;
+	newPage->owner = mgmt;
+	newPage->pinSites = NULL;
+	newPage->numPinSites = 0;
+	newPage->pinSiteCapacity = 0;
+	notePinned(mgmt, newPage);
+
+	pool->hit++;
+	pool->numReads++;
+	newPage->lastHit = pool->hit;
+	newPage->loadedAt = pool->numReads;
+
+	if(pool->strategy == RS_CLOCK)
+		// hitNum is set to 1 to signify that this was the final page frame checked before adding it to the buffer.
+		newPage->hitNum = 1;
+	else
+		// The least recently used page is determined by the LRU algorithm using the hit value.
+		newPage->hitNum = pool->hit;
+
+	return RC_OK;
+}
+
+// Place a new page in an empty frame if the file may take one, otherwise in the frame
+// of the victim the replacement strategy picks. The client does not get a page that
+// could not be placed.
+static RC placeNewPage (BM_BufferPool *const bm, PageFrame *newPage)
+{
+	BufferPoolMgmt *mgmt = (BufferPoolMgmt *)bm->mgmtData;
+	SharedPoolMgmt *pool = mgmt->pool;
+	RC replaced = RC_STRATEGY_NOT_SUPPORTED;
+
+	// Use an empty frame while there is one and this file is within its budget
+	if (freeFramesFor(mgmt) > 0)
+	{
+		int j;
+		for (j = 0; !isPageFrameEmpty(&pool->frames[j]); j++)
+			mgmt->stats.lookupScanSteps++;
+		placePage(pool, j, newPage);
+		return RC_OK;
+	}
 
-		SM_PageHandle pageData = (SM_PageHandle) malloc(PAGE_SIZE);
-		frameOfPage[0].data = pageData;
+	//If the buffer is full, we must use the page replacement approach to replace an existing page.
+	//depending on the chosen page replacement technique, call the relevant algorithm's function (provided through arguments).
+	// The strategy only looks at pages of the lowest priority it may replace
+	pool->victimPriority = lowestVictimPriority(mgmt);
+
+	if (pool->strategy == RS_FIFO) {
+		replaced = FIFO(bm, newPage);
+	} else if (pool->strategy == RS_LRU) {
+		replaced = LRU(bm, newPage);
+	} else if (pool->strategy == RS_CLOCK) {
+		replaced = CLOCK(bm, newPage);
+	} else if (pool->strategy == RS_LFU) {
+		replaced = LFU(bm, newPage);
+	} else if (pool->strategy == RS_LRU_K) {
+		printf("\nLRU-k algorithm is not used.\n");
+	} else {
+		printf("\nNo algorithm has been used.\n");
+	}
+
+	if (replaced != RC_OK) {
+		mgmt->stats.pinnedFrames--;
+		free(newPage->data);
+	}
+	// Every frame is held by a client, show who holds them
+	if (replaced == RC_NO_SPACE_IN_POOL && mgmt->options.trackPins) {
+		fprintf(stderr, "pinPage: no frame for page %d of %s, all %d frames are pinned\n",
+				newPage->pageNum, mgmt->pageFile, pool->bufferSize);
+		reportPinnedPages(mgmt, "pinPage", true);
+	}
+	return replaced;
+}
 
-		ensureCapacity(pageNum,&fh);
-		readBlock(pageNum, &fh, frameOfPage[0].data);
+// Read pages that are not in the pool from disk in one batch, pageNums sorted ascending.
+// Pages past the end of the file read as zeros.
+static RC readNewPages (BufferPoolMgmt *mgmt, int numPages, const PageNumber *pageNums, SM_PageHandle *data)
+{
+	SM_FileHandle fileH;
+	RC status = openPageFile(mgmt->pageFile, &fileH);
+
+	// The first page read for this file makes sure the file is large enough
+	if (status == RC_OK && mgmt->readCount == 0)
+		status = ensureCapacity(pageNums[numPages - 1], &fileH);
+	if (status != RC_OK)
+		return status;
+
+	int numExisting = 0;
+	while (numExisting < numPages && pageNums[numExisting] < fileH.totalNumPages)
+		numExisting++;
+	return readBlocks(numExisting, pageNums, &fileH, data);
+}
 
-		frameOfPage[0].pageNum = pageNum;
-		rearIndex = hit = 0;
-		frameOfPage[0].hitNum = hit;
-		frameOfPage[0].fixCount++;
-		frameOfPage[0].refNum = 0;
+static RC pinPageThroughRing (BM_BufferPool *const bm, BM_PageHandle *const page,
+	    const PageNumber pageNum, AccessRingMgmt *ring)
+{
+	BufferPoolMgmt *mgmt = (BufferPoolMgmt *)bm->mgmtData;
+	SharedPoolMgmt *pool = mgmt->pool;
 
-		page->pageNum = pageNum;
-		page->data = frameOfPage[0].data;
+	beginPin(bm, pageNum);
 
+	// Verifying that the page is in memory
+	int j = findFrame(mgmt, pageNum);
+	if (j != -1)
+	{
+		pinCachedPage(mgmt, j, page);
 		return RC_OK;
 	}
+
+	// Create a new page to store data read from the file.
+	PageFrame newPage;
+	if (newPinnedPage(mgmt, pageNum, &newPage) != RC_OK)
+		return RC_ERROR;
+
+	// Find a frame before the page is read, so a page that can not be placed is not read
+	// A ring reuses its own frame from numFrames misses ago, if nobody took it over since
+	int slot = (ring != NULL) ? ring->next : -1;
+	if (slot != -1 && isRingFrameReusable(mgmt, ring, slot))
+	{
+		RC status = evictFrame(mgmt, ring->frames[slot], 1);
+		if (status != RC_OK)
+		{
+			mgmt->stats.pinnedFrames--;
+			free(newPage.data);
+			return status;
+		}
+		placePage(pool, ring->frames[slot], &newPage);
+	}
 	else
 	{
-		int j;
-		bool bufferFull = true;
+		RC replaced = placeNewPage(bm, &newPage);
+		if (replaced != RC_OK)
+			return replaced;
+	}
+
+	// A compressed copy saves reading the page from disk
+	RC status = RC_OK;
+	if (pool->tier != NULL && takeFromTier(pool, mgmt, pageNum, newPage.data))
+	{
+		mgmt->stats.tierHits++;
+	}
+	else
+	{
+		status = readNewPages(mgmt, 1, &pageNum, &newPage.data);
+		if (status == RC_OK)
+			mgmt->readCount++;
+	}
+
+	// The client does not get a page that could not be read, its frame is empty again
+	if (status != RC_OK)
+	{
+		mgmt->stats.pinnedFrames--;
+		releaseFrame(pool, pool->lastPlaced);
+		return status;
+	}
+	mgmt->stats.misses++;
+
+	// The ring comes back to this frame after numFrames more misses
+	if (ring != NULL)
+	{
+		ring->frames[slot] = pool->lastPlaced;
+		ring->pages[slot] = pageNum;
+		ring->next = (slot + 1) % ring->numFrames;
+	}
+
+	page->pageNum = pageNum;
+	page->data = newPage.data;
+	return RC_OK;
+}
+
+// A page of a pinPages call that was not in the pool
+typedef struct MissedPage
+{
+	PageNumber pageNum;
+	int request;    // Index of the request in the call
+} MissedPage;
+
+static int compareMissedPages(const void *a, const void *b) {
+	const MissedPage *left = (const MissedPage *)a, *right = (const MissedPage *)b;
+	if (left->pageNum != right->pageNum)
+		return (left->pageNum > right->pageNum) - (left->pageNum < right->pageNum);
+	return left->request - right->request;
+}
+
+// A frame the replacement strategy may reuse for a page of a pinPages call
+typedef struct VictimCandidate
+{
+	int frame;
+	int priority;   // Priority of the file the page in the frame belongs to
+	long rank;      // Order the strategy replaces pages in, the lowest first
+	bool taken;     // The frame went to a page of the call
+} VictimCandidate;
+
+static int compareVictimCandidates(const void *a, const void *b) {
+	const VictimCandidate *left = (const VictimCandidate *)a, *right = (const VictimCandidate *)b;
+	if (left->priority != right->priority)
+		return (left->priority > right->priority) - (left->priority < right->priority);
+	return (left->rank > right->rank) - (left->rank < right->rank);
+}
+
+// Rank the pages mgmt may replace in the order the strategy of the pool would pick them
+// one pin at a time, lowest priority first, in one pass over the frames
+static int rankVictims (BufferPoolMgmt *mgmt, VictimCandidate *candidates)
+{
+	SharedPoolMgmt *pool = mgmt->pool;
+	int n = pool->bufferSize;
+	int numCandidates = 0;
+
+	for (int i = 0; i < n; i++)
+	{
+		PageFrame *frame = &pool->frames[i];
+		if (!isEvictable(mgmt, frame))
+			continue;
+
+		// LFU and CLOCK break ties by the distance from where their search starts
+		long rank;
+		if (pool->strategy == RS_FIFO)
+			rank = frame->loadedAt;
+		else if (pool->strategy == RS_LRU)
+			rank = frame->hitNum;
+		else if (pool->strategy == RS_LFU)
+			rank = (long)frame->refNum * n + (i - pool->lfuPointer + n) % n;
+		else
+			// A page with its reference bit set is only reached on the second round of the hand
+			rank = ((frame->hitNum == 0) ? 0 : n) + (i - pool->clockPointer % n + n) % n;
+
+		candidates[numCandidates].frame = i;
+		candidates[numCandidates].priority = frame->owner->options.priority;
+		candidates[numCandidates].rank = rank;
+		candidates[numCandidates].taken = false;
+		numCandidates++;
+	}
+	qsort(candidates, numCandidates, sizeof(VictimCandidate), compareVictimCandidates);
+
+	// LFU looks for each victim after the previous one, so the pages of the next
+	// frequency are ranked from the frame after the last page of the one before
+	for (int first = 0, next; pool->strategy == RS_LFU && first < numCandidates; first = next)
+	{
+		int refNum = pool->frames[candidates[first].frame].refNum;
+		for (next = first + 1; next < numCandidates &&
+		     candidates[next].priority == candidates[first].priority &&
+		     pool->frames[candidates[next].frame].refNum == refNum; next++)
+			;
+		if (first == 0)
+			continue;
+		int start = candidates[first - 1].frame + 1;
+		for (int c = first; c < next; c++)
+			candidates[c].rank = (long)refNum * n + (candidates[c].frame - start + 2 * n) % n;
+		qsort(candidates + first, next - first, sizeof(VictimCandidate), compareVictimCandidates);
+	}
+	return numCandidates;
+}
+
+// Move the pointers of the strategy past the last victim, as if the victims had been
+// picked one pin at a time. The clock hand clears the reference bits of the pages it passed.
+static void advanceVictimPointers (SharedPoolMgmt *pool, VictimCandidate *candidates,
+	    int numCandidates, const VictimCandidate *last)
+{
+	int n = pool->bufferSize;
+
+	if (pool->strategy == RS_LFU)
+	{
+		pool->lfuPointer = (last->frame + 1) % n;
+	}
+	else if (pool->strategy == RS_CLOCK)
+	{
+		// A victim from the second round means the hand went all the way round once
+		for (int c = 0; c < numCandidates; c++)
+		{
+			if (!candidates[c].taken && (last->rank >= n || candidates[c].rank % n < last->rank % n))
+				pool->frames[candidates[c].frame].hitNum = 0;
+		}
+		pool->clockPointer = last->frame + 1;
+	}
+}
+
+extern RC pinPages (BM_BufferPool *const bm, BM_PageHandle *const pages,
+	    const PageNumber *const pageNums, const int numPages)
+{
+	if (bm == NULL || bm->mgmtData == NULL || pages == NULL || pageNums == NULL || numPages < 0)
+		return RC_ERROR;
+	if (numPages == 0)
+		return RC_OK;
+
+	BufferPoolMgmt *mgmt = (BufferPoolMgmt *)bm->mgmtData;
+	SharedPoolMgmt *pool = mgmt->pool;
+	MissedPage *misses = malloc(sizeof(MissedPage) * numPages);
+	int *newFrames = malloc(sizeof(int) * numPages);
+	int *readNums = malloc(sizeof(int) * numPages);
+	SM_PageHandle *readData = malloc(sizeof(SM_PageHandle) * numPages);
+	bool *pinned = calloc(numPages, sizeof(bool));
+	VictimCandidate *candidates = NULL;
+	if (misses == NULL || newFrames == NULL || readNums == NULL || readData == NULL || pinned == NULL)
+	{
+		free(misses);
+		free(newFrames);
+		free(readNums);
+		free(readData);
+		free(pinned);
+		return RC_ERROR;
+	}
+
+	// Serve the hits in one pass over the page table
+	int numMisses = 0;
+	for (int i = 0; i < numPages; i++)
+	{
+		beginPin(bm, pageNums[i]);
+		int j = findFrame(mgmt, pageNums[i]);
+		if (j != -1)
+		{
+			pinCachedPage(mgmt, j, &pages[i]);
+			pinned[i] = true;
+		}
+		else
+		{
+			misses[numMisses].pageNum = pageNums[i];
+			misses[numMisses].request = i;
+			numMisses++;
+		}
+	}
+
+	// Give each missing page a frame in page order, a page asked for twice is a hit the
+	// second time. Empty frames go first, then the victims of one pass of the strategy.
+	RC status = RC_OK;
+	int numNew = 0, emptyFrame = 0;
+	int numCandidates = -1, nextCandidate = 0, lastVictim = -1;
+	int m;
+	qsort(misses, numMisses, sizeof(MissedPage), compareMissedPages);
+	for (m = 0; m < numMisses; m++)
+	{
+		int request = misses[m].request;
+		if (m > 0 && misses[m].pageNum == misses[m - 1].pageNum)
+		{
+			pinCachedPage(mgmt, newFrames[numNew - 1], &pages[request]);
+			pinned[request] = true;
+			continue;
+		}
 
-		for(j = 0; j < bufferSize; j++)
+		int frame;
+		if (freeFramesFor(mgmt) > 0)
+		{
+			while (!isPageFrameEmpty(&pool->frames[emptyFrame]))
+				emptyFrame++;
+			frame = emptyFrame;
+		}
+		else
 		{
-			if(frameOfPage[j].pageNum != -1)
+			if (numCandidates == -1)
 			{
-				// Verifying that the page is in memory
-				if(frameOfPage[j].pageNum == pageNum)
+				if (pool->strategy != RS_FIFO && pool->strategy != RS_LRU &&
+				    pool->strategy != RS_CLOCK && pool->strategy != RS_LFU)
 				{
-					// Updating fixCount i.e., a new client has just accessed this page.
-					bufferFull = false;
-					frameOfPage[j].fixCount++;
-					hit++; // Increasing the hit (the LRU method uses the hit to find the least recently used page).
-
-
-					if(bm->strategy == RS_CLOCK)
-						// hitNum is set to 1 to signify that this was the final page frame checked before adding it to the buffer pool.
-						frameOfPage[j].hitNum = 1;
-					else if(bm->strategy == RS_LFU)
-						// Increasing referenceThe number represents the addition of one more usages to the page usage count (referenced).
-						frameOfPage[j].refNum++;
-					else if(bm->strategy == RS_LRU)
-						// The least recently used page is determined by the LRU algorithm using the hit value.
-						frameOfPage[j].hitNum = hit;
-
-					clockPointer++;
-					page->data = frameOfPage[j].data;
-					page->pageNum = pageNum;
-
+					status = RC_STRATEGY_NOT_SUPPORTED;
+					break;
+				}
+				candidates = malloc(sizeof(VictimCandidate) * pool->bufferSize);
+				if (candidates == NULL)
+				{
+					status = RC_ERROR;
 					break;
 				}
+				numCandidates = rankVictims(mgmt, candidates);
+				mgmt->stats.victimScans++;
+				mgmt->stats.victimScanSteps += pool->bufferSize;
+				if (pool->bufferSize > mgmt->stats.maxVictimScan)
+					mgmt->stats.maxVictimScan = pool->bufferSize;
 			}
-			else {
-				SM_FileHandle fileh;
-				openPageFile(bm->pageFile, &fileh);
-				frameOfPage[j].data = (SM_PageHandle) malloc(PAGE_SIZE);
-				readBlock(pageNum, &fileh, frameOfPage[j].data);
-				frameOfPage[j].refNum = 0;
-				frameOfPage[j].pageNum = pageNum;
-				frameOfPage[j].fixCount = 1;
-
-				rearIndex++;
-				hit++; // Increasing the hit (the LRU algorithm uses the hit to find the least recently used page)
-
-				if(bm->strategy == RS_LRU)
-					// The least recently used page is determined by the LRU algorithm using the hit value.
-					frameOfPage[j].hitNum = hit;
-				else if(bm->strategy == RS_CLOCK)
-					// hitNum is set to 1 to signify that this was the final page frame checked before adding it to the buffer.
-					frameOfPage[j].hitNum = 1;
-
-				page->pageNum = pageNum;
-				page->data = frameOfPage[j].data;
-
-				bufferFull = false;
+			// Earlier victims may have used up what this file may take from another one
+			while (nextCandidate < numCandidates &&
+			       !isEvictable(mgmt, &pool->frames[candidates[nextCandidate].frame]))
+				nextCandidate++;
+			if (nextCandidate == numCandidates)
+			{
+				status = RC_NO_SPACE_IN_POOL;
 				break;
 			}
+			frame = candidates[nextCandidate].frame;
+			status = writeBackFrame(pool, frame);
+			if (status != RC_OK)
+				break;
+			mgmt->stats.evictions[pool->strategy]++;
+			candidates[nextCandidate].taken = true;
+			lastVictim = nextCandidate++;
+		}
+
+		PageFrame newPage;
+		status = newPinnedPage(mgmt, misses[m].pageNum, &newPage);
+		if (status != RC_OK)
+			break;
+		placePage(pool, frame, &newPage);
+		newFrames[numNew++] = frame;
+		pages[request].pageNum = newPage.pageNum;
+		pages[request].data = newPage.data;
+	}
+	if (lastVictim != -1)
+		advanceVictimPointers(pool, candidates, numCandidates, &candidates[lastVictim]);
+
+	// Every frame is held by a client, show who holds them
+	if (status == RC_NO_SPACE_IN_POOL && mgmt->options.trackPins)
+	{
+		fprintf(stderr, "pinPages: no frame for page %d of %s, all %d frames are pinned\n",
+				misses[m].pageNum, mgmt->pageFile, pool->bufferSize);
+		reportPinnedPages(mgmt, "pinPages", true);
+	}
+
+	// Read the pages the tier does not have from disk in one batch, then decompress the others.
+	// A failed read leaves the tier as it was.
+	int numReads = 0;
+	for (int i = 0; status == RC_OK && i < numNew; i++)
+	{
+		PageFrame *frame = &pool->frames[newFrames[i]];
+		if (pool->tier == NULL || *findTierLink(pool->tier, mgmt->fileId, frame->pageNum) == NULL)
+		{
+			readNums[numReads] = frame->pageNum;
+			readData[numReads] = frame->data;
+			numReads++;
+		}
+	}
+	if (status == RC_OK && numReads > 0)
+		status = readNewPages(mgmt, numReads, readNums, readData);
+	if (status == RC_OK)
+	{
+		for (int i = 0; pool->tier != NULL && i < numNew; i++)
+		{
+			PageFrame *frame = &pool->frames[newFrames[i]];
+			if (takeFromTier(pool, mgmt, frame->pageNum, frame->data))
+				mgmt->stats.tierHits++;
 		}
+		mgmt->readCount += numReads;
+		mgmt->stats.misses += numNew;
+	}
 
-		//If bufferFull = true, then the buffer is full and we must use the page replacement approach to replace an existing page.
-		if(bufferFull == true)
+	// All or nothing, the pages pinned so far are given back if one could not be placed or read
+	if (status != RC_OK)
+	{
+		for (int i = 0; i < numPages; i++)
 		{
-			// Create a new page to store data read from the file.
-			PageFrame *newPage;
-			newPage = (PageFrame *)malloc(sizeof(PageFrame));
-
-			// Reading a page from disk and starting the buffer pool with the contents of the page frame
-			SM_FileHandle fileH;
-			openPageFile(bm->pageFile, &fileH);
-			newPage->data = (SM_PageHandle) malloc(PAGE_SIZE);
-			readBlock(pageNum, &fileH, newPage->data);
-			newPage->pageNum = pageNum;
-			newPage->dirtyBit = 0;
-			newPage->refNum = 0;
-			newPage->fixCount = 1;
-
-			hit++;
-			rearIndex++;
-
-
-
-			if(bm->strategy == RS_CLOCK)
-				// hitNum is set to 1 to signify that this was the final page frame checked before adding it to the buffer.
-				newPage->hitNum = 1;
-
-			else if(bm->strategy == RS_LRU)
-				// The least recently used page is determined by the LRU algorithm using the hit value.
-				newPage->hitNum = hit;
-
-			page->pageNum = pageNum;
-			page->data = newPage->data;
-
-			//depending on the chosen page replacement technique, call the relevant algorithm's function (provided through arguments).
-if (bm->strategy == RS_FIFO) {
-    FIFO(bm, newPage);
-} else if (bm->strategy == RS_LRU) {
-    LRU(bm, newPage);
-} else if (bm->strategy == RS_CLOCK) {
-    CLOCK(bm, newPage);
-} else if (bm->strategy == RS_LFU) {
-    LFU(bm, newPage);
-} else if (bm->strategy == RS_LRU_K) {
-    printf("\nLRU-k algorithm is not used.\n");
-} else {
-    printf("\nNo algorithm has been used.\n");
-}
-			free(newPage);
+			if (pinned[i])
+				unpinPage(bm, &pages[i]);
+		}
+		for (int i = 0; i < numNew; i++)
+		{
+			mgmt->stats.pinnedFrames--;
+			releaseFrame(pool, newFrames[i]);
 		}
-		return RC_OK;
 	}
+
+	free(misses);
+	free(newFrames);
+	free(readNums);
+	free(readData);
+	free(pinned);
+	free(candidates);
+	return status;
+}
+
+extern RC pinPagesAt (BM_BufferPool *const bm, BM_PageHandle *const pages,
+	    const PageNumber *const pageNums, const int numPages, const char *file, int line)
+{
+	RC status = pinPages(bm, pages, pageNums, numPages);
+	for (int i = 0; status == RC_OK && i < numPages; i++)
+		notePinSite(bm, &pages[i], file, line);
+	return status;
+}
+
+extern RC unpinPages (BM_BufferPool *const bm, BM_PageHandle *const pages, const int numPages)
+{
+	if (bm == NULL || bm->mgmtData == NULL || pages == NULL || numPages < 0)
+		return RC_ERROR;
+
+	for (int i = 0; i < numPages; i++)
+		unpinPage(bm, &pages[i]);
+	return RC_OK;
 }
 
 
 extern PageNumber *getFrameContents (BM_BufferPool *const bm)
 {
-	PageNumber *frameContents = malloc(sizeof(PageNumber) * bufferSize);
-	PageFrame *pageFrame = (PageFrame *) bm->mgmtData;
-	
+	BufferPoolMgmt *mgmt = (BufferPoolMgmt *)bm->mgmtData;
+	PageNumber *frameContents = malloc(sizeof(PageNumber) * mgmt->pool->bufferSize);
+	PageFrame *pageFrame = mgmt->pool->frames;
+
 	// Iterating through all the pages in the buffer pool and setting frameContents' value to pageNum of the page
-	for(int i = 0; i < bufferSize; i++){
-		if(pageFrame[i].pageNum != -1){
+	for(int i = 0; i < mgmt->pool->bufferSize; i++){
+		if(pageFrame[i].owner == mgmt){
 			frameContents[i] = pageFrame[i].pageNum;
 		}else{
 			frameContents[i] = NO_PAGE;
@@ -497,17 +2384,18 @@ extern PageNumber *getFrameContents (BM_BufferPool *const bm)
 
 extern bool *getDirtyFlags (BM_BufferPool *const bm)
 {
-	PageFrame *pageFrame = (PageFrame *)bm->mgmtData;
-	
+	BufferPoolMgmt *mgmt = (BufferPoolMgmt *)bm->mgmtData;
+	PageFrame *pageFrame = mgmt->pool->frames;
+
 	// Allocate memory of bool type and bufferSize
-	bool *dirtyFlags = malloc(sizeof(bool) * bufferSize);
-	
+	bool *dirtyFlags = malloc(sizeof(bool) * mgmt->pool->bufferSize);
+
 	int i = 0;
-	
+
 	// Iterating through all the pages in the buffer pool and setting dirtyFlags' value to TRUE if page is dirty else FALSE
-	while(i < bufferSize)
+	while(i < mgmt->pool->bufferSize)
 	{
-		if(pageFrame[i].dirtyBit == 1){
+		if(pageFrame[i].owner == mgmt && pageFrame[i].dirtyBit == 1){
 			dirtyFlags[i] = true;
 		}else{
 			dirtyFlags[i] = false;
@@ -515,22 +2403,23 @@ extern bool *getDirtyFlags (BM_BufferPool *const bm)
 
 		i++;
 	}
-	
+
 	return dirtyFlags;
 }
 
 extern int *getFixCounts (BM_BufferPool *const bm)
 {
-	
-	PageFrame *pageFrame= (PageFrame *)bm->mgmtData;
+
+	BufferPoolMgmt *mgmt = (BufferPoolMgmt *)bm->mgmtData;
+	PageFrame *pageFrame = mgmt->pool->frames;
 
 	// Allocate memory of int type and bufferSize
-	int *fixCounts = malloc(sizeof(int) * bufferSize);
-	
+	int *fixCounts = malloc(sizeof(int) * mgmt->pool->bufferSize);
+
 
 	// Iterating through all the pages in the buffer pool and setting fixCounts' value to page's fixCount
-	for(int i = 0; i < bufferSize; i++){
-		if(pageFrame[i].fixCount != -1){
+	for(int i = 0; i < mgmt->pool->bufferSize; i++){
+		if(pageFrame[i].owner == mgmt){
 			fixCounts[i] = pageFrame[i].fixCount;
 		}else{
 			fixCounts[i] = 0;
@@ -540,13 +2429,111 @@ extern int *getFixCounts (BM_BufferPool *const bm)
 	return fixCounts;
 }
 
+extern int getPinSites (BM_BufferPool *const bm, const PageNumber pageNum, BM_PinSite *sites, int maxSites)
+{
+	BufferPoolMgmt *mgmt = (BufferPoolMgmt *)bm->mgmtData;
+	int index = findFrame(mgmt, pageNum);
+	if (index == -1)
+		return 0;
+
+	PageFrame *frame = &mgmt->pool->frames[index];
+	for (int k = 0; k < frame->fixCount && k < maxSites; k++)
+	{
+		if (k < frame->numPinSites)
+			sites[k] = frame->pinSites[k].site;
+		else
+		{
+			sites[k].file = NULL;
+			sites[k].line = 0;
+		}
+	}
+	return frame->fixCount;
+}
+
 extern int getNumReadIO (BM_BufferPool *const bm)
 {
-	// rearIndex starts with 0.
-	return (rearIndex + 1);
+	BufferPoolMgmt *mgmt = (BufferPoolMgmt *)bm->mgmtData;
+
+	return mgmt->readCount;
 }
 
 extern int getNumWriteIO (BM_BufferPool *const bm)
 {
-	return writeCount;
-}
\ No newline at end of file
+	BufferPoolMgmt *mgmt = (BufferPoolMgmt *)bm->mgmtData;
+
+	return mgmt->writeCount;
+}
+
+extern RC getPoolStats (BM_BufferPool *const bm, BM_PoolStats *stats)
+{
+	if (bm == NULL || bm->mgmtData == NULL || stats == NULL)
+		return RC_ERROR;
+
+	BufferPoolMgmt *mgmt = (BufferPoolMgmt *)bm->mgmtData;
+	*stats = mgmt->stats;
+	stats->policySwitches = mgmt->pool->policySwitches;
+
+	// Derived values are computed when the snapshot is taken
+	long requests = stats->hits + stats->misses;
+	stats->hitRatio = (requests > 0) ? (double)stats->hits / requests : 0.0;
+	stats->avgPinDurationUs = (stats->completedPins > 0)
+			? (double)mgmt->totalPinNs / stats->completedPins / 1000.0 : 0.0;
+
+	return RC_OK;
+}
+
+extern RC resetPoolStats (BM_BufferPool *const bm)
+{
+	if (bm == NULL || bm->mgmtData == NULL)
+		return RC_ERROR;
+
+	BufferPoolMgmt *mgmt = (BufferPoolMgmt *)bm->mgmtData;
+
+	// Pages that are pinned right now stay pinned, so keep counting them
+	int pinnedFrames = mgmt->stats.pinnedFrames;
+	memset(&mgmt->stats, 0, sizeof(BM_PoolStats));
+	mgmt->stats.pinnedFrames = pinnedFrames;
+	mgmt->stats.pinnedHighWater = pinnedFrames;
+	mgmt->totalPinNs = 0;
+
+	return RC_OK;
+}
+
+extern int getPoolFramesUsed (BM_BufferPool *const bm)
+{
+	BufferPoolMgmt *mgmt = (BufferPoolMgmt *)bm->mgmtData;
+
+	return mgmt->usedFrames;
+}
+
+extern RC dumpPoolTrace (BM_BufferPool *const bm, const char *const fileName)
+{
+	if (bm == NULL || bm->mgmtData == NULL || fileName == NULL)
+		return RC_ERROR;
+
+	BufferPoolMgmt *mgmt = (BufferPoolMgmt *)bm->mgmtData;
+	if (mgmt->trace == NULL)
+		return RC_ERROR;
+
+	// Once the ring buffer wrapped, the oldest event is the next one to be overwritten
+	long capacity = mgmt->options.traceEvents;
+	long first = (mgmt->traceNext > capacity) ? mgmt->traceNext % capacity : 0;
+	int header[2] = { BM_TRACE_MAGIC, (int)((mgmt->traceNext > capacity) ? capacity : mgmt->traceNext) };
+
+	FILE *traceFile = fopen(fileName, "wb");
+	if (traceFile == NULL)
+		return RC_FILE_NOT_FOUND;
+
+	RC status = RC_OK;
+	if (fwrite(header, sizeof(int), 2, traceFile) != 2)
+		status = RC_WRITE_FAILED;
+	for (long i = 0; i < header[1] && status == RC_OK; i++)
+	{
+		if (fwrite(&mgmt->trace[(first + i) % capacity], sizeof(BM_TraceEvent), 1, traceFile) != 1)
+			status = RC_WRITE_FAILED;
+	}
+	if (fclose(traceFile) != 0)
+		status = RC_WRITE_FAILED;
+
+	return status;
+}
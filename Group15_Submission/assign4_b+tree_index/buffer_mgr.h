@@ -16,6 +16,8 @@ typedef enum ReplacementStrategy {
 	RS_LRU_K = 4
 } ReplacementStrategy;
 
+#define NUM_REPLACEMENT_STRATEGIES (RS_LRU_K + 1)
+
 // Data Types and Structures
 typedef int PageNumber;
 #define NO_PAGE -1
@@ -28,11 +30,88 @@ typedef struct BM_BufferPool {
 	// manager needs for a buffer pool
 } BM_BufferPool;
 
+// Optional behaviour of a buffer pool, given to the *WithOptions init functions
+typedef struct BM_PoolOptions {
+	bool warmRestart; // save the resident pages to "<pageFile>.warm" on shutdown
+	                  // and read them back in when the pool is initialized
+	int traceEvents;  // number of most recent page accesses kept in the trace, 0 for no trace
+	int adaptiveWindow; // every this many pins, switch to the strategy that simulated
+	                    // best if it did so twice in a row; 0 keeps the strategy fixed
+	int compressedTierBytes; // memory for compressed copies of evicted clean pages,
+	                         // a miss on one of them skips the disk read; 0 for no tier
+	int minFrames;    // frames of a shared pool reserved for this file, other files can not
+	                  // take them and do not replace its pages while it holds no more
+	int priority;     // pages of files with a higher priority are replaced only when no
+	                  // page of a lower priority can be
+	bool trackPins;   // remember where each pin still held was taken and print the pages
+	                  // still pinned at shutdown, unpins without a pin and exhausted pools
+} BM_PoolOptions;
+
+// Kinds of page accesses recorded in the trace of a pool
+typedef enum BM_TraceEventType {
+	TE_PIN = 0,
+	TE_UNPIN = 1,
+	TE_DIRTY = 2
+} BM_TraceEventType;
+
+// One recorded page access, also the record format of a dumped trace file.
+// A trace file starts with BM_TRACE_MAGIC and the number of events (two ints).
+typedef struct BM_TraceEvent {
+	PageNumber pageNum;
+	short fileId;
+	short type;
+} BM_TraceEvent;
+
+#define BM_TRACE_MAGIC 0x54524345
+
+// A pool of page frames that caches the pages of several page files. Each file
+// is attached through its own BM_BufferPool, which can then be used like a
+// private pool; its pages are told apart by the file they belong to.
+typedef struct BM_SharedPool {
+	int numPages;
+	ReplacementStrategy strategy;
+	void *mgmtData;
+} BM_SharedPool;
+
+// A few frames that a sequential reader recycles through pinPageRing, so that
+// a large scan does not push the hot pages of the pool out
+typedef struct BM_AccessRing {
+	int numFrames;
+	void *mgmtData;
+} BM_AccessRing;
+
 typedef struct BM_PageHandle {
 	PageNumber pageNum;
 	char *data;
 } BM_PageHandle;
 
+// Where a pin of a page was taken, see BM_PoolOptions.trackPins
+typedef struct BM_PinSite {
+	const char *file; // NULL if the pin was taken without a call site
+	int line;
+} BM_PinSite;
+
+// Snapshot of the activity of a buffer pool since init (or the last reset)
+typedef struct BM_PoolStats {
+	long hits;          // pinPage requests served from a frame
+	long misses;        // pinPage requests that had to read the page from disk (or the tier)
+	double hitRatio;    // hits / (hits + misses)
+	long evictions[NUM_REPLACEMENT_STRATEGIES]; // victims chosen, by strategy that chose them
+	long dirtyWriteBacks;    // dirty pages written back to disk
+	int pinnedFrames;        // frames with fixCount > 0 right now
+	int pinnedHighWater;     // most frames that were pinned at the same time
+	long completedPins;      // frames whose fixCount went back to 0
+	double avgPinDurationUs; // average time a frame stayed pinned, in microseconds
+	long lookupScanSteps;    // frames examined looking for a requested page
+	long victimScans;        // searches for a replacement victim
+	long victimScanSteps;    // frames examined by those searches
+	int maxVictimScan;       // longest single victim search
+	long policySwitches;     // times an adaptive pool changed its replacement strategy
+	long tierStores;         // evicted pages of this file kept in the compressed tier
+	long tierHits;           // misses served from the compressed tier instead of the disk
+	long unbalancedUnpins;   // unpinPage calls for a page that was not pinned
+} BM_PoolStats;
+
 // convenience macros
 #define MAKE_POOL()					\
 		((BM_BufferPool *) malloc (sizeof(BM_BufferPool)))
@@ -44,21 +123,83 @@ typedef struct BM_PageHandle {
 RC initBufferPool(BM_BufferPool *const bm, const char *const pageFileName, 
 		const int numPages, ReplacementStrategy strategy,
 		void *stratData);
+RC initBufferPoolWithOptions(BM_BufferPool *const bm, const char *const pageFileName,
+		const int numPages, ReplacementStrategy strategy,
+		void *stratData, const BM_PoolOptions *options);
 RC shutdownBufferPool(BM_BufferPool *const bm);
+// Grows or shrinks the pool while it is in use, evicting unpinned pages as needed.
+// For a file attached to a shared pool it changes the file's budget instead.
+RC resizeBufferPool(BM_BufferPool *const bm, const int newNumPages);
 RC forceFlushPool(BM_BufferPool *const bm);
 
+// Buffer Manager Interface Shared Pools
+// maxPages is the most frames the attached file may use, 0 for no limit.
+// Attaching fails with RC_NO_SPACE_IN_POOL if the pool can not reserve options->minFrames.
+// shutdownBufferPool detaches the file and keeps the shared pool running.
+RC initSharedPool(BM_SharedPool *const sp, const int numPages,
+		ReplacementStrategy strategy, void *stratData);
+RC initSharedPoolWithOptions(BM_SharedPool *const sp, const int numPages,
+		ReplacementStrategy strategy, void *stratData,
+		const BM_PoolOptions *options);
+RC shutdownSharedPool(BM_SharedPool *const sp);
+RC resizeSharedPool(BM_SharedPool *const sp, const int newNumPages);
+RC attachBufferPool(BM_BufferPool *const bm, BM_SharedPool *const sp,
+		const char *const pageFileName, const int maxPages);
+RC attachBufferPoolWithOptions(BM_BufferPool *const bm, BM_SharedPool *const sp,
+		const char *const pageFileName, const int maxPages,
+		const BM_PoolOptions *options);
+
 // Buffer Manager Interface Access Pages
 RC markDirty (BM_BufferPool *const bm, BM_PageHandle *const page);
 RC unpinPage (BM_BufferPool *const bm, BM_PageHandle *const page);
 RC forcePage (BM_BufferPool *const bm, BM_PageHandle *const page);
 RC pinPage (BM_BufferPool *const bm, BM_PageHandle *const page, 
 		const PageNumber pageNum);
+// Pin numPages pages at once, pages[i] gets pageNums[i]. The pages that are not
+// in the pool are read in one batch. Either all pages are pinned or none is.
+RC pinPages (BM_BufferPool *const bm, BM_PageHandle *const pages,
+		const PageNumber *const pageNums, const int numPages);
+RC unpinPages (BM_BufferPool *const bm, BM_PageHandle *const pages, const int numPages);
+
+// pinPage, pinPages and pinPageRing recording their call site, for pools that track
+// pins. Callers get them through the macros; define BM_NO_PIN_SITES to call the
+// functions directly. An unpin forgets the latest pin of the page taken through the
+// same handle.
+RC pinPageAt (BM_BufferPool *const bm, BM_PageHandle *const page,
+		const PageNumber pageNum, const char *file, int line);
+RC pinPagesAt (BM_BufferPool *const bm, BM_PageHandle *const pages,
+		const PageNumber *const pageNums, const int numPages, const char *file, int line);
+
+// Buffer Manager Interface Access Rings
+// A page that is not in the pool is read into the frame the ring used
+// numFrames misses ago, as long as that frame still holds the ring's page
+// and is unpinned. Pages already in the pool are pinned as usual.
+RC initAccessRing (BM_AccessRing *const ring, const int numFrames);
+RC shutdownAccessRing (BM_AccessRing *const ring);
+RC pinPageRing (BM_BufferPool *const bm, BM_PageHandle *const page,
+		const PageNumber pageNum, BM_AccessRing *const ring);
+RC pinPageRingAt (BM_BufferPool *const bm, BM_PageHandle *const page,
+		const PageNumber pageNum, BM_AccessRing *const ring, const char *file, int line);
+#ifndef BM_NO_PIN_SITES
+#define pinPage(bm, page, pageNum) pinPageAt((bm), (page), (pageNum), __FILE__, __LINE__)
+#define pinPages(bm, pages, pageNums, numPages) \
+	pinPagesAt((bm), (pages), (pageNums), (numPages), __FILE__, __LINE__)
+#define pinPageRing(bm, page, pageNum, ring) \
+	pinPageRingAt((bm), (page), (pageNum), (ring), __FILE__, __LINE__)
+#endif
 
 // Statistics Interface
 PageNumber *getFrameContents (BM_BufferPool *const bm);
 bool *getDirtyFlags (BM_BufferPool *const bm);
 int *getFixCounts (BM_BufferPool *const bm);
+// Number of pins of a page still held, the call sites of up to maxSites of them
+// are copied to sites in the order they were taken
+int getPinSites (BM_BufferPool *const bm, const PageNumber pageNum, BM_PinSite *sites, int maxSites);
 int getNumReadIO (BM_BufferPool *const bm);
 int getNumWriteIO (BM_BufferPool *const bm);
+RC getPoolStats (BM_BufferPool *const bm, BM_PoolStats *stats);
+RC resetPoolStats (BM_BufferPool *const bm);
+int getPoolFramesUsed (BM_BufferPool *const bm);
+RC dumpPoolTrace (BM_BufferPool *const bm, const char *const fileName);
 
 #endif
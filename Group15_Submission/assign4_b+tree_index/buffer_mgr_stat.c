@@ -1,11 +1,13 @@
 #include "buffer_mgr_stat.h"
 #include "buffer_mgr.h"
+#include "const.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 
 // local functions
 static void printStrat (BM_BufferPool *const bm);
+static char *strategyName (ReplacementStrategy strategy);
 
 // external functions
 void 
@@ -78,6 +80,71 @@ sprintPageContent (BM_PageHandle *const page)
 	return message;
 }
 
+void
+printPoolStats (BM_BufferPool *const bm)
+{
+	char *message = sprintPoolStats(bm);
+
+	printf("%s", message);
+	free(message);
+}
+
+char *
+sprintPoolStats (BM_BufferPool *const bm)
+{
+	BM_PoolStats stats;
+	char *message;
+	int pos = 0;
+	int i;
+
+	message = (char *) malloc(1024);
+	if (getPoolStats(bm, &stats) != RC_OK)
+	{
+		sprintf(message, "{no statistics}\n");
+		return message;
+	}
+
+	pos += sprintf(message + pos, "{%s %i}: hits %li, misses %li, hit ratio %.4f\n",
+			strategyName(bm->strategy), bm->numPages, stats.hits, stats.misses, stats.hitRatio);
+	pos += sprintf(message + pos, "evictions:");
+	for (i = 0; i < NUM_REPLACEMENT_STRATEGIES; i++)
+		pos += sprintf(message + pos, " %s %li", strategyName(i), stats.evictions[i]);
+	pos += sprintf(message + pos, ", dirty write-backs %li\n", stats.dirtyWriteBacks);
+	pos += sprintf(message + pos, "pinned %i (high-water %i), avg pin duration %.2f us over %li pins\n",
+			stats.pinnedFrames, stats.pinnedHighWater, stats.avgPinDurationUs, stats.completedPins);
+	pos += sprintf(message + pos, "frame scans: lookup avg %.2f, victim avg %.2f (max %i over %li searches)\n",
+			(stats.hits + stats.misses) ? (double) stats.lookupScanSteps / (stats.hits + stats.misses) : 0.0,
+			stats.victimScans ? (double) stats.victimScanSteps / stats.victimScans : 0.0,
+			stats.maxVictimScan, stats.victimScans);
+	if (stats.policySwitches > 0)
+		pos += sprintf(message + pos, "strategy switched %li times\n", stats.policySwitches);
+	if (stats.tierStores > 0)
+		pos += sprintf(message + pos, "compressed tier: %li pages stored, %li misses served\n",
+				stats.tierStores, stats.tierHits);
+
+	return message;
+}
+
+char *
+strategyName (ReplacementStrategy strategy)
+{
+	switch (strategy)
+	{
+	case RS_FIFO:
+		return "FIFO";
+	case RS_LRU:
+		return "LRU";
+	case RS_CLOCK:
+		return "CLOCK";
+	case RS_LFU:
+		return "LFU";
+	case RS_LRU_K:
+		return "LRU-K";
+	default:
+		return "?";
+	}
+}
+
 void
 printStrat (BM_BufferPool *const bm)
 {
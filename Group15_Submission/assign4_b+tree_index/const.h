@@ -11,12 +11,32 @@
 /* Schema Stringify delimiter */
 #define DELIMITER ((char *) ",")
 
+/* Page file the record manager keeps its catalog of tables in */
+#define CATALOG_FILE_NAME "rm_catalog.bin"
+
 /* Per table buffer size */
 #define PER_TBL_BUF_SIZE 10
 
 /* Per table index size */
 #define PER_IDX_BUF_SIZE 10
 
+/* Priority of index pages in a shared buffer pool, table pages have priority 0 */
+#define INDEX_POOL_PRIORITY 1
+
+/* Frames recycled by a sequential read through an access ring */
+#define SCAN_RING_SIZE 4
+
+/* Pages a worker of a parallel scan takes at a time, and records it may queue up */
+#define PARALLEL_SCAN_CHUNK_PAGES 16
+#define PARALLEL_SCAN_QUEUE_ROWS 1024
+
+/* Steps of free space a free-space map page of a table tells apart, and data pages it keeps track of */
+#define FSM_LEVELS 16
+#define FSM_PAGES_PER_MAP (PAGE_SIZE * 2)
+
+/* Keys per node of the B+ tree index of a table attribute */
+#define TABLE_INDEX_ORDER 64
+
 /* Page header length */
 #define PAGE_HEADER_LEN 11
 
@@ -29,6 +29,7 @@ typedef int RC;
 #define RC_STRATEGY_NOT_SUPPORTED 101
 #define RC_ERROR_NO_PAGE 102
 #define RC_ERROR_NOT_FREE_FRAME 103
+#define RC_BUFFER_POOL_IN_USE 104
 
 #define RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE 200
 #define RC_RM_EXPR_RESULT_IS_NOT_BOOLEAN 201
@@ -68,7 +69,7 @@ extern void printError (RC error);
 extern char *errorMessage (RC error);
 
 
-#define newArray(type, size) (type *) malloc(sizeof(type) * size)
+#define newArray(type, size) (type *) malloc(sizeof(type) * (size))
 #define newCleanArray(type, size) (type *) calloc(size, sizeof(type))
 #define new(type) newArray(type, 1)
 #define newStr(size) newCleanArray(char, size + 1) // +1 for \0 terminator
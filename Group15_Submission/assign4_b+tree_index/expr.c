@@ -1,11 +1,21 @@
 #include <string.h>
 #include <stdlib.h>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define EXPR_AVX2_DISPATCH
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #include "dberror.h"
 #include "record_mgr.h"
 #include "expr.h"
 #include "tables.h"
 
+// Offset of an attribute in Record->data, from the record manager. Not in record_mgr.h
+// since rm_serializer.c has a static function of the same name.
+extern RC attrOffset (Schema *schema, int attrNum, int *result);
+
 // implementations
 RC 
 valueEquals (Value *left, Value *right, Value *result)
@@ -74,6 +84,7 @@ boolAnd (Value *left, Value *right, Value *result)
 {
 	if (left->dt != DT_BOOL || right->dt != DT_BOOL)
 		THROW(RC_RM_BOOLEAN_EXPR_ARG_IS_NOT_BOOLEAN, "boolean AND requires boolean inputs");
+	result->dt = DT_BOOL;
 	result->v.boolV = (left->v.boolV && right->v.boolV);
 
 	return RC_OK;
@@ -84,6 +95,7 @@ boolOr (Value *left, Value *right, Value *result)
 {
 	if (left->dt != DT_BOOL || right->dt != DT_BOOL)
 		THROW(RC_RM_BOOLEAN_EXPR_ARG_IS_NOT_BOOLEAN, "boolean OR requires boolean inputs");
+	result->dt = DT_BOOL;
 	result->v.boolV = (left->v.boolV || right->v.boolV);
 
 	return RC_OK;
@@ -188,3 +200,512 @@ freeVal (Value *val)
 	free(val);
 }
 
+
+/* Compiled conditions
+ *
+ * compileExpr flattens an expression tree into a list of instructions that
+ * run in order. Instruction i leaves its result in register i, so the last
+ * instruction holds the value of the whole condition. Attribute offsets and
+ * types are looked up once when compiling: a comparison reads the raw bytes
+ * of the record, or of a constant copied into the program, and an
+ * instruction already knows which type it compares.
+ */
+typedef enum ProgOpcode {
+	PROG_EQ_INT,
+	PROG_LT_INT,
+	PROG_EQ_FLOAT,
+	PROG_LT_FLOAT,
+	PROG_EQ_BOOL,
+	PROG_LT_BOOL,
+	PROG_EQ_STRING,
+	PROG_LT_STRING,
+	PROG_TEST_BOOL,
+	PROG_AND,
+	PROG_OR,
+	PROG_NOT
+} ProgOpcode;
+
+// Where a comparison reads a value: base 0 is the record data, base 1 the constants
+typedef struct ProgOperand {
+	int base;
+	int offset;
+	int length;   // bytes a string may take, up to its first '\0'
+	int attrNum;  // attribute read from the record data, -1 for a constant
+} ProgOperand;
+
+typedef struct ProgInstr {
+	ProgOpcode opcode;
+	ProgOperand left, right;  // compared values, left alone is tested by PROG_TEST_BOOL
+	int leftReg, rightReg;    // inputs of AND, OR and NOT
+} ProgInstr;
+
+struct ExprProgram {
+	ProgInstr instr[EXPR_MAX_INSTRUCTIONS];
+	int numInstr;
+	char *constants;
+	int constantsSize;
+};
+
+static bool
+addConstant (ExprProgram *program, const void *bytes, int length, ProgOperand *operand)
+{
+	char *grown = (char *) realloc(program->constants, program->constantsSize + length);
+	if (grown == NULL)
+		return false;
+	memcpy(grown + program->constantsSize, bytes, length);
+	program->constants = grown;
+	operand->base = 1;
+	operand->attrNum = -1;
+	operand->offset = program->constantsSize;
+	operand->length = length;
+	program->constantsSize += length;
+	return true;
+}
+
+// Resolve a constant or an attribute to where its value is, false if it is neither
+static bool
+compileOperand (Expr *expr, Schema *schema, ExprProgram *program, ProgOperand *operand, DataType *type)
+{
+	if (expr->type == EXPR_ATTRREF)
+	{
+		int attrNum = expr->expr.attrRef;
+		if (schema == NULL || attrNum < 0 || attrNum >= schema->numAttr)
+			return false;
+		*type = schema->dataTypes[attrNum];
+		operand->base = 0;
+		operand->attrNum = attrNum;
+		operand->length = schema->typeLength[attrNum];
+		return attrOffset(schema, attrNum, &operand->offset) == RC_OK;
+	}
+	if (expr->type == EXPR_CONST)
+	{
+		Value *cons = expr->expr.cons;
+		*type = cons->dt;
+		switch (cons->dt)
+		{
+		case DT_INT:
+			return addConstant(program, &cons->v.intV, sizeof(int), operand);
+		case DT_FLOAT:
+			return addConstant(program, &cons->v.floatV, sizeof(float), operand);
+		case DT_BOOL:
+			return addConstant(program, &cons->v.boolV, sizeof(bool), operand);
+		case DT_STRING:
+			return addConstant(program, cons->v.stringV, strlen(cons->v.stringV) + 1, operand);
+		}
+	}
+	return false;
+}
+
+static int
+emit (ExprProgram *program, ProgInstr *instr)
+{
+	if (program->numInstr == EXPR_MAX_INSTRUCTIONS)
+		return -1;
+	program->instr[program->numInstr] = *instr;
+	return program->numInstr++;
+}
+
+// Compile the instructions of a boolean expression, returns its register or -1
+static int
+compileNode (Expr *expr, Schema *schema, ExprProgram *program)
+{
+	ProgInstr instr;
+	DataType leftType, rightType;
+	memset(&instr, 0, sizeof(ProgInstr));
+
+	if (expr->type != EXPR_OP)
+	{
+		if (!compileOperand(expr, schema, program, &instr.left, &leftType) || leftType != DT_BOOL)
+			return -1;
+		instr.opcode = PROG_TEST_BOOL;
+		return emit(program, &instr);
+	}
+
+	Operator *op = expr->expr.op;
+	switch (op->type)
+	{
+	case OP_BOOL_NOT:
+		instr.opcode = PROG_NOT;
+		if ((instr.leftReg = compileNode(op->args[0], schema, program)) == -1)
+			return -1;
+		return emit(program, &instr);
+	case OP_BOOL_AND:
+	case OP_BOOL_OR:
+		instr.opcode = (op->type == OP_BOOL_AND) ? PROG_AND : PROG_OR;
+		if ((instr.leftReg = compileNode(op->args[0], schema, program)) == -1 ||
+				(instr.rightReg = compileNode(op->args[1], schema, program)) == -1)
+			return -1;
+		return emit(program, &instr);
+	case OP_COMP_EQUAL:
+	case OP_COMP_SMALLER:
+		// Values of different types are an error evalExpr reports
+		if (!compileOperand(op->args[0], schema, program, &instr.left, &leftType) ||
+				!compileOperand(op->args[1], schema, program, &instr.right, &rightType) ||
+				leftType != rightType)
+			return -1;
+		switch (leftType)
+		{
+		case DT_INT:
+			instr.opcode = (op->type == OP_COMP_EQUAL) ? PROG_EQ_INT : PROG_LT_INT;
+			break;
+		case DT_FLOAT:
+			instr.opcode = (op->type == OP_COMP_EQUAL) ? PROG_EQ_FLOAT : PROG_LT_FLOAT;
+			break;
+		case DT_BOOL:
+			instr.opcode = (op->type == OP_COMP_EQUAL) ? PROG_EQ_BOOL : PROG_LT_BOOL;
+			break;
+		case DT_STRING:
+			instr.opcode = (op->type == OP_COMP_EQUAL) ? PROG_EQ_STRING : PROG_LT_STRING;
+			break;
+		default:
+			return -1;
+		}
+		return emit(program, &instr);
+	}
+	return -1;
+}
+
+ExprProgram *
+compileExpr (Expr *expr, Schema *schema)
+{
+	if (expr == NULL)
+		return NULL;
+
+	ExprProgram *program = (ExprProgram *) malloc(sizeof(ExprProgram));
+	if (program == NULL)
+		return NULL;
+	program->numInstr = 0;
+	program->constants = NULL;
+	program->constantsSize = 0;
+
+	if (compileNode(expr, schema, program) == -1)
+	{
+		freeExprProgram(program);
+		return NULL;
+	}
+	return program;
+}
+
+// strcmp of two strings that end at their first '\0' or after length bytes
+static int
+compareStrings (const char *left, int leftLength, const char *right, int rightLength)
+{
+	int i = 0;
+	while (i < leftLength && i < rightLength && left[i] != '\0' && left[i] == right[i])
+		i++;
+	int l = (i < leftLength) ? (unsigned char) left[i] : 0;
+	int r = (i < rightLength) ? (unsigned char) right[i] : 0;
+	return l - r;
+}
+
+bool
+runExprProgram (ExprProgram *program, char *data)
+{
+	bool reg[EXPR_MAX_INSTRUCTIONS];
+	const char *bases[2] = { data, program->constants };
+
+	for (int i = 0; i < program->numInstr; i++)
+	{
+		ProgInstr *in = &program->instr[i];
+		const char *l = bases[in->left.base] + in->left.offset;
+		const char *r = bases[in->right.base] + in->right.offset;
+		int li, ri;
+		float lf, rf;
+		bool lb, rb;
+
+		switch (in->opcode)
+		{
+		case PROG_EQ_INT:
+		case PROG_LT_INT:
+			memcpy(&li, l, sizeof(int));
+			memcpy(&ri, r, sizeof(int));
+			reg[i] = (in->opcode == PROG_EQ_INT) ? (li == ri) : (li < ri);
+			break;
+		case PROG_EQ_FLOAT:
+		case PROG_LT_FLOAT:
+			memcpy(&lf, l, sizeof(float));
+			memcpy(&rf, r, sizeof(float));
+			reg[i] = (in->opcode == PROG_EQ_FLOAT) ? (lf == rf) : (lf < rf);
+			break;
+		case PROG_EQ_BOOL:
+		case PROG_LT_BOOL:
+			memcpy(&lb, l, sizeof(bool));
+			memcpy(&rb, r, sizeof(bool));
+			reg[i] = (in->opcode == PROG_EQ_BOOL) ? (lb == rb) : (lb < rb);
+			break;
+		case PROG_EQ_STRING:
+			reg[i] = compareStrings(l, in->left.length, r, in->right.length) == 0;
+			break;
+		case PROG_LT_STRING:
+			reg[i] = compareStrings(l, in->left.length, r, in->right.length) < 0;
+			break;
+		case PROG_TEST_BOOL:
+			memcpy(&lb, l, sizeof(bool));
+			reg[i] = lb;
+			break;
+		case PROG_AND:
+			reg[i] = reg[in->leftReg] && reg[in->rightReg];
+			break;
+		case PROG_OR:
+			reg[i] = reg[in->leftReg] || reg[in->rightReg];
+			break;
+		case PROG_NOT:
+			reg[i] = !reg[in->leftReg];
+			break;
+		}
+	}
+	return reg[program->numInstr - 1];
+}
+
+void
+freeExprProgram (ExprProgram *program)
+{
+	if (program == NULL)
+		return;
+	free(program->constants);
+	free(program);
+}
+
+/* Column kernels
+ *
+ * runExprProgramColumns runs a program over many records at once. Every
+ * register is a bitmap with a bit per record, an instruction fills all of
+ * it before the next one runs. An operand is read as a column: attributes
+ * from the columns the caller passes, constants as a column with stride 0.
+ * Comparing a packed DT_INT or DT_FLOAT column with a constant, on either side,
+ * uses AVX2 when the processor has it, checked at run time, and SSE2 otherwise,
+ * everything else a plain loop. A constant on the left is compared the other
+ * way round, const < attr as attr > const.
+ */
+#define EXPR_BATCH_WORDS (EXPR_BATCH_ROWS / 64)
+
+// How the values of a column compare with the constant in the vector kernels
+typedef enum VectorCompare {
+	VECTOR_EQUAL,
+	VECTOR_SMALLER,
+	VECTOR_GREATER
+} VectorCompare;
+
+#ifdef EXPR_AVX2_DISPATCH
+// Built for AVX2 whatever the compiler targets, only called when __builtin_cpu_supports
+// finds it
+__attribute__((target("avx2"))) static int
+compareIntsAvx2 (VectorCompare compare, const char *column, int value, int count, uint64_t *bits)
+{
+	int i = 0;
+	__m256i constant = _mm256_set1_epi32(value);
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256i values = _mm256_loadu_si256((const __m256i *) (column + i * sizeof(int)));
+		__m256i match = (compare == VECTOR_EQUAL) ? _mm256_cmpeq_epi32(values, constant)
+				: (compare == VECTOR_SMALLER) ? _mm256_cmpgt_epi32(constant, values)
+				: _mm256_cmpgt_epi32(values, constant);
+		bits[i / 64] |= (uint64_t) _mm256_movemask_ps(_mm256_castsi256_ps(match)) << (i % 64);
+	}
+	return i;
+}
+
+__attribute__((target("avx2"))) static int
+compareFloatsAvx2 (VectorCompare compare, const char *column, float value, int count, uint64_t *bits)
+{
+	int i = 0;
+	__m256 constant = _mm256_set1_ps(value);
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256 values = _mm256_loadu_ps((const float *) (column + i * sizeof(float)));
+		__m256 match = (compare == VECTOR_EQUAL) ? _mm256_cmp_ps(values, constant, _CMP_EQ_OQ)
+				: (compare == VECTOR_SMALLER) ? _mm256_cmp_ps(values, constant, _CMP_LT_OQ)
+				: _mm256_cmp_ps(values, constant, _CMP_GT_OQ);
+		bits[i / 64] |= (uint64_t) _mm256_movemask_ps(match) << (i % 64);
+	}
+	return i;
+}
+#endif
+
+// Compare count packed values with a constant, returns how many were done. The
+// lanes of one vector never straddle two words of the bitmap.
+static int
+compareIntsVector (VectorCompare compare, const char *column, int value, int count, uint64_t *bits)
+{
+	int i = 0;
+#ifdef EXPR_AVX2_DISPATCH
+	if (__builtin_cpu_supports("avx2"))
+		return compareIntsAvx2(compare, column, value, count, bits);
+#endif
+#if defined(__SSE2__)
+	__m128i constant = _mm_set1_epi32(value);
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128i values = _mm_loadu_si128((const __m128i *) (column + i * sizeof(int)));
+		__m128i match = (compare == VECTOR_EQUAL) ? _mm_cmpeq_epi32(values, constant)
+				: (compare == VECTOR_SMALLER) ? _mm_cmplt_epi32(values, constant)
+				: _mm_cmpgt_epi32(values, constant);
+		bits[i / 64] |= (uint64_t) _mm_movemask_ps(_mm_castsi128_ps(match)) << (i % 64);
+	}
+#endif
+	return i;
+}
+
+static int
+compareFloatsVector (VectorCompare compare, const char *column, float value, int count, uint64_t *bits)
+{
+	int i = 0;
+#ifdef EXPR_AVX2_DISPATCH
+	if (__builtin_cpu_supports("avx2"))
+		return compareFloatsAvx2(compare, column, value, count, bits);
+#endif
+#if defined(__SSE2__)
+	__m128 constant = _mm_set1_ps(value);
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 values = _mm_loadu_ps((const float *) (column + i * sizeof(float)));
+		__m128 match = (compare == VECTOR_EQUAL) ? _mm_cmpeq_ps(values, constant)
+				: (compare == VECTOR_SMALLER) ? _mm_cmplt_ps(values, constant)
+				: _mm_cmpgt_ps(values, constant);
+		bits[i / 64] |= (uint64_t) _mm_movemask_ps(match) << (i % 64);
+	}
+#endif
+	return i;
+}
+
+// Fill the bitmap of one comparison for count records
+static void
+compareColumns (ProgInstr *in, const char *l, int lStride, const char *r, int rStride, int count, uint64_t *bits)
+{
+	int i = 0;
+	int li, ri;
+	float lf, rf;
+	bool lb, rb;
+
+	memset(bits, 0, sizeof(uint64_t) * ((count + 63) / 64));
+
+	// A packed column against a constant goes through the vector kernels first, with
+	// the constant on the left the column is the one compared
+	bool isInt = (in->opcode == PROG_EQ_INT || in->opcode == PROG_LT_INT);
+	bool isFloat = (in->opcode == PROG_EQ_FLOAT || in->opcode == PROG_LT_FLOAT);
+	bool isEqual = (in->opcode == PROG_EQ_INT || in->opcode == PROG_EQ_FLOAT);
+	const char *column = NULL, *constant = NULL;
+	VectorCompare compare = VECTOR_EQUAL;
+	int width = isFloat ? (int) sizeof(float) : (int) sizeof(int);
+
+	if (rStride == 0 && lStride == width)
+	{
+		column = l;
+		constant = r;
+		compare = isEqual ? VECTOR_EQUAL : VECTOR_SMALLER;
+	}
+	else if (lStride == 0 && rStride == width)
+	{
+		column = r;
+		constant = l;
+		compare = isEqual ? VECTOR_EQUAL : VECTOR_GREATER;
+	}
+	if (column != NULL && isInt)
+	{
+		memcpy(&ri, constant, sizeof(int));
+		i = compareIntsVector(compare, column, ri, count, bits);
+	}
+	else if (column != NULL && isFloat)
+	{
+		memcpy(&rf, constant, sizeof(float));
+		i = compareFloatsVector(compare, column, rf, count, bits);
+	}
+
+	for (; i < count; i++)
+	{
+		const char *lv = l + i * lStride;
+		const char *rv = r + i * rStride;
+		bool match = false;
+
+		switch (in->opcode)
+		{
+		case PROG_EQ_INT:
+		case PROG_LT_INT:
+			memcpy(&li, lv, sizeof(int));
+			memcpy(&ri, rv, sizeof(int));
+			match = (in->opcode == PROG_EQ_INT) ? (li == ri) : (li < ri);
+			break;
+		case PROG_EQ_FLOAT:
+		case PROG_LT_FLOAT:
+			memcpy(&lf, lv, sizeof(float));
+			memcpy(&rf, rv, sizeof(float));
+			match = (in->opcode == PROG_EQ_FLOAT) ? (lf == rf) : (lf < rf);
+			break;
+		case PROG_EQ_BOOL:
+		case PROG_LT_BOOL:
+			memcpy(&lb, lv, sizeof(bool));
+			memcpy(&rb, rv, sizeof(bool));
+			match = (in->opcode == PROG_EQ_BOOL) ? (lb == rb) : (lb < rb);
+			break;
+		case PROG_EQ_STRING:
+			match = compareStrings(lv, in->left.length, rv, in->right.length) == 0;
+			break;
+		case PROG_LT_STRING:
+			match = compareStrings(lv, in->left.length, rv, in->right.length) < 0;
+			break;
+		case PROG_TEST_BOOL:
+			memcpy(&lb, lv, sizeof(bool));
+			match = lb;
+			break;
+		default:
+			break;
+		}
+		if (match)
+			bits[i / 64] |= (uint64_t) 1 << (i % 64);
+	}
+}
+
+// Run a program over up to EXPR_BATCH_ROWS records, from record first of the columns on
+static void
+runColumnsChunk (ExprProgram *program, const char **columns, const int *strides, int first, int count, uint64_t *selection)
+{
+	uint64_t reg[EXPR_MAX_INSTRUCTIONS][EXPR_BATCH_WORDS];
+	int words = (count + 63) / 64;
+
+	for (int i = 0; i < program->numInstr; i++)
+	{
+		ProgInstr *in = &program->instr[i];
+		switch (in->opcode)
+		{
+		case PROG_AND:
+			for (int w = 0; w < words; w++)
+				reg[i][w] = reg[in->leftReg][w] & reg[in->rightReg][w];
+			break;
+		case PROG_OR:
+			for (int w = 0; w < words; w++)
+				reg[i][w] = reg[in->leftReg][w] | reg[in->rightReg][w];
+			break;
+		case PROG_NOT:
+			for (int w = 0; w < words; w++)
+				reg[i][w] = ~reg[in->leftReg][w];
+			// Records past count stay unselected
+			if (count % 64 != 0)
+				reg[i][words - 1] &= ((uint64_t) 1 << (count % 64)) - 1;
+			break;
+		default:
+		{
+			int lStride = (in->left.base == 0) ? strides[in->left.attrNum] : 0;
+			int rStride = (in->right.base == 0) ? strides[in->right.attrNum] : 0;
+			const char *l = (in->left.base == 0) ? columns[in->left.attrNum] + first * lStride
+					: program->constants + in->left.offset;
+			// PROG_TEST_BOOL has no right operand, it is given the left one
+			const char *r = (in->opcode == PROG_TEST_BOOL) ? l
+					: (in->right.base == 0) ? columns[in->right.attrNum] + first * rStride
+					: program->constants + in->right.offset;
+			compareColumns(in, l, lStride, r, rStride, count, reg[i]);
+		}
+		break;
+		}
+	}
+	memcpy(selection, reg[program->numInstr - 1], sizeof(uint64_t) * words);
+}
+
+void
+runExprProgramColumns (ExprProgram *program, const char **columns, const int *strides, int count, uint64_t *selection)
+{
+	for (int first = 0; first < count; first += EXPR_BATCH_ROWS)
+	{
+		int n = (count - first < EXPR_BATCH_ROWS) ? count - first : EXPR_BATCH_ROWS;
+		runColumnsChunk(program, columns, strides, first, n, selection + first / 64);
+	}
+}
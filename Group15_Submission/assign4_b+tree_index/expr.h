@@ -1,6 +1,7 @@
 #ifndef EXPR_H
 #define EXPR_H
 
+#include <stdint.h>
 #include "dberror.h"
 #include "tables.h"
 
@@ -44,6 +45,23 @@ extern RC evalExpr (Record *record, Schema *schema, Expr *expr, Value **result);
 extern RC freeExpr (Expr *expr);
 extern void freeVal(Value *val);
 
+// A condition compiled for one schema. compileExpr returns NULL for what it can
+// not compile, such as comparisons of values of different types, and evalExpr
+// still handles those. runExprProgram takes the data of a record and allocates
+// nothing.
+#define EXPR_MAX_INSTRUCTIONS 64
+typedef struct ExprProgram ExprProgram;
+extern ExprProgram *compileExpr (Expr *expr, Schema *schema);
+extern bool runExprProgram (ExprProgram *program, char *data);
+extern void freeExprProgram (ExprProgram *program);
+
+// Run a program over count records at once. The value of attribute a of record
+// i is at columns[a] + i * strides[a], a program reads only the attributes it
+// refers to. Sets bit i of selection, bit i % 64 of word i / 64, for every
+// record that satisfies the condition and clears the others.
+#define EXPR_BATCH_ROWS 512
+extern void runExprProgramColumns (ExprProgram *program, const char **columns, const int *strides, int count, uint64_t *selection);
+
 
 #define CPVAL(_result,_input)						\
   do {									\
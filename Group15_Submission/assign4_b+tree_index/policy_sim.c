@@ -0,0 +1,239 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "policy_sim.h"
+
+// Strategies replayed by the simulator, add new ones here and in chooseVictim
+const ReplacementStrategy psStrategies[PS_NUM_STRATEGIES] = {
+	RS_FIFO, RS_LRU, RS_CLOCK, RS_LFU, RS_LRU_K
+};
+
+// One simulated page frame
+typedef struct SimFrame
+{
+	long long key;    // Page held in the frame
+	int chain;        // Next frame in the same hash bucket
+	int prev, next;   // Neighbours in the LRU list, least recently used first
+	int refBit;       // Second chance bit of CLOCK
+	long refCount;    // Hits since the page was loaded, used by LFU
+	long lastAccess;  // Time of the latest access
+	long prevAccess;  // Time of the access before that, 0 if there was none (LRU-2)
+	long loadedAt;    // Time the page was loaded, breaks ties
+} SimFrame;
+
+typedef struct SimMgmt
+{
+	SimFrame *frames;
+	int *buckets;     // Hash of the key to the first frame of a chain
+	int numBuckets;   // Power of two, at least twice the number of frames
+	int usedFrames;   // Frames filled so far, they fill up in order
+	int hand;         // Next FIFO victim, or the clock hand
+	int lruHead, lruTail;
+	long now;         // Logical time, one tick per access
+} SimMgmt;
+
+const char *psStrategyName (ReplacementStrategy strategy)
+{
+	switch (strategy)
+	{
+	case RS_FIFO: return "FIFO";
+	case RS_LRU: return "LRU";
+	case RS_CLOCK: return "CLOCK";
+	case RS_LFU: return "LFU";
+	case RS_LRU_K: return "LRU-2";
+	default: return "?";
+	}
+}
+
+static int bucketOf (SimMgmt *sim, long long key)
+{
+	unsigned long long h = (unsigned long long) key * 0x9E3779B97F4A7C15ull;
+	return (int) ((h >> 32) & (unsigned long long) (sim->numBuckets - 1));
+}
+
+static int findKey (SimMgmt *sim, long long key)
+{
+	int index = sim->buckets[bucketOf(sim, key)];
+	while (index != -1 && sim->frames[index].key != key)
+		index = sim->frames[index].chain;
+	return index;
+}
+
+static void unlinkKey (SimMgmt *sim, int index)
+{
+	int *link = &sim->buckets[bucketOf(sim, sim->frames[index].key)];
+	while (*link != index)
+		link = &sim->frames[*link].chain;
+	*link = sim->frames[index].chain;
+}
+
+static void lruRemove (SimMgmt *sim, int index)
+{
+	SimFrame *f = &sim->frames[index];
+	if (f->prev != -1) sim->frames[f->prev].next = f->next; else sim->lruHead = f->next;
+	if (f->next != -1) sim->frames[f->next].prev = f->prev; else sim->lruTail = f->prev;
+}
+
+static void lruAppend (SimMgmt *sim, int index)
+{
+	SimFrame *f = &sim->frames[index];
+	f->prev = sim->lruTail;
+	f->next = -1;
+	if (sim->lruTail != -1) sim->frames[sim->lruTail].next = index; else sim->lruHead = index;
+	sim->lruTail = index;
+}
+
+// Pick the frame to replace, all frames are in use
+static int chooseVictim (PS_Cache *const cache, SimMgmt *sim)
+{
+	int victim = 0;
+
+	switch (cache->strategy)
+	{
+	case RS_FIFO:
+		// Frames were filled in order and are replaced in place, so the hand is the oldest page
+		victim = sim->hand;
+		sim->hand = (sim->hand + 1) % cache->numFrames;
+		break;
+	case RS_LRU:
+		victim = sim->lruHead;
+		break;
+	case RS_CLOCK:
+		while (sim->frames[sim->hand].refBit)
+		{
+			sim->frames[sim->hand].refBit = 0;
+			sim->hand = (sim->hand + 1) % cache->numFrames;
+		}
+		victim = sim->hand;
+		sim->hand = (sim->hand + 1) % cache->numFrames;
+		break;
+	case RS_LFU:
+		for (int i = 1; i < cache->numFrames; i++)
+		{
+			SimFrame *f = &sim->frames[i], *v = &sim->frames[victim];
+			if (f->refCount < v->refCount || (f->refCount == v->refCount && f->loadedAt < v->loadedAt))
+				victim = i;
+		}
+		break;
+	case RS_LRU_K:
+		// Largest backward 2-distance: pages seen once go first, the oldest of them first
+		for (int i = 1; i < cache->numFrames; i++)
+		{
+			SimFrame *f = &sim->frames[i], *v = &sim->frames[victim];
+			if (f->prevAccess < v->prevAccess || (f->prevAccess == v->prevAccess && f->lastAccess < v->lastAccess))
+				victim = i;
+		}
+		break;
+	}
+	return victim;
+}
+
+RC psInit (PS_Cache *const cache, const int numFrames, ReplacementStrategy strategy)
+{
+	if (cache == NULL || numFrames <= 0)
+		return RC_ERROR;
+
+	int numBuckets = 1;
+	while (numBuckets < 2 * numFrames)
+		numBuckets <<= 1;
+
+	SimMgmt *sim = malloc(sizeof(SimMgmt));
+	SimFrame *frames = malloc(sizeof(SimFrame) * numFrames);
+	int *buckets = malloc(sizeof(int) * numBuckets);
+	if (sim == NULL || frames == NULL || buckets == NULL)
+	{
+		free(sim);
+		free(frames);
+		free(buckets);
+		return RC_ERROR;
+	}
+
+	sim->frames = frames;
+	sim->buckets = buckets;
+	sim->numBuckets = numBuckets;
+	cache->strategy = strategy;
+	cache->numFrames = numFrames;
+	cache->mgmtData = sim;
+	psReset(cache);
+
+	return RC_OK;
+}
+
+RC psShutdown (PS_Cache *const cache)
+{
+	if (cache == NULL || cache->mgmtData == NULL)
+		return RC_ERROR;
+
+	SimMgmt *sim = (SimMgmt *) cache->mgmtData;
+	free(sim->frames);
+	free(sim->buckets);
+	free(sim);
+	cache->mgmtData = NULL;
+
+	return RC_OK;
+}
+
+void psReset (PS_Cache *const cache)
+{
+	SimMgmt *sim = (SimMgmt *) cache->mgmtData;
+
+	for (int i = 0; i < sim->numBuckets; i++)
+		sim->buckets[i] = -1;
+	sim->usedFrames = 0;
+	sim->hand = 0;
+	sim->lruHead = sim->lruTail = -1;
+	sim->now = 0;
+	cache->accesses = 0;
+	cache->hits = 0;
+}
+
+bool psAccess (PS_Cache *const cache, long long key)
+{
+	SimMgmt *sim = (SimMgmt *) cache->mgmtData;
+	SimFrame *f;
+	int index = findKey(sim, key);
+
+	sim->now++;
+	cache->accesses++;
+
+	if (index != -1)
+	{
+		f = &sim->frames[index];
+		cache->hits++;
+		f->refBit = 1;
+		f->refCount++;
+		f->prevAccess = f->lastAccess;
+		f->lastAccess = sim->now;
+		lruRemove(sim, index);
+		lruAppend(sim, index);
+		return true;
+	}
+
+	// Miss: take the next unused frame, or replace a page
+	if (sim->usedFrames < cache->numFrames)
+		index = sim->usedFrames++;
+	else
+	{
+		index = chooseVictim(cache, sim);
+		unlinkKey(sim, index);
+		lruRemove(sim, index);
+	}
+
+	f = &sim->frames[index];
+	f->key = key;
+	f->chain = sim->buckets[bucketOf(sim, key)];
+	sim->buckets[bucketOf(sim, key)] = index;
+	f->refBit = 1;
+	f->refCount = 0;
+	f->prevAccess = 0;
+	f->lastAccess = sim->now;
+	f->loadedAt = sim->now;
+	lruAppend(sim, index);
+
+	return false;
+}
+
+double psHitRatio (PS_Cache *const cache)
+{
+	return (cache->accesses > 0) ? (double) cache->hits / cache->accesses : 0.0;
+}
@@ -0,0 +1,39 @@
+#ifndef POLICY_SIM_H
+#define POLICY_SIM_H
+
+// Include return codes and methods for logging errors
+#include "dberror.h"
+
+// Include ReplacementStrategy
+#include "buffer_mgr.h"
+
+// A simulated buffer pool that only keeps track of which pages would be
+// resident under a replacement strategy. It holds no page data, so it can
+// replay an access trace or shadow a real pool at a different size.
+typedef struct PS_Cache {
+	ReplacementStrategy strategy;
+	int numFrames;
+	long accesses;
+	long hits;
+	void *mgmtData;
+} PS_Cache;
+
+// Pages of different files are told apart by combining both into one key
+#define PS_KEY(fileId, pageNum) (((long long) (fileId) << 32) | (unsigned int) (pageNum))
+
+// Number of strategies the simulator can replay, and the order they are reported in
+#define PS_NUM_STRATEGIES 5
+extern const ReplacementStrategy psStrategies[PS_NUM_STRATEGIES];
+extern const char *psStrategyName (ReplacementStrategy strategy);
+
+// Simulated pool handling
+RC psInit (PS_Cache *const cache, const int numFrames, ReplacementStrategy strategy);
+RC psShutdown (PS_Cache *const cache);
+void psReset (PS_Cache *const cache);
+
+// Access a page, returns true if it was resident (a hit)
+bool psAccess (PS_Cache *const cache, long long key);
+
+double psHitRatio (PS_Cache *const cache);
+
+#endif
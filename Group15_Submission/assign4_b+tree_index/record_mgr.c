@@ -2,9 +2,13 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <stdint.h>
+#include <limits.h>
+#include <pthread.h>
 #include "record_mgr.h"
 #include "buffer_mgr.h"
 #include "storage_mgr.h"
+#include "btree_mgr.h"
 
 #define RC_MEMORY_ALLOCATION_FAIL RC_ERROR
 // mac number of pages
@@ -30,428 +34,2829 @@ typedef struct RecordManager
 	RID recordID;
 	// condition for scanning the records in the table
 	Expr *condition;
+	// condition compiled for the table's schema, NULL if evalExpr has to handle it
+	ExprProgram *program;
+	// Columns nextBatch runs the compiled condition over, and the staging rows a
+	// slotted page is decoded into for that
+	const char **scanColumns;
+	int *scanStrides;
+	char *stage;
+	RID *stageIds;
+	int *stageSlots;
+	// Frames a scan recycles for the pages it reads, numFrames is 0 if it does not use a ring
+	BM_AccessRing scanRing;
+	// Pages of the table file in use, page 0 holds the table header
+	int numPages;
+	// How data pages store records, and for PAX pages where each minipage starts
+	RM_PageLayout layout;
+	int paxCapacity;
+	int paxNumAttr;
+	int *paxOffsets;
+	int *paxWidths;
+	// Worker threads of a parallel scan, NULL for a scan on the calling thread
+	struct ParallelScan *parallel;
+	// Attributes a scan loads, those it returns and those its condition reads, NULL for all
+	bool *scanAttrs;
+	// Those it returns, and the record it checks the condition on before it copies them
+	// out, NULL if it returns all of them
+	bool *returnAttrs;
+	char *scanRow;
+	// B+ tree indexes of an open table
+	int numIndexes;
+	struct TableIndex *indexes;
+	// Records a scan looks up in an index instead of reading every page, NULL if it does not
+	struct IndexScan *indexScan;
 } RecordManager;
 
-RecordManager *recordManager;
+// Buffer pool shared by all tables, NULL if every table gets its own pool
+static BM_SharedPool *sharedPool = NULL;
 
 /* helper functions */
-int getFreeSpace(char* data, int recordSize) {
-    for (int i = 0; i < PAGE_SIZE / recordSize; i++) {
-        if (data[i * recordSize] != '+') {
-            return i;
-        }
-    }
-    return -1;
-}
-
 void writeIntToPage(void** pageHandle, int value) {
     *(int*)(*pageHandle) = value;
     *pageHandle = *pageHandle + sizeof(int);
 }
 
-extern RC initRecordManager (void *mgmtData)
+/* Slotted pages
+ *
+ * Every page after the table header on page 0 starts with a SlotPageHeader and the
+ * slot directory. Records are stored from the end of the page down towards the
+ * directory. A RID names a slot rather than a position, so a page can move its
+ * records together to close the gaps deleted or shrunk records leave behind. A record
+ * that outgrows its page moves to another page and leaves a forwarding slot behind,
+ * its RID stays valid.
+ *
+ * On a page a string takes up its length plus a length prefix instead of the full
+ * typeLength it has in Record->data. A page that was never written is all zeros,
+ * which reads as a page without slots.
+ *
+ * The header keeps a bit per slot that is in use, so finding a free slot and skipping
+ * the empty ones in a scan works on 64 slots at a time.
+ */
+typedef struct SlotEntry
 {
-	// Initiliazing Storage Manager
-	initStorageManager();
-	printf("[init]: Record manager initialized success!\n");
-	return RC_OK;
-}
+    unsigned short offset;    // Where the record starts, 0 for an empty slot
+    unsigned short length;    // Bytes the record takes up on the page
+    unsigned short flags;     // SLOT_FORWARD or SLOT_MOVED_IN
+} SlotEntry;
 
-extern RC shutdownRecordManager ()
+// A page can not hold more slots than records of the smallest size, a RID each
+#define MAX_PAGE_SLOTS (PAGE_SIZE / (sizeof(RID) + sizeof(SlotEntry)))
+#define SLOT_MAP_WORDS ((MAX_PAGE_SLOTS + 63) / 64)
+
+typedef struct SlotPageHeader
 {
-	free(recordManager);
-	recordManager = NULL;
-	printf("[shutdown]: Record manager shutdown success!\n");
-	return RC_OK;
+    unsigned short numSlots;    // Entries in the slot directory
+    unsigned short dataStart;   // Offset of the lowest record, 0 if nothing was stored yet
+    unsigned short liveSlots;   // Slots in use
+    unsigned short recordBytes; // Bytes the records in use take up
+    uint64_t slotMap[SLOT_MAP_WORDS]; // Bit i % 64 of word i / 64 is set if slot i is in use
+} SlotPageHeader;
+
+// The slot only holds the RID of the slot the record moved to
+#define SLOT_FORWARD 1
+// The record moved here from another slot, the RID of that slot comes first
+#define SLOT_MOVED_IN 2
+
+#define PAGE_SLOTS(page) ((SlotEntry *) ((page) + sizeof(SlotPageHeader)))
+
+static int dataStartOf(char *page) {
+    SlotPageHeader *header = (SlotPageHeader *) page;
+    return header->dataStart == 0 ? PAGE_SIZE : header->dataStart;
 }
 
-extern RC createTable (char *name, Schema *schema)
-{
-	char data[PAGE_SIZE];
-	RC result;
-	char *pageHandle = data;
-	SM_FileHandle fileHandle;
-    if (name == NULL || schema == NULL) {
-        printf(name == NULL ? "Error: [createTable]: name is null.\n" : "Error: schema pointer is null.\n");
-        return RC_ERROR;
+// Every record takes up room for a RID, so it can always be turned into a forwarding slot
+static int slotBytes(int length) {
+    return length < (int) sizeof(RID) ? (int) sizeof(RID) : length;
+}
+
+// Index of the lowest set bit, the word must not be 0
+static int lowestBit(uint64_t word) {
+#if defined(__GNUC__)
+    return __builtin_ctzll(word);
+#else
+    int bit = 0;
+    while ((word & 1) == 0) {
+        word >>= 1;
+        bit++;
     }
+    return bit;
+#endif
+}
 
-    // Check if the file already exists
-    if (access(name, F_OK) != -1) {
-        // File exists, delete it
-        if (remove(name) != 0) {
-            return RC_FILE_NOT_FOUND;
+static bool slotInUse(SlotPageHeader *header, int slot) {
+    return (header->slotMap[slot / 64] >> (slot % 64)) & 1;
+}
+
+// The first slot in use from the given one on, numSlots if there is none
+static int nextUsedSlot(char *page, int slot) {
+    SlotPageHeader *header = (SlotPageHeader *) page;
+
+    for (int word = slot / 64; word * 64 < header->numSlots; word++) {
+        uint64_t bits = header->slotMap[word];
+        if (word == slot / 64) {
+            bits &= ~(uint64_t) 0 << (slot % 64);
+        }
+        if (bits != 0) {
+            return word * 64 + lowestBit(bits);
         }
     }
-	// Allocating memory space to the record manager custom data structure
-	recordManager = (RecordManager*) malloc(sizeof(RecordManager));
+    return header->numSlots;
+}
 
-    // initialized record manager memory to zero
-    memset(recordManager, 0, sizeof(RecordManager));
+// Bytes a record stored in the given slot could take up once the page is compacted,
+// including the space of the record the slot holds now
+static int pageFreeSpace(char *page, int slot) {
+    SlotPageHeader *header = (SlotPageHeader *) page;
+    int numSlots = (slot >= header->numSlots) ? slot + 1 : header->numSlots;
+    int free = PAGE_SIZE - (int) (sizeof(SlotPageHeader) + numSlots * sizeof(SlotEntry)) - header->recordBytes;
 
-	// Initalizing the Buffer Pool using LFU page replacement policy
-	initBufferPool(&recordManager->bufferPool, name, maxNumberOfPages, RS_LRU, NULL);
+    if (slot < header->numSlots && slotInUse(header, slot)) {
+        free += PAGE_SLOTS(page)[slot].length;
+    }
+    return free;
+}
 
-	// Setting pageHandle intial value
-	writeIntToPage(&pageHandle, 0);
-	writeIntToPage(&pageHandle, 1);
+// A slot for a new record, the first empty one or a new one at the end of the directory
+static int pageFreeSlot(char *page) {
+    SlotPageHeader *header = (SlotPageHeader *) page;
 
-	// Setting the number of attributes in pageHandle
-    writeIntToPage(&pageHandle, schema->numAttr);
+    // The first zero bit, the bits past the directory are all zero
+    for (int word = 0; word * 64 < header->numSlots; word++) {
+        if (header->slotMap[word] != ~(uint64_t) 0) {
+            int slot = word * 64 + lowestBit(~header->slotMap[word]);
+            return slot < header->numSlots ? slot : header->numSlots;
+        }
+    }
+    return header->numSlots;
+}
 
-	// Setting the Key Size of the attributes in pageHandle
-    writeIntToPage(&pageHandle, schema->keySize);
+static int compareSlotOffsets(const void *a, const void *b) {
+    return (int) ((const SlotEntry *) b)->offset - (int) ((const SlotEntry *) a)->offset;
+}
 
-	for(int k = 0; k < schema->numAttr; k++){
-		// Setting attribute name and it's data type
-		if (strlen(schema->attrNames[k]) >= attributeSize) {
-            printf("\n\n ERROR: [createTable]: attribute name is too long!!! \n\n");
-            return RC_ERROR;
-        }
-		strncpy(pageHandle, schema->attrNames[k], attributeSize);
-		pageHandle[attributeSize - 1] = '\0';
-		pageHandle = pageHandle + attributeSize;
-        writeIntToPage(&pageHandle, (int)schema->dataTypes[k]);
+// Move the records to the end of the page, closing the gaps between them. The slots
+// keep their numbers, only their offsets change.
+static void compactPage(char *page) {
+    SlotPageHeader *header = (SlotPageHeader *) page;
+    SlotEntry *slots = PAGE_SLOTS(page);
+    SlotEntry order[header->numSlots > 0 ? header->numSlots : 1];
+    int numRecords = 0;
+
+    // Remember the slot number in the flags of the copy
+    for (int i = nextUsedSlot(page, 0); i < header->numSlots; i = nextUsedSlot(page, i + 1)) {
+        order[numRecords] = slots[i];
+        order[numRecords].flags = i;
+        numRecords++;
+    }
 
-		// Setting length of datatype of the attribute
-		writeIntToPage(&pageHandle, (int) schema->typeLength[k]);
+    // Going from the highest offset down, a record never moves over one that is still to be moved
+    qsort(order, numRecords, sizeof(SlotEntry), compareSlotOffsets);
+    int end = PAGE_SIZE;
+    for (int i = 0; i < numRecords; i++) {
+        end -= order[i].length;
+        memmove(page + end, page + order[i].offset, order[i].length);
+        slots[order[i].flags].offset = end;
     }
+    header->dataStart = (end == PAGE_SIZE) ? 0 : end;
+}
 
-	// Creating a page file as table name using the storage manager
-	if((result = createPageFile(name)) != RC_OK) {
-	    printf("[createTable]: create page file failed!\n");
-	    free(recordManager);
-	    return result;
-	}
+// Store a record in an empty slot, pageFreeSpace must have said it fits
+static void placeRecord(char *page, int slot, const char *bytes, int length, int flags) {
+    SlotPageHeader *header = (SlotPageHeader *) page;
+    SlotEntry *slots = PAGE_SLOTS(page);
+    int numSlots = (slot >= header->numSlots) ? slot + 1 : header->numSlots;
+    int size = slotBytes(length);
 
-	// Opening the newly created page using the storage manager
-	if((result = openPageFile(name, &fileHandle)) != RC_OK) {
-		printf("[createTable]: open page file failed!\n");
-		free(recordManager);
-		destroyPageFile(name);
-		return result;
-	}
+    // The free space in the middle may be too small while the gaps are large enough
+    if (dataStartOf(page) - (int) (sizeof(SlotPageHeader) + numSlots * sizeof(SlotEntry)) < size) {
+        compactPage(page);
+    }
 
-	// Write to first location of the page file using the storage manager
-	if((result = writeBlock(0, &fileHandle, data)) != RC_OK) {
-		printf("[createTable]: write block failed!\n");
-		free(recordManager);
-        closePageFile(&fileHandle);
-        destroyPageFile(name);
-		return result;
-	}
+    int start = dataStartOf(page) - size;
+    memcpy(page + start, bytes, length);
+    header->dataStart = start;
+    header->numSlots = numSlots;
+    slots[slot].offset = start;
+    slots[slot].length = size;
+    slots[slot].flags = flags;
+    header->slotMap[slot / 64] |= (uint64_t) 1 << (slot % 64);
+    header->liveSlots++;
+    header->recordBytes += size;
+}
 
-	// Closing the file after writing to file using the storage manager
-	if((result = closePageFile(&fileHandle)) != RC_OK) {
-		printf("[createTable]: close page file failed!\n");
-		free(recordManager);
-        destroyPageFile(name);
-		return result;
-	}
+static void clearSlot(char *page, int slot) {
+    SlotPageHeader *header = (SlotPageHeader *) page;
+    SlotEntry *entry = &PAGE_SLOTS(page)[slot];
 
-	return RC_OK;
+    if (slotInUse(header, slot)) {
+        header->slotMap[slot / 64] &= ~((uint64_t) 1 << (slot % 64));
+        header->liveSlots--;
+        header->recordBytes -= entry->length;
+    }
+    entry->offset = 0;
+    entry->length = 0;
+    entry->flags = 0;
 }
 
-RC openTable(RM_TableData *table, char *tableName)
-{
-    // Validate input parameters
-    if (table == NULL || tableName == NULL) {
-        return RC_ERROR;
+static int attrSize(Schema *schema, int attrNum) {
+    switch (schema->dataTypes[attrNum]) {
+        case DT_BOOL:
+            return sizeof(bool);
+        case DT_FLOAT:
+            return sizeof(float);
+        case DT_INT:
+            return sizeof(int);
+        case DT_STRING:
+            return schema->typeLength[attrNum];
+        default:
+            return 0;
     }
+}
 
-    int attributeCount;
-    SM_PageHandle pageHandle;
-    Schema *schema;
+// Write the attributes of a record the way they are stored on a page, returns the length
+static int encodeRecord(Schema *schema, const char *data, char *bytes) {
+    char *pos = bytes;
 
-    // Set up table metadata
-    table->mgmtData = recordManager;
-    table->name = tableName;
+    for (int i = 0; i < schema->numAttr; i++) {
+        int size = attrSize(schema, i);
+        if (schema->dataTypes[i] == DT_STRING) {
+            // Only the characters up to the terminator are kept
+            unsigned short length = strnlen(data, size);
+            memcpy(pos, &length, sizeof(length));
+            memcpy(pos + sizeof(length), data, length);
+            pos += sizeof(length) + length;
+        } else {
+            memcpy(pos, data, size);
+            pos += size;
+        }
+        data += size;
+    }
+    return pos - bytes;
+}
 
-    // Pin the first page to read table metadata
-    RC pinResult = pinPage(&recordManager->bufferPool, &recordManager->pageHandle, 0);
-    if (pinResult != RC_OK) {
-        return pinResult;
+// Read a record stored on a page into row row of numRows rows that keep each attribute
+// in a column of its own, one after the other. Only the attributes set in attrs are
+// copied, all of them if it is NULL.
+static void decodeRecordColumns(Schema *schema, const char *bytes, char *columns, int numRows, int row, const bool *attrs) {
+    for (int i = 0; i < schema->numAttr; i++) {
+        int size = attrSize(schema, i);
+        bool wanted = (attrs == NULL || attrs[i]);
+        char *data = columns + row * size;
+        if (schema->dataTypes[i] == DT_STRING) {
+            unsigned short length;
+            memcpy(&length, bytes, sizeof(length));
+            if (wanted) {
+                memcpy(data, bytes + sizeof(length), length);
+                memset(data + length, 0, size - length);
+            }
+            bytes += sizeof(length) + length;
+        } else {
+            if (wanted) {
+                memcpy(data, bytes, size);
+            }
+            bytes += size;
+        }
+        columns += numRows * size;
     }
-    pageHandle = (char*) recordManager->pageHandle.data;
+}
 
-    // Read table metadata
-    recordManager->tuplesCount = *(int*)pageHandle;
-    pageHandle += sizeof(int);
-    recordManager->freePage = *(int*)pageHandle;
-    pageHandle += sizeof(int);
-    attributeCount = *(int*)pageHandle;
-    pageHandle += sizeof(int);
+// Read a record stored on a page back into the layout of Record->data, a single row
+// of columns
+static void decodeRecord(Schema *schema, const char *bytes, char *data, const bool *attrs) {
+    decodeRecordColumns(schema, bytes, data, 1, 0, attrs);
+}
 
-    // Allocate and initialize schema
-    schema = (Schema*) malloc(sizeof(Schema));
-    if (schema == NULL) {
-        unpinPage(&recordManager->bufferPool, &recordManager->pageHandle);
+// Largest length encodeRecord can return for the schema
+static int encodedRecordLimit(Schema *schema) {
+    int length = 0;
+    for (int i = 0; i < schema->numAttr; i++) {
+        length += attrSize(schema, i) + (schema->dataTypes[i] == DT_STRING ? sizeof(unsigned short) : 0);
+    }
+    return length;
+}
+
+/* PAX pages
+ *
+ * A table created with RM_LAYOUT_PAX keeps a minipage per attribute on every data
+ * page: the values of attribute 0 of all slots, then those of attribute 1 and so on.
+ * Values keep their full width, so a minipage is a plain array and a slot is an index
+ * into every one of them. The page starts with the same header as a slotted page,
+ * without a slot directory, and records never move.
+ */
+static RC initPaxLayout(RecordManager *mgr, Schema *schema) {
+    int rowBytes = 0;
+
+    mgr->paxNumAttr = schema->numAttr;
+    mgr->paxOffsets = (int *) malloc(sizeof(int) * (schema->numAttr > 0 ? schema->numAttr : 1));
+    mgr->paxWidths = (int *) malloc(sizeof(int) * (schema->numAttr > 0 ? schema->numAttr : 1));
+    if (mgr->paxOffsets == NULL || mgr->paxWidths == NULL) {
         return RC_MEMORY_ALLOCATION_FAIL;
     }
-    memset(schema, 0, sizeof(Schema));
-    schema->numAttr = attributeCount;
+    for (int i = 0; i < schema->numAttr; i++) {
+        mgr->paxWidths[i] = attrSize(schema, i);
+        rowBytes += mgr->paxWidths[i];
+    }
 
-    // Allocate memory for schema arrays
-    schema->typeLength = (int*) malloc(sizeof(int) * attributeCount);
-    schema->attrNames = (char**) malloc(sizeof(char*) * attributeCount);
-    schema->dataTypes = (DataType*) malloc(sizeof(DataType) * attributeCount);
+    // As many slots as the slot map has bits for and the minipages leave room for
+    mgr->paxCapacity = (rowBytes > 0) ? (PAGE_SIZE - (int) sizeof(SlotPageHeader)) / rowBytes : 0;
+    if (mgr->paxCapacity > (int) SLOT_MAP_WORDS * 64) {
+        mgr->paxCapacity = SLOT_MAP_WORDS * 64;
+    }
+    if (mgr->paxCapacity == 0) {
+        return RC_RM_LIMIT_EXCEEDED;
+    }
 
-    if (schema->typeLength == NULL || schema->attrNames == NULL || schema->dataTypes == NULL) {
-        // Handle memory allocation failure
-        free(schema->typeLength);
-        free(schema->attrNames);
-        free(schema->dataTypes);
-        free(schema);
-        unpinPage(&recordManager->bufferPool, &recordManager->pageHandle);
-        return RC_MEMORY_ALLOCATION_FAIL;
+    int offset = sizeof(SlotPageHeader);
+    for (int i = 0; i < schema->numAttr; i++) {
+        mgr->paxOffsets[i] = offset;
+        offset += mgr->paxCapacity * mgr->paxWidths[i];
     }
+    return RC_OK;
+}
 
-    // Read attribute information
-    for (int i = 0; i < attributeCount; i++) {
-        schema->attrNames[i] = (char*) malloc(attributeSize);
-        if (schema->attrNames[i] == NULL) {
-            // Handle memory allocation failure
-            for (int j = 0; j < i; j++) {
-                free(schema->attrNames[j]);
-            }
-            free(schema->typeLength);
-            free(schema->attrNames);
-            free(schema->dataTypes);
-            free(schema);
-            unpinPage(&recordManager->bufferPool, &recordManager->pageHandle);
-            return RC_MEMORY_ALLOCATION_FAIL;
+static void freePaxLayout(RecordManager *mgr) {
+    free(mgr->paxOffsets);
+    free(mgr->paxWidths);
+    mgr->paxOffsets = NULL;
+    mgr->paxWidths = NULL;
+}
+
+// The first empty slot of a PAX page, -1 if the page is full
+static int paxFreeSlot(RecordManager *mgr, char *page) {
+    SlotPageHeader *header = (SlotPageHeader *) page;
+
+    for (int word = 0; word * 64 < mgr->paxCapacity; word++) {
+        if (header->slotMap[word] != ~(uint64_t) 0) {
+            int slot = word * 64 + lowestBit(~header->slotMap[word]);
+            return slot < mgr->paxCapacity ? slot : -1;
         }
-        strncpy(schema->attrNames[i], pageHandle, attributeSize);
-        schema->attrNames[i][attributeSize - 1] = '\0';
-        pageHandle += attributeSize;
-        schema->dataTypes[i] = *(DataType*) pageHandle;
-        pageHandle += sizeof(DataType);
-        schema->typeLength[i] = *(int*) pageHandle;
-        pageHandle += sizeof(int);
     }
+    return -1;
+}
 
-    // Set table schema and unpin the page
-    table->schema = schema;
-    unpinPage(&recordManager->bufferPool, &recordManager->pageHandle);
-    forcePage(&recordManager->bufferPool, &recordManager->pageHandle);
-
-    return RC_OK;
+// Scatter the attributes of a record in the layout of Record->data over the minipages
+static void paxWrite(RecordManager *mgr, char *page, int slot, const char *data) {
+    for (int i = 0; i < mgr->paxNumAttr; i++) {
+        memcpy(page + mgr->paxOffsets[i] + slot * mgr->paxWidths[i], data, mgr->paxWidths[i]);
+        data += mgr->paxWidths[i];
+    }
 }
 
-extern RC closeTable (RM_TableData *rel)
-{
-    if (rel == NULL) {
-        printf("Error: [closeTable]: table data pointer is null.\n");
-        return RC_ERROR;
+static void paxRead(RecordManager *mgr, char *page, int slot, char *data, const bool *attrs) {
+    for (int i = 0; i < mgr->paxNumAttr; i++) {
+        if (attrs == NULL || attrs[i])
+            memcpy(data, page + mgr->paxOffsets[i] + slot * mgr->paxWidths[i], mgr->paxWidths[i]);
+        data += mgr->paxWidths[i];
     }
-	// Storing the table's meta data
-	RecordManager *recordManager = (*rel).mgmtData;
-	shutdownBufferPool(&recordManager->bufferPool);
+}
 
-	return RC_OK;
+/* Layout independent access to data pages. Records are handed around in the form the
+ * layout stores them: encoded for slotted pages, as in Record->data for PAX pages. */
+
+static int encodeForPage(RecordManager *mgr, Schema *schema, const char *data, char *bytes) {
+    if (mgr->layout == RM_LAYOUT_PAX) {
+        int length = getRecordSize(schema) - 1;
+        memcpy(bytes, data, length);
+        return length;
+    }
+    return encodeRecord(schema, data, bytes);
 }
 
-extern RC deleteTable (char *name)
-{
-    if (name == NULL) {
-        printf("Error: [deleteTable]: name of table is null.\n");
-        return RC_ERROR;
+// A slot on the page a record of the given length fits in, -1 if there is none
+static int slotForRecord(RecordManager *mgr, char *page, int length) {
+    if (mgr->layout == RM_LAYOUT_PAX) {
+        return paxFreeSlot(mgr, page);
     }
+    int slot = pageFreeSlot(page);
+    return pageFreeSpace(page, slot) >= slotBytes(length) ? slot : -1;
+}
 
-	// Removing the page file from memory
-	destroyPageFile(name);
-	
-	return RC_OK;
+// Store a record in the empty slot slotForRecord found
+static void storeRecord(RecordManager *mgr, char *page, int slot, const char *bytes, int length, int flags) {
+    if (mgr->layout == RM_LAYOUT_PAX) {
+        SlotPageHeader *header = (SlotPageHeader *) page;
+        paxWrite(mgr, page, slot, bytes);
+        header->slotMap[slot / 64] |= (uint64_t) 1 << (slot % 64);
+        header->liveSlots++;
+        if (slot >= header->numSlots) {
+            header->numSlots = slot + 1;
+        }
+        return;
+    }
+    placeRecord(page, slot, bytes, length, flags);
 }
 
-extern int getNumTuples (RM_TableData *rel)
-{
-    if (rel == NULL) {
-        printf("Error: [getNumTuples]: table data pointer is null.\n");
-        return RC_ERROR;
+static void removeRecord(RecordManager *mgr, char *page, int slot) {
+    if (mgr->layout == RM_LAYOUT_PAX) {
+        SlotPageHeader *header = (SlotPageHeader *) page;
+        if (slotInUse(header, slot)) {
+            header->slotMap[slot / 64] &= ~((uint64_t) 1 << (slot % 64));
+            header->liveSlots--;
+        }
+        return;
     }
+    clearSlot(page, slot);
+}
 
-	// Accessing our data structure's tuplesCount and returning it
-	RecordManager *recordManager = rel->mgmtData;
-	return recordManager->tuplesCount;
+// Flags of a slot in use, a PAX slot always holds its own record
+static int slotFlags(RecordManager *mgr, char *page, int slot) {
+    return (mgr->layout == RM_LAYOUT_PAX) ? 0 : PAGE_SLOTS(page)[slot].flags;
 }
 
-// Function prototypes
-static RC findFreeSlot(RecordManager *mgr, RID *rid, int recordSize);
-static RC writeRecordToPage(RecordManager *mgr, RID *rid, Record *record, int recordSize);
+// The bytes of the record in a slot of a slotted page, after the home RID of a record
+// that moved in
+static const char *storedRecord(char *page, int slot) {
+    SlotEntry *entry = &PAGE_SLOTS(page)[slot];
+    return page + entry->offset + ((entry->flags & SLOT_MOVED_IN) ? sizeof(RID) : 0);
+}
 
-RC insertRecord(RM_TableData *rel, Record *record) {
-    // Validate input parameters
-    if (!rel || !record) {
-        return RC_ERROR;
+// Read the record in a slot into the layout of Record->data, skipping the home RID of a
+// record that moved in. attrs picks the attributes to read, NULL for all.
+static void loadRecord(RecordManager *mgr, Schema *schema, char *page, int slot, char *data, const bool *attrs) {
+    if (mgr->layout == RM_LAYOUT_PAX) {
+        paxRead(mgr, page, slot, data, attrs);
+        return;
     }
+    decodeRecord(schema, storedRecord(page, slot), data, attrs);
+}
 
-    RecordManager *mgr = rel->mgmtData;
-    RID *rid = &record->id;
-    int recordSize = getRecordSize(rel->schema);
-
-    // Find a free page and slot
-    RC status = findFreeSlot(mgr, rid, recordSize);
-    if (status != RC_OK) {
-        return status;
+// Copy the attributes set in attrs from row row of the columns decodeRecordColumns
+// fills to a Record->data
+static void copyColumnAttrs(Schema *schema, const bool *attrs, char *data, const char *columns, int numRows, int row) {
+    int offset = 1;
+    for (int i = 0; i < schema->numAttr; i++) {
+        int size = attrSize(schema, i);
+        if (attrs == NULL || attrs[i]) {
+            memcpy(data + offset, columns + row * size, size);
+        }
+        offset += size;
+        columns += numRows * size;
     }
+}
 
-    // Insert the record
-    status = writeRecordToPage(mgr, rid, record, recordSize);
-    if (status != RC_OK) {
-        return status;
+// Copy the attributes set in attrs from one Record->data to another, all of them if
+// attrs is NULL. The tombstone marker in front of them stays as it is.
+static void copyAttrs(Schema *schema, const bool *attrs, char *data, const char *from) {
+    if (attrs == NULL) {
+        memcpy(data + 1, from + 1, getRecordSize(schema) - 1);
+        return;
+    }
+    int offset = 1;
+    for (int i = 0; i < schema->numAttr; i++) {
+        int size = attrSize(schema, i);
+        if (attrs[i]) {
+            memcpy(data + offset, from + offset, size);
+        }
+        offset += size;
     }
+}
 
-    // Update metadata
-    mgr->tuplesCount++;
 
-    // Pin the first page (metadata page)
-    return pinPage(&mgr->bufferPool, &mgr->pageHandle, 0);
+// Initalizing the Buffer Pool of a table using LRU page replacement policy, or
+// taking up to maxNumberOfPages frames of the shared pool
+static RC openTablePool(RecordManager *mgr, char *name) {
+    if (sharedPool != NULL)
+        return attachBufferPool(&mgr->bufferPool, sharedPool, name, maxNumberOfPages);
+    return initBufferPool(&mgr->bufferPool, name, maxNumberOfPages, RS_LRU, NULL);
 }
 
-static RC findFreeSlot(RecordManager *mgr, RID *rid, int recordSize) {
-    rid->page = mgr->freePage;
+/* Catalog
+ *
+ * The record manager keeps every table it knows with its schema in memory and in the
+ * page file catalogFile, so opening a table does not parse its header page. An
+ * open table has one RecordManager, shared by every RM_TableData it is opened with.
+ * Tables missing from the catalog are added the first time they are opened.
+ */
+typedef struct CatalogEntry
+{
+    char *name;
+    Schema *schema;
+    // Table header as of the last closeTable, only valid if countsKnown
+    bool countsKnown;
+    int tuplesCount;
+    int freePage;
+    int numPages;
+    RM_PageLayout layout;
+    // Attributes with a B+ tree index
+    int numIndexes;
+    int *indexAttrs;
+    // State of the open table, NULL if it is not open
+    RecordManager *open;
+    int openCount;
+} CatalogEntry;
+
+static CatalogEntry *catalog = NULL;
+static int catalogSize = 0;
+static int catalogCapacity = 0;
+// Page file of the catalog, CATALOG_FILE_NAME unless initRecordManagerWithOptions names another
+static char defaultCatalogFile[] = CATALOG_FILE_NAME;
+static char *catalogFile = defaultCatalogFile;
+
+static CatalogEntry *findCatalogEntry(const char *name) {
+    for (int i = 0; i < catalogSize; i++) {
+        if (strcmp(catalog[i].name, name) == 0) {
+            return &catalog[i];
+        }
+    }
+    return NULL;
+}
 
-    while (true) {
-        pinPage(&mgr->bufferPool, &mgr->pageHandle, rid->page);
-        char *dataPointer = mgr->pageHandle.data;
+// A copy of a schema that owns all of its arrays and names
+static Schema *copySchema(Schema *schema) {
+    Schema *copy = (Schema *) calloc(1, sizeof(Schema));
+    if (copy == NULL) {
+        return NULL;
+    }
+    copy->numAttr = schema->numAttr;
+    copy->keySize = schema->keySize;
+    copy->attrNames = (char **) calloc(schema->numAttr > 0 ? schema->numAttr : 1, sizeof(char *));
+    copy->dataTypes = (DataType *) malloc(sizeof(DataType) * (schema->numAttr > 0 ? schema->numAttr : 1));
+    copy->typeLength = (int *) malloc(sizeof(int) * (schema->numAttr > 0 ? schema->numAttr : 1));
+    copy->keyAttrs = (int *) malloc(sizeof(int) * (schema->keySize > 0 ? schema->keySize : 1));
+    if (copy->attrNames == NULL || copy->dataTypes == NULL || copy->typeLength == NULL || copy->keyAttrs == NULL) {
+        free(copy->attrNames);
+        free(copy->dataTypes);
+        free(copy->typeLength);
+        free(copy->keyAttrs);
+        free(copy);
+        return NULL;
+    }
+    for (int i = 0; i < schema->numAttr; i++) {
+        copy->attrNames[i] = strdup(schema->attrNames[i]);
+        copy->dataTypes[i] = schema->dataTypes[i];
+        copy->typeLength[i] = schema->typeLength[i];
+    }
+    if (schema->keySize > 0 && schema->keyAttrs != NULL) {
+        memcpy(copy->keyAttrs, schema->keyAttrs, sizeof(int) * schema->keySize);
+    } else {
+        copy->keySize = 0;
+    }
+    return copy;
+}
 
-        rid->slot = getFreeSpace(dataPointer, recordSize);
-        if (rid->slot != -1) {
+static void freeSchemaCopy(Schema *schema) {
+    if (schema == NULL) {
+        return;
+    }
+    for (int i = 0; i < schema->numAttr; i++) {
+        free(schema->attrNames[i]);
+    }
+    free(schema->attrNames);
+    free(schema->dataTypes);
+    free(schema->typeLength);
+    free(schema->keyAttrs);
+    free(schema);
+}
+
+// Add a table to the catalog, or replace the schema of a table it already has
+static CatalogEntry *addCatalogEntry(const char *name, Schema *schema) {
+    Schema *copy = copySchema(schema);
+    if (copy == NULL) {
+        return NULL;
+    }
+
+    CatalogEntry *entry = findCatalogEntry(name);
+    if (entry != NULL) {
+        freeSchemaCopy(entry->schema);
+        entry->schema = copy;
+        entry->countsKnown = false;
+        return entry;
+    }
+
+    if (catalogSize == catalogCapacity) {
+        int capacity = (catalogCapacity > 0) ? catalogCapacity * 2 : 8;
+        CatalogEntry *grown = (CatalogEntry *) realloc(catalog, sizeof(CatalogEntry) * capacity);
+        if (grown == NULL) {
+            freeSchemaCopy(copy);
+            return NULL;
+        }
+        catalog = grown;
+        catalogCapacity = capacity;
+    }
+    entry = &catalog[catalogSize++];
+    memset(entry, 0, sizeof(CatalogEntry));
+    entry->name = strdup(name);
+    entry->schema = copy;
+    return entry;
+}
+
+static void removeCatalogEntry(CatalogEntry *entry) {
+    free(entry->name);
+    free(entry->indexAttrs);
+    freeSchemaCopy(entry->schema);
+    *entry = catalog[--catalogSize];
+}
+
+// Growing buffer the catalog is written to
+typedef struct CatalogBuffer
+{
+    char *data;
+    int size;
+    int capacity;
+} CatalogBuffer;
+
+static void appendCatalog(CatalogBuffer *buffer, const void *bytes, int length) {
+    if (buffer->data == NULL) {
+        return;
+    }
+    if (buffer->size + length > buffer->capacity) {
+        while (buffer->size + length > buffer->capacity) {
+            buffer->capacity *= 2;
+        }
+        char *grown = (char *) realloc(buffer->data, buffer->capacity);
+        if (grown == NULL) {
+            free(buffer->data);
+            buffer->data = NULL;
+            return;
+        }
+        buffer->data = grown;
+    }
+    memcpy(buffer->data + buffer->size, bytes, length);
+    buffer->size += length;
+}
+
+static void appendCatalogInt(CatalogBuffer *buffer, int value) {
+    appendCatalog(buffer, &value, sizeof(int));
+}
+
+static void appendCatalogString(CatalogBuffer *buffer, const char *string) {
+    appendCatalogInt(buffer, strlen(string));
+    appendCatalog(buffer, string, strlen(string));
+}
+
+// Write the whole catalog to its page file: the number of tables, then per table its
+// name, the attributes with their types and lengths, the key attributes, the layout and
+// the indexed attributes
+static RC saveCatalog(void) {
+    CatalogBuffer buffer = { (char *) malloc(PAGE_SIZE), 0, PAGE_SIZE };
+
+    appendCatalogInt(&buffer, catalogSize);
+    for (int i = 0; i < catalogSize; i++) {
+        Schema *schema = catalog[i].schema;
+        appendCatalogString(&buffer, catalog[i].name);
+        appendCatalogInt(&buffer, schema->numAttr);
+        for (int k = 0; k < schema->numAttr; k++) {
+            appendCatalogString(&buffer, schema->attrNames[k]);
+            appendCatalogInt(&buffer, schema->dataTypes[k]);
+            appendCatalogInt(&buffer, schema->typeLength[k]);
+        }
+        appendCatalogInt(&buffer, schema->keySize);
+        for (int k = 0; k < schema->keySize; k++) {
+            appendCatalogInt(&buffer, schema->keyAttrs[k]);
+        }
+        appendCatalogInt(&buffer, catalog[i].layout);
+        appendCatalogInt(&buffer, catalog[i].numIndexes);
+        for (int k = 0; k < catalog[i].numIndexes; k++) {
+            appendCatalogInt(&buffer, catalog[i].indexAttrs[k]);
+        }
+    }
+    if (buffer.data == NULL) {
+        return RC_MEMORY_ALLOCATION_FAIL;
+    }
+
+    // Pad to whole pages and write them in one go
+    int numPages = (buffer.size + PAGE_SIZE - 1) / PAGE_SIZE;
+    char *padded = (char *) calloc(numPages, PAGE_SIZE);
+    int *pageNums = (int *) malloc(sizeof(int) * numPages);
+    SM_PageHandle *pages = (SM_PageHandle *) malloc(sizeof(SM_PageHandle) * numPages);
+    SM_FileHandle fileHandle;
+    RC result = RC_MEMORY_ALLOCATION_FAIL;
+
+    if (padded != NULL && pageNums != NULL && pages != NULL) {
+        memcpy(padded, buffer.data, buffer.size);
+        for (int i = 0; i < numPages; i++) {
+            pageNums[i] = i;
+            pages[i] = padded + i * PAGE_SIZE;
+        }
+        if (access(catalogFile, F_OK) == -1) {
+            createPageFile(catalogFile);
+        }
+        result = openPageFile(catalogFile, &fileHandle);
+        if (result == RC_OK) {
+            result = writeBlocks(numPages, pageNums, &fileHandle, pages);
+            closePageFile(&fileHandle);
+        }
+    }
+    free(padded);
+    free(pageNums);
+    free(pages);
+    free(buffer.data);
+    return result;
+}
+
+// Reads the catalog file back, stops at the first thing that does not add up
+typedef struct CatalogReader
+{
+    const char *data;
+    int size;
+    int position;
+} CatalogReader;
+
+static bool readCatalogInt(CatalogReader *reader, int *value) {
+    if (reader->position + (int) sizeof(int) > reader->size) {
+        return false;
+    }
+    memcpy(value, reader->data + reader->position, sizeof(int));
+    reader->position += sizeof(int);
+    return true;
+}
+
+static char *readCatalogString(CatalogReader *reader) {
+    int length;
+    if (!readCatalogInt(reader, &length) || length < 0 || reader->position + length > reader->size) {
+        return NULL;
+    }
+    char *string = (char *) malloc(length + 1);
+    if (string != NULL) {
+        memcpy(string, reader->data + reader->position, length);
+        string[length] = '\0';
+    }
+    reader->position += length;
+    return string;
+}
+
+static Schema *readCatalogSchema(CatalogReader *reader) {
+    int numAttr, keySize;
+    if (!readCatalogInt(reader, &numAttr) || numAttr < 0) {
+        return NULL;
+    }
+
+    Schema *schema = (Schema *) calloc(1, sizeof(Schema));
+    if (schema == NULL) {
+        return NULL;
+    }
+    schema->attrNames = (char **) calloc(numAttr > 0 ? numAttr : 1, sizeof(char *));
+    schema->dataTypes = (DataType *) malloc(sizeof(DataType) * (numAttr > 0 ? numAttr : 1));
+    schema->typeLength = (int *) malloc(sizeof(int) * (numAttr > 0 ? numAttr : 1));
+    if (schema->attrNames == NULL || schema->dataTypes == NULL || schema->typeLength == NULL) {
+        freeSchemaCopy(schema);
+        return NULL;
+    }
+
+    bool ok = true;
+    for (int k = 0; k < numAttr && ok; k++) {
+        int dataType;
+        schema->attrNames[k] = readCatalogString(reader);
+        schema->numAttr = k + 1;
+        ok = schema->attrNames[k] != NULL && readCatalogInt(reader, &dataType) &&
+             readCatalogInt(reader, &schema->typeLength[k]);
+        schema->dataTypes[k] = (DataType) dataType;
+    }
+    if (ok && readCatalogInt(reader, &keySize) && keySize >= 0 && keySize <= numAttr) {
+        schema->keySize = keySize;
+        schema->keyAttrs = (int *) malloc(sizeof(int) * (keySize > 0 ? keySize : 1));
+        for (int k = 0; k < keySize && ok; k++) {
+            ok = schema->keyAttrs != NULL && readCatalogInt(reader, &schema->keyAttrs[k]);
+        }
+    } else {
+        ok = false;
+    }
+
+    if (!ok) {
+        freeSchemaCopy(schema);
+        return NULL;
+    }
+    return schema;
+}
+
+// Load the catalog file, a missing file is an empty catalog
+static RC loadCatalog(void) {
+    SM_FileHandle fileHandle;
+    if (access(catalogFile, F_OK) == -1 || openPageFile(catalogFile, &fileHandle) != RC_OK) {
+        return RC_OK;
+    }
+
+    int size = fileHandle.totalNumPages * PAGE_SIZE;
+    char *data = (char *) malloc(size > 0 ? size : 1);
+    if (data == NULL) {
+        closePageFile(&fileHandle);
+        return RC_MEMORY_ALLOCATION_FAIL;
+    }
+    for (int i = 0; i < fileHandle.totalNumPages; i++) {
+        if (readBlock(i, &fileHandle, data + i * PAGE_SIZE) != RC_OK) {
+            size = i * PAGE_SIZE;
+            break;
+        }
+    }
+    closePageFile(&fileHandle);
+
+    CatalogReader reader = { data, size, 0 };
+    int numTables;
+    if (readCatalogInt(&reader, &numTables)) {
+        for (int i = 0; i < numTables; i++) {
+            char *name = readCatalogString(&reader);
+            Schema *schema = (name != NULL) ? readCatalogSchema(&reader) : NULL;
+            int layout, numIndexes;
+            int *indexAttrs = NULL;
+            if (schema != NULL && (!readCatalogInt(&reader, &layout) || !readCatalogInt(&reader, &numIndexes) ||
+                                   numIndexes < 0 || numIndexes > schema->numAttr)) {
+                freeSchemaCopy(schema);
+                schema = NULL;
+            }
+            if (schema != NULL) {
+                indexAttrs = (int *) malloc(sizeof(int) * (numIndexes > 0 ? numIndexes : 1));
+                for (int k = 0; k < numIndexes && schema != NULL; k++) {
+                    if (indexAttrs == NULL || !readCatalogInt(&reader, &indexAttrs[k])) {
+                        freeSchemaCopy(schema);
+                        schema = NULL;
+                    }
+                }
+            }
+            if (schema != NULL) {
+                CatalogEntry *entry = addCatalogEntry(name, schema);
+                if (entry != NULL) {
+                    entry->layout = (layout == RM_LAYOUT_PAX) ? RM_LAYOUT_PAX : RM_LAYOUT_ROW;
+                    entry->numIndexes = numIndexes;
+                    entry->indexAttrs = indexAttrs;
+                    indexAttrs = NULL;
+                }
+            }
+            free(indexAttrs);
+            free(name);
+            freeSchemaCopy(schema);
+            if (schema == NULL) {
+                break;
+            }
+        }
+    }
+    free(data);
+    return RC_OK;
+}
+
+static void freeCatalog(void) {
+    for (int i = 0; i < catalogSize; i++) {
+        free(catalog[i].name);
+        free(catalog[i].indexAttrs);
+        freeSchemaCopy(catalog[i].schema);
+    }
+    free(catalog);
+    catalog = NULL;
+    catalogSize = 0;
+    catalogCapacity = 0;
+}
+
+/* Indexes
+ *
+ * A table can keep a B+ tree index on an int attribute, in the page file named after the
+ * table and the attribute by indexFileName. The catalog remembers which attributes are
+ * indexed, an open table has every index open. Inserts, updates and deletes keep the
+ * indexes current, and a scan whose condition limits an indexed attribute to a range
+ * looks the records up in the index. Records may share a key, an entry of the B+ tree is
+ * the key together with the RID of the record, so each one is taken out on its own.
+ */
+typedef struct TableIndex
+{
+    int attrNum;
+    char *fileName;
+    BTreeHandle *tree;
+} TableIndex;
+
+// A scan that takes its records from an index: the RIDs with keys from low to high,
+// looked up when the scan starts over
+typedef struct IndexScan
+{
+    int attrNum;
+    bool empty;     // no key fits the condition
+    int low;
+    int high;
+    bool collected; // rids holds the RIDs for this pass
+    RID *rids;
+    int numRids;
+    int position;
+} IndexScan;
+
+static char *indexFileName(const char *tableName, int attrNum) {
+    char *name = (char *) malloc(strlen(tableName) + 16);
+    if (name != NULL) {
+        sprintf(name, "%s.idx%d", tableName, attrNum);
+    }
+    return name;
+}
+
+// Remove the index files of a table and forget its indexes
+static void deleteIndexFiles(CatalogEntry *entry) {
+    for (int i = 0; i < entry->numIndexes; i++) {
+        char *fileName = indexFileName(entry->name, entry->indexAttrs[i]);
+        if (fileName != NULL) {
+            deleteBtree(fileName);
+            free(fileName);
+        }
+    }
+    free(entry->indexAttrs);
+    entry->indexAttrs = NULL;
+    entry->numIndexes = 0;
+}
+
+static void closeTableIndexes(RecordManager *mgr) {
+    for (int i = 0; i < mgr->numIndexes; i++) {
+        closeBtree(mgr->indexes[i].tree);
+        free(mgr->indexes[i].fileName);
+    }
+    free(mgr->indexes);
+    mgr->indexes = NULL;
+    mgr->numIndexes = 0;
+}
+
+// Open the index of an attribute and add it to the open table
+static RC openTableIndex(RecordManager *mgr, const char *tableName, int attrNum) {
+    TableIndex *grown = (TableIndex *) realloc(mgr->indexes, sizeof(TableIndex) * (mgr->numIndexes + 1));
+    if (grown == NULL) {
+        return RC_MEMORY_ALLOCATION_FAIL;
+    }
+    mgr->indexes = grown;
+
+    TableIndex *index = &mgr->indexes[mgr->numIndexes];
+    index->attrNum = attrNum;
+    // The tree keeps the name it was opened with
+    index->fileName = indexFileName(tableName, attrNum);
+    if (index->fileName == NULL) {
+        return RC_MEMORY_ALLOCATION_FAIL;
+    }
+    RC status = openBtree(&index->tree, index->fileName);
+    if (status != RC_OK) {
+        free(index->fileName);
+        return status;
+    }
+    mgr->numIndexes++;
+    return RC_OK;
+}
+
+static RC openTableIndexes(RecordManager *mgr, CatalogEntry *entry) {
+    for (int i = 0; i < entry->numIndexes; i++) {
+        RC status = openTableIndex(mgr, entry->name, entry->indexAttrs[i]);
+        if (status != RC_OK) {
+            closeTableIndexes(mgr);
+            return status;
+        }
+    }
+    return RC_OK;
+}
+
+static TableIndex *findTableIndex(RecordManager *mgr, int attrNum) {
+    for (int i = 0; i < mgr->numIndexes; i++) {
+        if (mgr->indexes[i].attrNum == attrNum) {
+            return &mgr->indexes[i];
+        }
+    }
+    return NULL;
+}
+
+extern RC initRecordManager (void *mgmtData)
+{
+	// mgmtData may hand us a buffer pool to cache all the tables in
+	RM_ManagerOptions options = { (BM_SharedPool *) mgmtData, NULL };
+	return initRecordManagerWithOptions(&options);
+}
+
+extern RC initRecordManagerWithOptions (const RM_ManagerOptions *options)
+{
+	if (options != NULL && options->catalogFile != NULL) {
+		catalogFile = strdup(options->catalogFile);
+		if (catalogFile == NULL) {
+			catalogFile = defaultCatalogFile;
+			return RC_MEMORY_ALLOCATION_FAIL;
+		}
+	}
+	// Initiliazing Storage Manager
+	initStorageManager();
+	sharedPool = options != NULL ? options->sharedPool : NULL;
+	// Tables created before
+	loadCatalog();
+	printf("[init]: Record manager initialized success!\n");
+	return RC_OK;
+}
+
+extern RC shutdownRecordManager ()
+{
+	freeCatalog();
+	if (catalogFile != defaultCatalogFile) {
+		free(catalogFile);
+		catalogFile = defaultCatalogFile;
+	}
+	sharedPool = NULL;
+	printf("[shutdown]: Record manager shutdown success!\n");
+	return RC_OK;
+}
+
+extern RC createTable (char *name, Schema *schema)
+{
+	return createTableWithOptions(name, schema, NULL);
+}
+
+extern RC createTableWithOptions (char *name, Schema *schema, const RM_TableOptions *options)
+{
+	char data[PAGE_SIZE];
+	RC result;
+	void *pageHandle = data;
+	SM_FileHandle fileHandle;
+	RM_PageLayout layout = (options != NULL) ? options->layout : RM_LAYOUT_ROW;
+    if (name == NULL || schema == NULL) {
+        printf(name == NULL ? "Error: [createTable]: name is null.\n" : "Error: schema pointer is null.\n");
+        return RC_ERROR;
+    }
+    if (layout != RM_LAYOUT_ROW && layout != RM_LAYOUT_PAX) {
+        printf("Error: [createTable]: unknown page layout.\n");
+        return RC_ERROR;
+    }
+
+    // A PAX page has to hold at least one record
+    if (layout == RM_LAYOUT_PAX) {
+        RecordManager probe;
+        memset(&probe, 0, sizeof(RecordManager));
+        result = initPaxLayout(&probe, schema);
+        freePaxLayout(&probe);
+        if (result != RC_OK) {
+            return result;
+        }
+    }
+
+    // Check if the file already exists
+    if (access(name, F_OK) != -1) {
+        // File exists, delete it
+        if (remove(name) != 0) {
+            return RC_FILE_NOT_FOUND;
+        }
+    }
+	// Setting pageHandle intial value
+	memset(data, 0, PAGE_SIZE);
+	writeIntToPage(&pageHandle, 0);
+	writeIntToPage(&pageHandle, 1);
+
+	// Setting the number of attributes in pageHandle
+    writeIntToPage(&pageHandle, schema->numAttr);
+
+	// Setting the Key Size of the attributes in pageHandle
+    writeIntToPage(&pageHandle, schema->keySize);
+
+	for(int k = 0; k < schema->numAttr; k++){
+		// Setting attribute name and it's data type
+		if (strlen(schema->attrNames[k]) >= attributeSize) {
+            printf("\n\n ERROR: [createTable]: attribute name is too long!!! \n\n");
+            return RC_ERROR;
+        }
+		strncpy((char *) pageHandle, schema->attrNames[k], attributeSize);
+		((char *) pageHandle)[attributeSize - 1] = '\0';
+		pageHandle = (char *) pageHandle + attributeSize;
+        writeIntToPage(&pageHandle, (int)schema->dataTypes[k]);
+
+		// Setting length of datatype of the attribute
+		writeIntToPage(&pageHandle, (int) schema->typeLength[k]);
+    }
+
+	// Setting how the data pages store records
+	writeIntToPage(&pageHandle, (int) layout);
+
+	// Creating a page file as table name using the storage manager
+	if((result = createPageFile(name)) != RC_OK) {
+	    printf("[createTable]: create page file failed!\n");
+	    return result;
+	}
+
+	// Opening the newly created page using the storage manager
+	if((result = openPageFile(name, &fileHandle)) != RC_OK) {
+		printf("[createTable]: open page file failed!\n");
+		destroyPageFile(name);
+		return result;
+	}
+
+	// Write to first location of the page file using the storage manager
+	if((result = writeBlock(0, &fileHandle, data)) != RC_OK) {
+		printf("[createTable]: write block failed!\n");
+        closePageFile(&fileHandle);
+        destroyPageFile(name);
+		return result;
+	}
+
+	// Closing the file after writing to file using the storage manager
+	if((result = closePageFile(&fileHandle)) != RC_OK) {
+		printf("[createTable]: close page file failed!\n");
+        destroyPageFile(name);
+		return result;
+	}
+
+	// A table created again starts out without the indexes of the one it replaces
+	CatalogEntry *entry = findCatalogEntry(name);
+	if (entry != NULL) {
+		deleteIndexFiles(entry);
+	}
+
+	// Registering the table in the catalog, a new table is empty
+	entry = addCatalogEntry(name, schema);
+	if (entry == NULL) {
+		destroyPageFile(name);
+		return RC_MEMORY_ALLOCATION_FAIL;
+	}
+	entry->countsKnown = true;
+	entry->tuplesCount = 0;
+	entry->freePage = 1;
+	entry->numPages = 1;
+	entry->layout = layout;
+
+	return saveCatalog();
+}
+
+// Read the counts of a table from its header page, and its schema and layout if result
+// is not NULL
+static RC readTableHeader(RecordManager *mgr, Schema **result)
+{
+    int attributeCount;
+    SM_PageHandle pageHandle;
+    Schema *schema;
+
+    // Pin the first page to read table metadata
+    RC pinResult = pinPage(&mgr->bufferPool, &mgr->pageHandle, 0);
+    if (pinResult != RC_OK) {
+        return pinResult;
+    }
+    pageHandle = (char*) mgr->pageHandle.data;
+
+    // Read table metadata
+    mgr->tuplesCount = *(int*)pageHandle;
+    pageHandle += sizeof(int);
+    mgr->freePage = *(int*)pageHandle;
+    pageHandle += sizeof(int);
+    attributeCount = *(int*)pageHandle;
+    pageHandle += sizeof(int);
+    // Skip the key size createTable stores after the number of attributes
+    pageHandle += sizeof(int);
+
+    if (result == NULL) {
+        return unpinPage(&mgr->bufferPool, &mgr->pageHandle);
+    }
+
+    // Allocate and initialize schema
+    schema = (Schema*) malloc(sizeof(Schema));
+    if (schema == NULL) {
+        unpinPage(&mgr->bufferPool, &mgr->pageHandle);
+        return RC_MEMORY_ALLOCATION_FAIL;
+    }
+    memset(schema, 0, sizeof(Schema));
+    schema->numAttr = attributeCount;
+
+    // Allocate memory for schema arrays
+    schema->typeLength = (int*) malloc(sizeof(int) * attributeCount);
+    schema->attrNames = (char**) malloc(sizeof(char*) * attributeCount);
+    schema->dataTypes = (DataType*) malloc(sizeof(DataType) * attributeCount);
+
+    if (schema->typeLength == NULL || schema->attrNames == NULL || schema->dataTypes == NULL) {
+        // Handle memory allocation failure
+        free(schema->typeLength);
+        free(schema->attrNames);
+        free(schema->dataTypes);
+        free(schema);
+        unpinPage(&mgr->bufferPool, &mgr->pageHandle);
+        return RC_MEMORY_ALLOCATION_FAIL;
+    }
+
+    // Read attribute information
+    for (int i = 0; i < attributeCount; i++) {
+        schema->attrNames[i] = (char*) malloc(attributeSize);
+        if (schema->attrNames[i] == NULL) {
+            // Handle memory allocation failure
+            for (int j = 0; j < i; j++) {
+                free(schema->attrNames[j]);
+            }
+            free(schema->typeLength);
+            free(schema->attrNames);
+            free(schema->dataTypes);
+            free(schema);
+            unpinPage(&mgr->bufferPool, &mgr->pageHandle);
+            return RC_MEMORY_ALLOCATION_FAIL;
+        }
+        strncpy(schema->attrNames[i], pageHandle, attributeSize);
+        schema->attrNames[i][attributeSize - 1] = '\0';
+        pageHandle += attributeSize;
+        schema->dataTypes[i] = *(DataType*) pageHandle;
+        pageHandle += sizeof(DataType);
+        schema->typeLength[i] = *(int*) pageHandle;
+        pageHandle += sizeof(int);
+    }
+    mgr->layout = (*(int*) pageHandle == RM_LAYOUT_PAX) ? RM_LAYOUT_PAX : RM_LAYOUT_ROW;
+
+    *result = schema;
+    return unpinPage(&mgr->bufferPool, &mgr->pageHandle);
+}
+
+RC openTable(RM_TableData *table, char *tableName)
+{
+    // Validate input parameters
+    if (table == NULL || tableName == NULL) {
+        return RC_ERROR;
+    }
+
+    CatalogEntry *entry = findCatalogEntry(tableName);
+    table->name = tableName;
+
+    // A table that is open already shares its state
+    if (entry != NULL && entry->open != NULL) {
+        table->schema = copySchema(entry->schema);
+        if (table->schema == NULL) {
+            return RC_MEMORY_ALLOCATION_FAIL;
+        }
+        table->mgmtData = entry->open;
+        entry->openCount++;
+        return RC_OK;
+    }
+
+    // The buffer pool would read a missing file as empty pages
+    if (access(tableName, F_OK) == -1) {
+        return RC_FILE_NOT_FOUND;
+    }
+
+    RecordManager *mgr = (RecordManager *) calloc(1, sizeof(RecordManager));
+    if (mgr == NULL) {
+        return RC_MEMORY_ALLOCATION_FAIL;
+    }
+    RC result = openTablePool(mgr, tableName);
+    if (result != RC_OK) {
+        free(mgr);
+        return result;
+    }
+
+    if (entry != NULL && entry->countsKnown) {
+        // Closed before, the catalog remembers what the header page says
+        mgr->tuplesCount = entry->tuplesCount;
+        mgr->freePage = entry->freePage;
+        mgr->numPages = entry->numPages;
+    } else {
+        // Read the header page, and the schema of a table the catalog does not know yet
+        Schema *schema = NULL;
+        result = readTableHeader(mgr, entry == NULL ? &schema : NULL);
+        if (result == RC_OK && entry == NULL) {
+            entry = addCatalogEntry(tableName, schema);
+            if (entry == NULL) {
+                result = RC_MEMORY_ALLOCATION_FAIL;
+            } else {
+                entry->layout = mgr->layout;
+                saveCatalog();
+            }
+            for (int i = 0; i < schema->numAttr; i++) {
+                free(schema->attrNames[i]);
+            }
+            free(schema->attrNames);
+            free(schema->dataTypes);
+            free(schema->typeLength);
+            free(schema);
+        }
+        if (result != RC_OK) {
+            shutdownBufferPool(&mgr->bufferPool);
+            free(mgr);
+            return result;
+        }
+
+        // Pages written before the table was opened again, scans stop after the last one
+        SM_FileHandle fileHandle;
+        mgr->numPages = 1;
+        if (openPageFile(tableName, &fileHandle) == RC_OK) {
+            if (fileHandle.totalNumPages > mgr->numPages) {
+                mgr->numPages = fileHandle.totalNumPages;
+            }
+            closePageFile(&fileHandle);
+        }
+    }
+
+    mgr->layout = entry->layout;
+    result = (mgr->layout == RM_LAYOUT_PAX) ? initPaxLayout(mgr, entry->schema) : RC_OK;
+    table->schema = (result == RC_OK) ? copySchema(entry->schema) : NULL;
+    if (table->schema == NULL) {
+        freePaxLayout(mgr);
+        shutdownBufferPool(&mgr->bufferPool);
+        free(mgr);
+        return (result != RC_OK) ? result : RC_MEMORY_ALLOCATION_FAIL;
+    }
+
+    // The indexes of the table are open as long as the table is
+    result = openTableIndexes(mgr, entry);
+    if (result != RC_OK) {
+        freeSchemaCopy(table->schema);
+        table->schema = NULL;
+        freePaxLayout(mgr);
+        shutdownBufferPool(&mgr->bufferPool);
+        free(mgr);
+        return result;
+    }
+    table->mgmtData = mgr;
+    entry->open = mgr;
+    entry->openCount = 1;
+
+    return RC_OK;
+}
+
+extern RC closeTable (RM_TableData *rel)
+{
+    if (rel == NULL) {
+        printf("Error: [closeTable]: table data pointer is null.\n");
+        return RC_ERROR;
+    }
+
+	RecordManager *recordManager = (*rel).mgmtData;
+	CatalogEntry *entry = findCatalogEntry(rel->name);
+
+	// Every openTable handed out its own copy of the schema
+	freeSchemaCopy(rel->schema);
+	rel->schema = NULL;
+
+	// The table stays open while someone else still has it open
+	if (entry != NULL && entry->open == recordManager && --entry->openCount > 0) {
+		rel->mgmtData = NULL;
+		return RC_OK;
+	}
+
+	// Storing the table's meta data
+	if (pinPage(&recordManager->bufferPool, &recordManager->pageHandle, 0) == RC_OK) {
+		void *pageHandle = recordManager->pageHandle.data;
+		writeIntToPage(&pageHandle, recordManager->tuplesCount);
+		writeIntToPage(&pageHandle, recordManager->freePage);
+		markDirty(&recordManager->bufferPool, &recordManager->pageHandle);
+		unpinPage(&recordManager->bufferPool, &recordManager->pageHandle);
+	}
+	shutdownBufferPool(&recordManager->bufferPool);
+
+	// The next open takes the header from the catalog
+	if (entry != NULL && entry->open == recordManager) {
+		entry->countsKnown = true;
+		entry->tuplesCount = recordManager->tuplesCount;
+		entry->freePage = recordManager->freePage;
+		entry->numPages = recordManager->numPages;
+		entry->open = NULL;
+	}
+	closeTableIndexes(recordManager);
+	freePaxLayout(recordManager);
+	free(recordManager);
+	rel->mgmtData = NULL;
+
+	return RC_OK;
+}
+
+extern RC deleteTable (char *name)
+{
+    if (name == NULL) {
+        printf("Error: [deleteTable]: name of table is null.\n");
+        return RC_ERROR;
+    }
+
+	// Forgetting the table and its indexes in the catalog
+	CatalogEntry *entry = findCatalogEntry(name);
+	if (entry != NULL) {
+		deleteIndexFiles(entry);
+		removeCatalogEntry(entry);
+		saveCatalog();
+	}
+
+	// Removing the page file from memory
+	destroyPageFile(name);
+	
+	return RC_OK;
+}
+
+extern int getNumTuples (RM_TableData *rel)
+{
+    if (rel == NULL) {
+        printf("Error: [getNumTuples]: table data pointer is null.\n");
+        return RC_ERROR;
+    }
+
+	// Accessing our data structure's tuplesCount and returning it
+	RecordManager *recordManager = rel->mgmtData;
+	return recordManager->tuplesCount;
+}
+
+// Function prototypes
+static RC findFreeSlot(RecordManager *mgr, BM_PageHandle *page, RID *rid, int length);
+static RC writeRecordToPage(RecordManager *mgr, BM_PageHandle *page, RID *rid, const char *bytes, int length, int flags);
+static RC pinSlot(RecordManager *mgr, BM_PageHandle *page, RID id);
+RC attrOffset (Schema *schema, int attrNum, int *result);
+
+// Encode a record into a buffer that leaves room for a home RID in front of it
+static char *encodeWithRoom(RecordManager *mgr, Schema *schema, Record *record, int *length) {
+    char *bytes = (char *) malloc(sizeof(RID) + encodedRecordLimit(schema));
+    if (bytes != NULL) {
+        *length = encodeForPage(mgr, schema, record->data + 1, bytes + sizeof(RID));
+    }
+    return bytes;
+}
+
+/* Free-space map
+ *
+ * Page 1 and every FSM_PAGES_PER_MAP + 1 pages after it are map pages instead of data
+ * pages. A map page keeps four bits per data page that follow it, how much room the
+ * page has in steps of PAGE_SIZE / FSM_LEVELS bytes, rounded down. Inserts look there
+ * for a page to use instead of pinning the data pages one after another. A map page
+ * that was never written says every page is full, which is right for pages past the
+ * end of the table.
+ */
+static bool isMapPage(int pageNum) {
+    return pageNum >= 1 && (pageNum - 1) % (FSM_PAGES_PER_MAP + 1) == 0;
+}
+
+// The map page that keeps track of a data page
+static int mapPageOf(int pageNum) {
+    return 1 + ((pageNum - 2) / (FSM_PAGES_PER_MAP + 1)) * (FSM_PAGES_PER_MAP + 1);
+}
+
+static int getMapLevel(char *map, int index) {
+    unsigned char entry = (unsigned char) map[index / 2];
+    return (index % 2 == 0) ? (entry & 0x0F) : (entry >> 4);
+}
+
+static void setMapLevel(char *map, int index, int level) {
+    unsigned char *entry = (unsigned char *) &map[index / 2];
+    *entry = (index % 2 == 0) ? ((*entry & 0xF0) | level) : ((*entry & 0x0F) | (level << 4));
+}
+
+// The level a page needs to have room for a record of the given length and a new slot
+static int levelNeeded(int length) {
+    int bytes = slotBytes(length) + sizeof(SlotEntry);
+    int step = PAGE_SIZE / FSM_LEVELS;
+    return (bytes + step - 1) / step;
+}
+
+// Record in the map how much room a data page has left, freePage is the first data page
+// the map may show any room for. For a PAX page it is the share of slots that are empty,
+// any empty slot at all is level 1 or more.
+static RC noteFreeSpace(RecordManager *mgr, int pageNum, char *page) {
+    BM_PageHandle map;
+    int level;
+    if (mgr->layout == RM_LAYOUT_PAX) {
+        int emptySlots = mgr->paxCapacity - ((SlotPageHeader *) page)->liveSlots;
+        level = (emptySlots > 0) ? 1 + emptySlots * (FSM_LEVELS - 2) / mgr->paxCapacity : 0;
+    } else {
+        level = pageFreeSpace(page, pageFreeSlot(page)) / (PAGE_SIZE / FSM_LEVELS);
+    }
+    if (level >= FSM_LEVELS) {
+        level = FSM_LEVELS - 1;
+    }
+
+    int mapPage = mapPageOf(pageNum);
+    RC status = pinPage(&mgr->bufferPool, &map, mapPage);
+    if (status != RC_OK) {
+        return status;
+    }
+    if (getMapLevel(map.data, pageNum - mapPage - 1) != level) {
+        setMapLevel(map.data, pageNum - mapPage - 1, level);
+        markDirty(&mgr->bufferPool, &map);
+    }
+    if (level > 0 && pageNum < mgr->freePage) {
+        mgr->freePage = pageNum;
+    }
+    return unpinPage(&mgr->bufferPool, &map);
+}
+
+// The first data page from freePage on that the map says has at least the given level,
+// -1 if there is none before the end of the table. Moves freePage past the full pages.
+static int searchFreeSpaceMap(RecordManager *mgr, int level) {
+    BM_PageHandle map;
+    int from = isMapPage(mgr->freePage) ? mgr->freePage + 1 : mgr->freePage;
+    bool full = true;
+
+    for (int mapPage = mapPageOf(from); mapPage < mgr->numPages; mapPage += FSM_PAGES_PER_MAP + 1) {
+        if (pinPage(&mgr->bufferPool, &map, mapPage) != RC_OK) {
+            return -1;
+        }
+        int first = (from > mapPage) ? from - mapPage - 1 : 0;
+        int last = mgr->numPages - mapPage - 1;
+        if (last > FSM_PAGES_PER_MAP) {
+            last = FSM_PAGES_PER_MAP;
+        }
+        for (int i = first; i < last; i++) {
+            int pageLevel = getMapLevel(map.data, i);
+            if (full && pageLevel > 0) {
+                mgr->freePage = mapPage + 1 + i;
+                full = false;
+            }
+            if (pageLevel >= level) {
+                unpinPage(&mgr->bufferPool, &map);
+                return mapPage + 1 + i;
+            }
+        }
+        unpinPage(&mgr->bufferPool, &map);
+    }
+    if (full) {
+        mgr->freePage = mgr->numPages;
+    }
+    return -1;
+}
+
+// The page after the last one of the table, skipping a map page
+static int nextNewPage(RecordManager *mgr) {
+    return isMapPage(mgr->numPages) ? mgr->numPages + 1 : mgr->numPages;
+}
+
+// The key of a record in the layout of Record->data for the index of an attribute
+static Value indexKey(Schema *schema, const char *data, int attrNum) {
+    Value key;
+    int offset;
+
+    attrOffset(schema, attrNum, &offset);
+    key.dt = DT_INT;
+    memcpy(&key.v.intV, data + offset, sizeof(int));
+    return key;
+}
+
+// Take the keys of a record out of the first numIndexes indexes, leaving those it shares
+// with kept, an index that does not have one is left as it is
+static void removeIndexKeys(RecordManager *mgr, int numIndexes, Schema *schema, const char *data, const char *kept, RID id) {
+    for (int i = 0; i < numIndexes; i++) {
+        Value key = indexKey(schema, data, mgr->indexes[i].attrNum);
+
+        if (kept != NULL && indexKey(schema, kept, mgr->indexes[i].attrNum).v.intV == key.v.intV) {
+            continue;
+        }
+        deleteEntry(mgr->indexes[i].tree, &key, id);
+    }
+}
+
+// Enter the keys of a record in every index, leaving out those it shares with old. When
+// an index refuses a key, the keys entered before it are taken out again.
+static RC addIndexKeys(RecordManager *mgr, Schema *schema, const char *data, const char *old, RID id) {
+    for (int i = 0; i < mgr->numIndexes; i++) {
+        TableIndex *index = &mgr->indexes[i];
+        Value key = indexKey(schema, data, index->attrNum);
+
+        if (old != NULL && indexKey(schema, old, index->attrNum).v.intV == key.v.intV) {
+            continue;
+        }
+        RC status = insertEntry(index->tree, &key, id);
+        if (status != RC_OK) {
+            removeIndexKeys(mgr, i, schema, data, old, id);
+            return status;
+        }
+    }
+    return RC_OK;
+}
+
+// Take a record whose keys did not all go into the indexes out of its page again
+static void undoInsert(RecordManager *mgr, RID id) {
+    BM_PageHandle page;
+
+    if (pinPage(&mgr->bufferPool, &page, id.page) == RC_OK) {
+        markDirty(&mgr->bufferPool, &page);
+        removeRecord(mgr, page.data, id.slot);
+        noteFreeSpace(mgr, id.page, page.data);
+        unpinPage(&mgr->bufferPool, &page);
+    }
+}
+
+// Enter the records a table has already in a new index, in the order of the pages
+static RC fillIndex(RecordManager *mgr, Schema *schema, TableIndex *index) {
+    char *data = (char *) calloc(1, getRecordSize(schema));
+    bool *attrs = (bool *) calloc(schema->numAttr, sizeof(bool));
+    BM_PageHandle page;
+    RC status = (data != NULL && attrs != NULL) ? RC_OK : RC_MEMORY_ALLOCATION_FAIL;
+
+    if (status == RC_OK) {
+        attrs[index->attrNum] = true;
+    }
+    for (int pageNum = 1; pageNum < mgr->numPages && status == RC_OK; pageNum++) {
+        if (isMapPage(pageNum)) {
+            continue;
+        }
+        status = pinPage(&mgr->bufferPool, &page, pageNum);
+        if (status != RC_OK) {
+            break;
+        }
+        SlotPageHeader *header = (SlotPageHeader *) page.data;
+
+        for (int slot = 0; header->liveSlots > 0 && (slot = nextUsedSlot(page.data, slot)) < header->numSlots; slot++) {
+            int flags = slotFlags(mgr, page.data, slot);
+            RID id = { pageNum, slot };
+
+            // A moved record is entered with its home RID where it is stored now
+            if (flags & SLOT_FORWARD) {
+                continue;
+            }
+            if (flags & SLOT_MOVED_IN) {
+                memcpy(&id, page.data + PAGE_SLOTS(page.data)[slot].offset, sizeof(RID));
+            }
+            loadRecord(mgr, schema, page.data, slot, data + 1, attrs);
+            Value key = indexKey(schema, data, index->attrNum);
+            status = insertEntry(index->tree, &key, id);
+            if (status != RC_OK) {
+                break;
+            }
+        }
+        unpinPage(&mgr->bufferPool, &page);
+    }
+    free(data);
+    free(attrs);
+    return status;
+}
+
+RC createIndex(RM_TableData *rel, int attrNum) {
+    if (rel == NULL) {
+        printf("Error: [createIndex]: table data pointer is null.\n");
+        return RC_ERROR;
+    }
+
+    RecordManager *mgr = rel->mgmtData;
+    CatalogEntry *entry = findCatalogEntry(rel->name);
+    if (entry == NULL || attrNum < 0 || attrNum >= rel->schema->numAttr || findTableIndex(mgr, attrNum) != NULL) {
+        return RC_INVALID_PARAMETER;
+    }
+    // The B+ tree only keeps int keys
+    if (rel->schema->dataTypes[attrNum] != DT_INT) {
+        return RC_BT_INVALID_KEY_TYPE;
+    }
+    int *indexAttrs = (int *) realloc(entry->indexAttrs, sizeof(int) * (entry->numIndexes + 1));
+    if (indexAttrs == NULL) {
+        return RC_MEMORY_ALLOCATION_FAIL;
+    }
+    entry->indexAttrs = indexAttrs;
+
+    char *fileName = indexFileName(rel->name, attrNum);
+    if (fileName == NULL) {
+        return RC_MEMORY_ALLOCATION_FAIL;
+    }
+    RC status = createBtree(fileName, DT_INT, TABLE_INDEX_ORDER);
+    if (status == RC_OK) {
+        status = openTableIndex(mgr, rel->name, attrNum);
+    }
+    if (status == RC_OK) {
+        status = fillIndex(mgr, rel->schema, &mgr->indexes[mgr->numIndexes - 1]);
+        if (status != RC_OK) {
+            // The table could not be read or the tree not written
+            mgr->numIndexes--;
+            closeBtree(mgr->indexes[mgr->numIndexes].tree);
+            free(mgr->indexes[mgr->numIndexes].fileName);
+        }
+    }
+    if (status != RC_OK) {
+        deleteBtree(fileName);
+        free(fileName);
+        return status;
+    }
+    free(fileName);
+
+    entry->indexAttrs[entry->numIndexes++] = attrNum;
+    return saveCatalog();
+}
+
+RC dropIndex(RM_TableData *rel, int attrNum) {
+    if (rel == NULL) {
+        printf("Error: [dropIndex]: table data pointer is null.\n");
+        return RC_ERROR;
+    }
+
+    RecordManager *mgr = rel->mgmtData;
+    CatalogEntry *entry = findCatalogEntry(rel->name);
+    TableIndex *index = findTableIndex(mgr, attrNum);
+    if (entry == NULL || index == NULL) {
+        return RC_INVALID_PARAMETER;
+    }
+
+    closeBtree(index->tree);
+    deleteBtree(index->fileName);
+    free(index->fileName);
+    *index = mgr->indexes[--mgr->numIndexes];
+
+    for (int i = 0; i < entry->numIndexes; i++) {
+        if (entry->indexAttrs[i] == attrNum) {
+            entry->indexAttrs[i] = entry->indexAttrs[--entry->numIndexes];
+            break;
+        }
+    }
+    return saveCatalog();
+}
+
+RC insertRecord(RM_TableData *rel, Record *record) {
+    // Validate input parameters
+    if (!rel || !record) {
+        return RC_ERROR;
+    }
+
+    RecordManager *mgr = rel->mgmtData;
+    RID *rid = &record->id;
+    BM_PageHandle page;
+    int length;
+
+    char *bytes = encodeWithRoom(mgr, rel->schema, record, &length);
+    if (bytes == NULL) {
+        return RC_MEMORY_ALLOCATION_FAIL;
+    }
+
+    // Find a page with enough space and a slot on it
+    RC status = findFreeSlot(mgr, &page, rid, length);
+    if (status == RC_OK) {
+        // Insert the record
+        status = writeRecordToPage(mgr, &page, rid, bytes + sizeof(RID), length, 0);
+    }
+    free(bytes);
+    if (status != RC_OK) {
+        return status;
+    }
+
+    // A record the indexes do not know is not stored either
+    status = addIndexKeys(mgr, rel->schema, record->data, NULL, *rid);
+    if (status != RC_OK) {
+        undoInsert(mgr, *rid);
+        return status;
+    }
+
+    // Update metadata
+    mgr->tuplesCount++;
+
+    return RC_OK;
+}
+
+RC insertRecords(RM_TableData *rel, Record **records, int numRecords) {
+    // Validate input parameters
+    if (!rel || (!records && numRecords > 0)) {
+        return RC_ERROR;
+    }
+
+    RecordManager *mgr = rel->mgmtData;
+    BM_PageHandle page;
+    RID rid;
+    bool pinned = false;
+    int inserted = 0;
+    RC status = RC_OK;
+
+    char *bytes = (char *) malloc(encodedRecordLimit(rel->schema));
+    if (bytes == NULL) {
+        return RC_MEMORY_ALLOCATION_FAIL;
+    }
+
+    for (int i = 0; i < numRecords && status == RC_OK; i++) {
+        int length = encodeForPage(mgr, rel->schema, records[i]->data + 1, bytes);
+
+        // Keep filling the page that is pinned while the records fit
+        if (pinned) {
+            rid.slot = slotForRecord(mgr, page.data, length);
+            if (rid.slot == -1) {
+                noteFreeSpace(mgr, rid.page, page.data);
+                unpinPage(&mgr->bufferPool, &page);
+                pinned = false;
+            }
+        }
+        if (!pinned) {
+            status = findFreeSlot(mgr, &page, &rid, length);
+            if (status != RC_OK) {
+                break;
+            }
+            pinned = true;
+            markDirty(&mgr->bufferPool, &page);
+        }
+
+        storeRecord(mgr, page.data, rid.slot, bytes, length, 0);
+        status = addIndexKeys(mgr, rel->schema, records[i]->data, NULL, rid);
+        if (status != RC_OK) {
+            undoInsert(mgr, rid);
+            break;
+        }
+        records[i]->id = rid;
+        inserted++;
+    }
+
+    if (pinned) {
+        noteFreeSpace(mgr, rid.page, page.data);
+        unpinPage(&mgr->bufferPool, &page);
+    }
+    free(bytes);
+
+    // Update metadata, the records before a failure stay inserted and the others get no RID
+    mgr->tuplesCount += inserted;
+    for (int i = inserted; i < numRecords; i++) {
+        records[i]->id.page = records[i]->id.slot = -1;
+    }
+
+    return status;
+}
+
+// Pin the first page from freePage on with room for a record of the given length, a
+// page past the last one of the table starts out empty
+static RC findFreeSlot(RecordManager *mgr, BM_PageHandle *page, RID *rid, int length) {
+    // Even an empty page has to hold the record, its slot and a home RID if it ever moves,
+    // createTable made sure a PAX page holds a record
+    if (mgr->layout == RM_LAYOUT_ROW &&
+        slotBytes(sizeof(RID) + length) > PAGE_SIZE - (int) (sizeof(SlotPageHeader) + sizeof(SlotEntry))) {
+        return RC_RM_LIMIT_EXCEEDED;
+    }
+
+    // Every empty PAX slot fits a record
+    int level = (mgr->layout == RM_LAYOUT_PAX) ? 1 : levelNeeded(length);
+
+    while (true) {
+        // The map points to a page with room, otherwise the table grows by a page
+        rid->page = searchFreeSpaceMap(mgr, level);
+        if (rid->page == -1) {
+            rid->page = nextNewPage(mgr);
+        }
+
+        RC status = pinPage(&mgr->bufferPool, page, rid->page);
+        if (status != RC_OK) {
+            return status;
+        }
+
+        rid->slot = slotForRecord(mgr, page->data, length);
+        if (rid->slot != -1) {
+            if (rid->page >= mgr->numPages) {
+                mgr->numPages = rid->page + 1;
+            }
+            return RC_OK;
+        }
+
+        // The map was out of date for this page
+        status = noteFreeSpace(mgr, rid->page, page->data);
+        unpinPage(&mgr->bufferPool, page);
+        if (status != RC_OK) {
+            return status;
+        }
+    }
+}
+
+static RC writeRecordToPage(RecordManager *mgr, BM_PageHandle *page, RID *rid, const char *bytes, int length, int flags) {
+    markDirty(&mgr->bufferPool, page);
+    storeRecord(mgr, page->data, rid->slot, bytes, length, flags);
+    noteFreeSpace(mgr, rid->page, page->data);
+    return unpinPage(&mgr->bufferPool, page);
+}
+
+// Pin the page of a RID, the slot has to hold a record that was stored under that RID
+static RC pinSlot(RecordManager *mgr, BM_PageHandle *page, RID id) {
+    if (id.page < 1 || id.page >= mgr->numPages || isMapPage(id.page) || id.slot < 0) {
+        return RC_RM_NO_TUPLE_WITH_GIVEN_RID;
+    }
+
+    RC status = pinPage(&mgr->bufferPool, page, id.page);
+    if (status != RC_OK) {
+        return status;
+    }
+
+    SlotPageHeader *header = (SlotPageHeader *) page->data;
+    if (id.slot >= header->numSlots || !slotInUse(header, id.slot) ||
+        (slotFlags(mgr, page->data, id.slot) & SLOT_MOVED_IN)) {
+        unpinPage(&mgr->bufferPool, page);
+        return RC_RM_NO_TUPLE_WITH_GIVEN_RID;
+    }
+    return RC_OK;
+}
+
+// The RID a forwarding slot points to
+static RID forwardTarget(char *page, int slot) {
+    RID target;
+    memcpy(&target, page + PAGE_SLOTS(page)[slot].offset, sizeof(RID));
+    return target;
+}
+
+// Read the record stored under a RID into the layout of Record->data, only the
+// attributes set in attrs or all of them if it is NULL
+static RC fetchRecord(RecordManager *manager, Schema *schema, RID id, char *data, const bool *attrs) {
+    BM_PageHandle page;
+    RC status = pinSlot(manager, &page, id);
+    if (status != RC_OK) {
+        return status;
+    }
+
+    int slot = id.slot;
+    if (slotFlags(manager, page.data, slot) & SLOT_FORWARD) {
+        // Follow the record to the page it moved to, its home RID comes first there
+        RID target = forwardTarget(page.data, slot);
+        unpinPage(&manager->bufferPool, &page);
+        status = pinPage(&manager->bufferPool, &page, target.page);
+        if (status != RC_OK) {
+            return status;
+        }
+        slot = target.slot;
+    }
+    loadRecord(manager, schema, page.data, slot, data, attrs);
+
+    return unpinPage(&manager->bufferPool, &page);
+}
+
+RC deleteRecord(RM_TableData *table, RID id) {
+    // Validate input
+    if (table == NULL) {
+        return RC_ERROR;
+    }
+
+    RecordManager *manager = table->mgmtData;
+    BM_PageHandle page;
+    RC status;
+    char *old = NULL;
+
+    // The keys of the record are taken out of the indexes once it is gone
+    if (manager->numIndexes > 0) {
+        old = (char *) malloc(getRecordSize(table->schema));
+        if (old == NULL) {
+            return RC_MEMORY_ALLOCATION_FAIL;
+        }
+        status = fetchRecord(manager, table->schema, id, old + 1, NULL);
+        if (status != RC_OK) {
+            free(old);
+            return status;
+        }
+    }
+
+    // Pin the page containing the record
+    status = pinSlot(manager, &page, id);
+    if (status != RC_OK) {
+        free(old);
+        return status;
+    }
+
+    // A moved record is removed from the page it moved to as well
+    if (slotFlags(manager, page.data, id.slot) & SLOT_FORWARD) {
+        RID target = forwardTarget(page.data, id.slot);
+        BM_PageHandle targetPage;
+        status = pinPage(&manager->bufferPool, &targetPage, target.page);
+        if (status != RC_OK) {
+            unpinPage(&manager->bufferPool, &page);
+            free(old);
+            return status;
+        }
+        markDirty(&manager->bufferPool, &targetPage);
+        clearSlot(targetPage.data, target.slot);
+        noteFreeSpace(manager, target.page, targetPage.data);
+        unpinPage(&manager->bufferPool, &targetPage);
+    }
+
+    // Mark the page as dirty since we're modifying it
+    status = markDirty(&manager->bufferPool, &page);
+    if (status != RC_OK) {
+        unpinPage(&manager->bufferPool, &page);
+        free(old);
+        return status;
+    }
+
+    // Empty the slot, its space is taken back when the page is compacted
+    removeRecord(manager, page.data, id.slot);
+
+    // Let inserts find the space in the free-space map
+    noteFreeSpace(manager, id.page, page.data);
+    manager->tuplesCount--;
+
+    if (old != NULL) {
+        removeIndexKeys(manager, manager->numIndexes, table->schema, old, NULL, id);
+        free(old);
+    }
+
+    // Unpin the page
+    status = unpinPage(&manager->bufferPool, &page);
+    if (status != RC_OK) {
+        return status;
+    }
+
+    return RC_OK;
+}
+
+// Store a record that no longer fits on its home page on another page, behind its home RID
+static RC moveRecord(RecordManager *mgr, RID home, char *bytes, int length, RID *target) {
+    BM_PageHandle page;
+
+    memcpy(bytes, &home, sizeof(RID));
+    RC status = findFreeSlot(mgr, &page, target, sizeof(RID) + length);
+    if (status != RC_OK) {
+        return status;
+    }
+    return writeRecordToPage(mgr, &page, target, bytes, sizeof(RID) + length, SLOT_MOVED_IN);
+}
+
+// Update a record that moved away from its home slot, the home page is pinned
+static RC updateMovedRecord(RecordManager *mgr, BM_PageHandle *page, RID id, char *bytes, int length) {
+    SlotEntry *entry = &PAGE_SLOTS(page->data)[id.slot];
+    RID target = forwardTarget(page->data, id.slot);
+    BM_PageHandle targetPage;
+
+    RC status = pinPage(&mgr->bufferPool, &targetPage, target.page);
+    if (status != RC_OK) {
+        return status;
+    }
+    SlotEntry *moved = &PAGE_SLOTS(targetPage.data)[target.slot];
+
+    if (slotBytes(sizeof(RID) + length) <= moved->length) {
+        // Still fits where it moved to, rewrite it behind its home RID
+        memcpy(targetPage.data + moved->offset + sizeof(RID), bytes + sizeof(RID), length);
+    } else {
+        // Otherwise it goes back home if there is room now, or moves on to another page
+        if (pageFreeSpace(page->data, id.slot) >= slotBytes(length)) {
+            clearSlot(page->data, id.slot);
+            placeRecord(page->data, id.slot, bytes + sizeof(RID), length, 0);
+        } else {
+            RID next;
+            status = moveRecord(mgr, id, bytes, length, &next);
+            if (status == RC_OK) {
+                memcpy(page->data + entry->offset, &next, sizeof(RID));
+            }
+        }
+        if (status == RC_OK) {
+            clearSlot(targetPage.data, target.slot);
+        }
+    }
+
+    if (status == RC_OK) {
+        markDirty(&mgr->bufferPool, &targetPage);
+        noteFreeSpace(mgr, target.page, targetPage.data);
+    }
+    unpinPage(&mgr->bufferPool, &targetPage);
+    return status;
+}
+
+RC updateRecord(RM_TableData *table, Record *record) {
+    // Validate input parameters
+    if (table == NULL || record == NULL) {
+        return RC_ERROR;
+    }
+
+    RecordManager *manager = table->mgmtData;
+    RID id = record->id;
+    BM_PageHandle page;
+    int length;
+    RC status;
+    char *old = NULL;
+
+    // The new keys go into the indexes before the record changes, the old keys that
+    // changed come out once it is written. A failure on the way leaves both as they were.
+    if (manager->numIndexes > 0) {
+        old = (char *) malloc(getRecordSize(table->schema));
+        if (old == NULL) {
+            return RC_MEMORY_ALLOCATION_FAIL;
+        }
+        status = fetchRecord(manager, table->schema, id, old + 1, NULL);
+        if (status == RC_OK) {
+            status = addIndexKeys(manager, table->schema, record->data, old, id);
+        }
+        if (status != RC_OK) {
+            free(old);
+            return status;
+        }
+    }
+
+    char *bytes = encodeWithRoom(manager, table->schema, record, &length);
+    // Pin the page containing the record
+    status = (bytes != NULL) ? pinSlot(manager, &page, id) : RC_MEMORY_ALLOCATION_FAIL;
+    if (status != RC_OK) {
+        if (old != NULL) {
+            removeIndexKeys(manager, manager->numIndexes, table->schema, record->data, old, id);
+        }
+        free(bytes);
+        free(old);
+        return status;
+    }
+
+    if (manager->layout == RM_LAYOUT_PAX) {
+        // A PAX record never changes its size, rewrite it in its slot
+        paxWrite(manager, page.data, id.slot, bytes + sizeof(RID));
+    } else {
+        SlotEntry *entry = &PAGE_SLOTS(page.data)[id.slot];
+        SlotEntry old = *entry;
+
+        if (old.flags & SLOT_FORWARD) {
+            status = updateMovedRecord(manager, &page, id, bytes, length);
+        } else if (slotBytes(length) <= old.length) {
+            // Shrinks or keeps its size, rewrite it in place
+            memcpy(page.data + old.offset, bytes + sizeof(RID), length);
+        } else {
+            // Grows: give its space back and store it again on this page if it fits
+            if (pageFreeSpace(page.data, id.slot) >= slotBytes(length)) {
+                clearSlot(page.data, id.slot);
+                placeRecord(page.data, id.slot, bytes + sizeof(RID), length, 0);
+            } else {
+                // The record moves, its old space holds at least the RID of the new slot
+                RID target;
+                status = moveRecord(manager, id, bytes, length, &target);
+                if (status == RC_OK) {
+                    memcpy(page.data + old.offset, &target, sizeof(RID));
+                    entry->flags = SLOT_FORWARD;
+                }
+            }
+        }
+    }
+
+    // Mark the page as dirty since we modified it
+    if (status == RC_OK) {
+        markDirty(&manager->bufferPool, &page);
+        noteFreeSpace(manager, id.page, page.data);
+    }
+    unpinPage(&manager->bufferPool, &page);
+    free(bytes);
+    if (old != NULL) {
+        if (status == RC_OK) {
+            removeIndexKeys(manager, manager->numIndexes, table->schema, old, record->data, id);
+        } else {
+            removeIndexKeys(manager, manager->numIndexes, table->schema, record->data, old, id);
+        }
+    }
+    free(old);
+    return status;
+}
+
+RC getRecord(RM_TableData* table, RID id, Record* record) {
+    if (!table || !record) {
+        printf("Error: Invalid table or record.\n");
+        return RC_ERROR;
+    }
+
+    RC status = fetchRecord(table->mgmtData, table->schema, id, record->data + 1, NULL);
+    if (status != RC_OK) {
+        return status;
+    }
+    record->id = id;
+
+    return RC_OK;
+}
+
+RC getRecordView(RM_TableData *rel, RID id, RecordView *view) {
+    if (!rel || !view) {
+        printf("Error: Invalid table or view.\n");
+        return RC_ERROR;
+    }
+
+    RecordManager *manager = rel->mgmtData;
+    BM_PageHandle page;
+    RC status = pinSlot(manager, &page, id);
+    if (status != RC_OK) {
+        return status;
+    }
+
+    // The page a record moved to stays pinned instead of its home page
+    int slot = id.slot;
+    if (slotFlags(manager, page.data, slot) & SLOT_FORWARD) {
+        RID target = forwardTarget(page.data, slot);
+        unpinPage(&manager->bufferPool, &page);
+        status = pinPage(&manager->bufferPool, &page, target.page);
+        if (status != RC_OK) {
+            return status;
+        }
+        slot = target.slot;
+    }
+
+    view->id = id;
+    view->rel = rel;
+    view->page = page.data;
+    view->pageNum = page.pageNum;
+    view->slot = slot;
+    return RC_OK;
+}
+
+RC getViewAttr(RecordView *view, Schema *schema, int attrNum, Value **value) {
+    if (!view || !view->page || !schema || !value || attrNum < 0 || attrNum >= schema->numAttr) {
+        printf("Error: [getViewAttr]: invalid view, schema or attribute.\n");
+        return RC_ERROR;
+    }
+
+    RecordManager *manager = view->rel->mgmtData;
+    const char *bytes;
+    int length = attrSize(schema, attrNum);
+
+    if (manager->layout == RM_LAYOUT_PAX) {
+        bytes = view->page + manager->paxOffsets[attrNum] + view->slot * manager->paxWidths[attrNum];
+        if (schema->dataTypes[attrNum] == DT_STRING) {
+            length = strnlen(bytes, length);
+        }
+    } else {
+        // Walk the encoded attributes before it, strings carry their length
+        SlotEntry *entry = &PAGE_SLOTS(view->page)[view->slot];
+        bytes = view->page + entry->offset + ((entry->flags & SLOT_MOVED_IN) ? sizeof(RID) : 0);
+        for (int i = 0; i < attrNum; i++) {
+            if (schema->dataTypes[i] == DT_STRING) {
+                unsigned short skip;
+                memcpy(&skip, bytes, sizeof(skip));
+                bytes += sizeof(skip) + skip;
+            } else {
+                bytes += attrSize(schema, i);
+            }
+        }
+        if (schema->dataTypes[attrNum] == DT_STRING) {
+            unsigned short stored;
+            memcpy(&stored, bytes, sizeof(stored));
+            bytes += sizeof(stored);
+            length = stored;
+        }
+    }
+
+    Value *attrValue = (Value *) malloc(sizeof(Value));
+    if (attrValue == NULL) {
+        return RC_MEMORY_ALLOCATION_FAIL;
+    }
+    attrValue->dt = schema->dataTypes[attrNum];
+    switch (schema->dataTypes[attrNum]) {
+        case DT_STRING:
+            attrValue->v.stringV = (char *) malloc(length + 1);
+            if (attrValue->v.stringV == NULL) {
+                free(attrValue);
+                return RC_MEMORY_ALLOCATION_FAIL;
+            }
+            memcpy(attrValue->v.stringV, bytes, length);
+            attrValue->v.stringV[length] = '\0';
+            break;
+        case DT_INT:
+            memcpy(&attrValue->v.intV, bytes, sizeof(int));
+            break;
+        case DT_FLOAT:
+            memcpy(&attrValue->v.floatV, bytes, sizeof(float));
+            break;
+        case DT_BOOL:
+            memcpy(&attrValue->v.boolV, bytes, sizeof(bool));
+            break;
+        default:
+            free(attrValue);
+            return RC_ERROR;
+    }
+
+    *value = attrValue;
+    return RC_OK;
+}
+
+RC releaseRecordView(RecordView *view) {
+    if (!view || !view->page) {
+        printf("Error: [releaseRecordView]: view is not held.\n");
+        return RC_ERROR;
+    }
+
+    RecordManager *manager = view->rel->mgmtData;
+    BM_PageHandle page;
+    page.pageNum = view->pageNum;
+    page.data = view->page;
+    view->page = NULL;
+    return unpinPage(&manager->bufferPool, &page);
+}
+
+// Whether a record satisfies the condition of a scan
+static RC matchesCondition(RecordManager *scanManager, Schema *schema, Record *record, bool *match) {
+    if (scanManager->program != NULL) {
+        *match = runExprProgram(scanManager->program, record->data);
+        return RC_OK;
+    }
+
+    Value *result;
+    RC status = evalExpr(record, schema, scanManager->condition, &result);
+    if (status != RC_OK) {
+        return status;
+    }
+    *match = (result->dt == DT_BOOL && result->v.boolV);
+    freeVal(result);
+    return RC_OK;
+}
+
+// Where a scan loads a record before it checks the condition. One that returns only some
+// attributes loads it into its own row, so the condition can read attributes the caller
+// does not get back.
+static char *scanRecordData(RecordManager *scanManager, Record *record) {
+    return (scanManager->scanRow != NULL) ? scanManager->scanRow : record->data;
+}
+
+// Whether a record loaded into scanRecordData satisfies the condition of a scan, the
+// attributes it returns are copied into the record if it does
+static RC matchesScanRecord(RecordManager *scanManager, Schema *schema, Record *record, bool *match) {
+    if (scanManager->scanRow == NULL) {
+        return matchesCondition(scanManager, schema, record, match);
+    }
+
+    Record row;
+    row.id = record->id;
+    row.data = scanManager->scanRow;
+    RC status = matchesCondition(scanManager, schema, &row, match);
+    if (status == RC_OK && *match) {
+        copyAttrs(schema, scanManager->returnAttrs, record->data, row.data);
+    }
+    return status;
+}
+
+/* Parallel scans
+ *
+ * A scan started with more than one thread in its options hands the pages of the table
+ * out to worker threads, PARALLEL_SCAN_CHUNK_PAGES at a time, to whichever worker asks
+ * next. The buffer pool is not thread safe, so the scan writes every dirty page of the
+ * table when it starts, pinned ones included, and the workers read the page file
+ * themselves with readBlocks. Every worker puts the
+ * records that satisfy the condition into a queue of its own, next() and nextBatch take
+ * them from the queues in no particular order. The table must not change while a
+ * parallel scan is open, and the scan does not start over after its last record.
+ */
+typedef struct ScanQueue
+{
+    char *rows;     // records in the layout of Record->data, a ring of capacity rows
+    RID *ids;
+    int head;
+    int count;
+    int capacity;
+    bool done;      // the worker put its last record in the queue
+} ScanQueue;
+
+typedef struct ParallelScan
+{
+    RecordManager *table;
+    RecordManager *scan;
+    Schema *schema;
+    SM_FileHandle fileHandle;
+    int numPages;
+    int recordSize;
+    // First page of the chunk the next worker takes
+    int nextPage;
+    int numThreads;
+    pthread_t *threads;
+    struct ScanWorker *workers;
+    ScanQueue *queues;
+    // Queue a consumer looks at first, so no worker waits on a full queue for long
+    int nextQueue;
+    // Set by closeScan to end the workers early
+    bool stop;
+    // First error of a worker
+    RC status;
+    pthread_mutex_t lock;
+    pthread_cond_t filled;
+    pthread_cond_t drained;
+} ParallelScan;
+
+typedef struct ScanWorker
+{
+    ParallelScan *parallel;
+    int index;
+} ScanWorker;
+
+// Put the matching records of a page into a worker's queue, waiting for room. Returns
+// false if the scan was closed meanwhile.
+static bool pushScanRows(ParallelScan *parallel, ScanQueue *queue, const char *rows, const RID *ids, int numRows) {
+    pthread_mutex_lock(&parallel->lock);
+    for (int i = 0; i < numRows; i++) {
+        while (queue->count == queue->capacity && !parallel->stop) {
+            pthread_cond_wait(&parallel->drained, &parallel->lock);
+        }
+        if (parallel->stop) {
+            break;
+        }
+        int tail = (queue->head + queue->count) % queue->capacity;
+        memcpy(queue->rows + tail * parallel->recordSize, rows + i * parallel->recordSize, parallel->recordSize);
+        queue->ids[tail] = ids[i];
+        queue->count++;
+        pthread_cond_signal(&parallel->filled);
+    }
+    bool open = !parallel->stop;
+    pthread_mutex_unlock(&parallel->lock);
+    return open;
+}
+
+static void *parallelScanWorker(void *arg) {
+    ScanWorker *worker = (ScanWorker *) arg;
+    ParallelScan *parallel = worker->parallel;
+    ScanQueue *queue = &parallel->queues[worker->index];
+    SM_FileHandle fileHandle = parallel->fileHandle;
+    int recordSize = parallel->recordSize;
+    int pageNums[PARALLEL_SCAN_CHUNK_PAGES];
+    SM_PageHandle pages[PARALLEL_SCAN_CHUNK_PAGES];
+    char *chunk = (char *) malloc(PARALLEL_SCAN_CHUNK_PAGES * PAGE_SIZE);
+    char *rows = (char *) calloc(MAX_PAGE_SLOTS, recordSize);
+    RID *ids = (RID *) malloc(sizeof(RID) * MAX_PAGE_SLOTS);
+    RC status = (chunk != NULL && rows != NULL && ids != NULL) ? RC_OK : RC_MEMORY_ALLOCATION_FAIL;
+    bool open = true;
+
+    while (status == RC_OK && open) {
+        pthread_mutex_lock(&parallel->lock);
+        int first = parallel->nextPage;
+        parallel->nextPage += PARALLEL_SCAN_CHUNK_PAGES;
+        open = !parallel->stop;
+        pthread_mutex_unlock(&parallel->lock);
+        if (!open || first >= parallel->numPages) {
+            break;
+        }
+
+        // Read the data pages of the chunk in one go
+        int numPages = 0;
+        for (int pageNum = first; pageNum < first + PARALLEL_SCAN_CHUNK_PAGES && pageNum < parallel->numPages; pageNum++) {
+            if (!isMapPage(pageNum)) {
+                pageNums[numPages] = pageNum;
+                pages[numPages] = chunk + numPages * PAGE_SIZE;
+                numPages++;
+            }
+        }
+        status = readBlocks(numPages, pageNums, &fileHandle, pages);
+
+        for (int p = 0; p < numPages && status == RC_OK && open; p++) {
+            char *page = pages[p];
+            SlotPageHeader *header = (SlotPageHeader *) page;
+            int numRows = 0;
+
+            for (int slot = 0; header->liveSlots > 0 && (slot = nextUsedSlot(page, slot)) < header->numSlots; slot++) {
+                int flags = slotFlags(parallel->table, page, slot);
+                Record record;
+                bool match;
+
+                // A moved record is returned where it is stored now
+                if (flags & SLOT_FORWARD) {
+                    continue;
+                }
+                record.id.page = pageNums[p];
+                record.id.slot = slot;
+                if (flags & SLOT_MOVED_IN) {
+                    memcpy(&record.id, page + PAGE_SLOTS(page)[slot].offset, sizeof(RID));
+                }
+                record.data = rows + numRows * recordSize;
+                record.data[0] = '-';
+                loadRecord(parallel->table, parallel->schema, page, slot, record.data + 1, parallel->scan->scanAttrs);
+
+                status = matchesCondition(parallel->scan, parallel->schema, &record, &match);
+                if (status != RC_OK) {
+                    break;
+                }
+                if (match) {
+                    ids[numRows++] = record.id;
+                }
+            }
+            if (status == RC_OK && numRows > 0) {
+                open = pushScanRows(parallel, queue, rows, ids, numRows);
+            }
+        }
+    }
+
+    free(chunk);
+    free(rows);
+    free(ids);
+    pthread_mutex_lock(&parallel->lock);
+    queue->done = true;
+    if (status != RC_OK && parallel->status == RC_OK) {
+        parallel->status = status;
+    }
+    pthread_cond_broadcast(&parallel->filled);
+    pthread_mutex_unlock(&parallel->lock);
+    return NULL;
+}
+
+// Take up to maxRows records out of the queues, waiting until there is one or the
+// workers are done
+static RC popScanRows(ParallelScan *parallel, Record *records, int maxRows, int *numRows) {
+    *numRows = 0;
+    pthread_mutex_lock(&parallel->lock);
+    while (true) {
+        bool done = true;
+        for (int k = 0; k < parallel->numThreads && *numRows < maxRows; k++) {
+            int index = (parallel->nextQueue + k) % parallel->numThreads;
+            ScanQueue *queue = &parallel->queues[index];
+            while (queue->count > 0 && *numRows < maxRows) {
+                Record *record = &records[(*numRows)++];
+                copyAttrs(parallel->schema, parallel->scan->returnAttrs, record->data, queue->rows + queue->head * parallel->recordSize);
+                record->id = queue->ids[queue->head];
+                queue->head = (queue->head + 1) % queue->capacity;
+                queue->count--;
+            }
+            done = done && queue->done && queue->count == 0;
+        }
+        if (*numRows > 0) {
+            parallel->nextQueue = (parallel->nextQueue + 1) % parallel->numThreads;
+            pthread_cond_broadcast(&parallel->drained);
+            pthread_mutex_unlock(&parallel->lock);
             return RC_OK;
         }
-
-        unpinPage(&mgr->bufferPool, &mgr->pageHandle);
-        rid->page++;
+        if (done) {
+            RC status = parallel->status;
+            pthread_mutex_unlock(&parallel->lock);
+            return (status != RC_OK) ? status : RC_RM_NO_MORE_TUPLES;
+        }
+        pthread_cond_wait(&parallel->filled, &parallel->lock);
     }
 }
 
-static RC writeRecordToPage(RecordManager *mgr, RID *rid, Record *record, int recordSize) {
-    markDirty(&mgr->bufferPool, &mgr->pageHandle);
-
-    char *slotPtr = mgr->pageHandle.data + (rid->slot * recordSize);
-    *slotPtr = '+';  // Mark slot as occupied
-    memcpy(slotPtr + 1, record->data + 1, recordSize - 1);
-
-    return unpinPage(&mgr->bufferPool, &mgr->pageHandle);
+static void freeParallelScan(ParallelScan *parallel) {
+    for (int i = 0; parallel->queues != NULL && i < parallel->numThreads; i++) {
+        free(parallel->queues[i].rows);
+        free(parallel->queues[i].ids);
+    }
+    pthread_mutex_destroy(&parallel->lock);
+    pthread_cond_destroy(&parallel->filled);
+    pthread_cond_destroy(&parallel->drained);
+    free(parallel->queues);
+    free(parallel->threads);
+    free(parallel->workers);
+    free(parallel);
 }
 
-RC deleteRecord(RM_TableData *table, RID id) {
-    // Validate input
-    if (table == NULL) {
-        return RC_ERROR;
+// Stop the first numStarted workers of a parallel scan, wait for them and free the scan
+static void stopParallelScan(ParallelScan *parallel, int numStarted) {
+    pthread_mutex_lock(&parallel->lock);
+    parallel->stop = true;
+    pthread_cond_broadcast(&parallel->drained);
+    pthread_mutex_unlock(&parallel->lock);
+    for (int i = 0; i < numStarted; i++) {
+        pthread_join(parallel->threads[i], NULL);
     }
+    freeParallelScan(parallel);
+}
 
-    RecordManager *manager = table->mgmtData;
-    int recordSize = getRecordSize(table->schema);
-    RC status;
-
-    // Pin the page containing the record
-    status = pinPage(&manager->bufferPool, &manager->pageHandle, id.page);
+// Write every dirty page of a table to its file. forceFlushPool leaves the pinned ones
+// alone, a record view or another open scan may hold a page an update made dirty since.
+static RC flushTablePages(RecordManager *mgr) {
+    RC status = forceFlushPool(&mgr->bufferPool);
     if (status != RC_OK) {
         return status;
     }
 
-    // Mark the page as dirty since we're modifying it
-    status = markDirty(&manager->bufferPool, &manager->pageHandle);
-    if (status != RC_OK) {
-        unpinPage(&manager->bufferPool, &manager->pageHandle);
-        return status;
+    PageNumber *contents = getFrameContents(&mgr->bufferPool);
+    bool *dirty = getDirtyFlags(&mgr->bufferPool);
+    if (contents == NULL || dirty == NULL) {
+        status = RC_MEMORY_ALLOCATION_FAIL;
     }
+    for (int i = 0; status == RC_OK && i < mgr->bufferPool.numPages; i++) {
+        if (dirty[i] && contents[i] != NO_PAGE) {
+            BM_PageHandle page;
+            page.pageNum = contents[i];
+            page.data = NULL;
+            status = forcePage(&mgr->bufferPool, &page);
+        }
+    }
+    free(contents);
+    free(dirty);
+    return status;
+}
 
-    // Calculate the position of the record in the page
-    char *dataPointer = manager->pageHandle.data + (id.slot * recordSize);
-
-    // Mark the record as deleted by setting its tombstone
-    *dataPointer = '-';
-
-    // Update the free page pointer
-    manager->freePage = id.page;
+static RC startParallelScan(RM_TableData *rel, RecordManager *scanManager, int numThreads) {
+    RecordManager *tableManager = rel->mgmtData;
+    SM_FileHandle fileHandle;
 
-    // Unpin the page
-    status = unpinPage(&manager->bufferPool, &manager->pageHandle);
+    // The workers read the pages from the file instead of the buffer pool, so every
+    // page that changed has to be written first, pinned or not
+    RC status = flushTablePages(tableManager);
+    if (status == RC_OK) {
+        status = openPageFile(rel->name, &fileHandle);
+    }
     if (status != RC_OK) {
         return status;
     }
+    closePageFile(&fileHandle);
+
+    ParallelScan *parallel = (ParallelScan *) calloc(1, sizeof(ParallelScan));
+    if (parallel == NULL) {
+        return RC_MEMORY_ALLOCATION_FAIL;
+    }
+    parallel->table = tableManager;
+    parallel->scan = scanManager;
+    parallel->schema = rel->schema;
+    parallel->fileHandle = fileHandle;
+    parallel->numPages = (tableManager->numPages < fileHandle.totalNumPages) ? tableManager->numPages : fileHandle.totalNumPages;
+    parallel->recordSize = getRecordSize(rel->schema);
+    parallel->nextPage = 1;
+    parallel->status = RC_OK;
+    parallel->numThreads = numThreads;
+    parallel->threads = (pthread_t *) malloc(sizeof(pthread_t) * numThreads);
+    parallel->workers = (ScanWorker *) malloc(sizeof(ScanWorker) * numThreads);
+    parallel->queues = (ScanQueue *) calloc(numThreads, sizeof(ScanQueue));
+    pthread_mutex_init(&parallel->lock, NULL);
+    pthread_cond_init(&parallel->filled, NULL);
+    pthread_cond_init(&parallel->drained, NULL);
+
+    bool allocated = parallel->threads != NULL && parallel->workers != NULL && parallel->queues != NULL;
+    for (int i = 0; i < numThreads && allocated; i++) {
+        parallel->queues[i].capacity = PARALLEL_SCAN_QUEUE_ROWS;
+        parallel->queues[i].rows = (char *) malloc((size_t) PARALLEL_SCAN_QUEUE_ROWS * parallel->recordSize);
+        parallel->queues[i].ids = (RID *) malloc(sizeof(RID) * PARALLEL_SCAN_QUEUE_ROWS);
+        allocated = parallel->queues[i].rows != NULL && parallel->queues[i].ids != NULL;
+    }
+    if (!allocated) {
+        freeParallelScan(parallel);
+        return RC_MEMORY_ALLOCATION_FAIL;
+    }
+
+    for (int i = 0; i < numThreads; i++) {
+        parallel->workers[i].parallel = parallel;
+        parallel->workers[i].index = i;
+        if (pthread_create(&parallel->threads[i], NULL, parallelScanWorker, &parallel->workers[i]) != 0) {
+            stopParallelScan(parallel, i);
+            return RC_ERROR;
+        }
+    }
 
+    scanManager->parallel = parallel;
     return RC_OK;
 }
 
-RC updateRecord(RM_TableData *table, Record *record) {
-    // Validate input parameters
-    if (table == NULL || record == NULL) {
-        return RC_ERROR;
+// Mark the attributes an expression reads
+static void markExprAttrs(Expr *expr, Schema *schema, bool *attrs) {
+    if (expr->type == EXPR_ATTRREF) {
+        if (expr->expr.attrRef >= 0 && expr->expr.attrRef < schema->numAttr) {
+            attrs[expr->expr.attrRef] = true;
+        }
+    } else if (expr->type == EXPR_OP) {
+        markExprAttrs(expr->expr.op->args[0], schema, attrs);
+        if (expr->expr.op->type != OP_BOOL_NOT) {
+            markExprAttrs(expr->expr.op->args[1], schema, attrs);
+        }
     }
+}
 
-    RecordManager *manager = table->mgmtData;
-    int recordSize = getRecordSize(table->schema);
-    RC status;
+static void freeScanAttrs(RecordManager *scanManager) {
+    free(scanManager->scanAttrs);
+    free(scanManager->returnAttrs);
+    free(scanManager->scanRow);
+    scanManager->scanAttrs = NULL;
+    scanManager->returnAttrs = NULL;
+    scanManager->scanRow = NULL;
+}
 
-    // Pin the page containing the record
-    status = pinPage(&manager->bufferPool, &manager->pageHandle, record->id.page);
-    if (status != RC_OK) {
-        return status;
+// Work out which attributes a scan that returns only some of them has to load: those it
+// returns and those the condition needs to be evaluated
+static RC initScanAttrs(RecordManager *scanManager, Schema *schema, Expr *cond, const RM_ScanOptions *options) {
+    if (options == NULL || options->attrs == NULL) {
+        return RC_OK;
+    }
+    int numAttr = (schema->numAttr > 0) ? schema->numAttr : 1;
+    scanManager->scanAttrs = (bool *) calloc(numAttr, sizeof(bool));
+    scanManager->returnAttrs = (bool *) calloc(numAttr, sizeof(bool));
+    scanManager->scanRow = (char *) calloc(1, getRecordSize(schema));
+    if (scanManager->scanAttrs == NULL || scanManager->returnAttrs == NULL || scanManager->scanRow == NULL) {
+        freeScanAttrs(scanManager);
+        return RC_MEMORY_ALLOCATION_FAIL;
     }
+    scanManager->scanRow[0] = '-';
+    for (int i = 0; i < options->numAttrs; i++) {
+        if (options->attrs[i] < 0 || options->attrs[i] >= schema->numAttr) {
+            printf("Error: [startScan]: no attribute %d to return.\n", options->attrs[i]);
+            freeScanAttrs(scanManager);
+            return RC_INVALID_PARAMETER;
+        }
+        scanManager->scanAttrs[options->attrs[i]] = true;
+        scanManager->returnAttrs[options->attrs[i]] = true;
+    }
+    markExprAttrs(cond, schema, scanManager->scanAttrs);
+    return RC_OK;
+}
 
-    // Mark the page as dirty since we're modifying it
-    status = markDirty(&manager->bufferPool, &manager->pageHandle);
-    if (status != RC_OK) {
-        unpinPage(&manager->bufferPool, &manager->pageHandle);
-        return status;
+static bool isIntConstant(Expr *expr, int *value) {
+    if (expr->type != EXPR_CONST || expr->expr.cons->dt != DT_INT) {
+        return false;
     }
+    *value = expr->expr.cons->v.intV;
+    return true;
+}
 
-    // Calculate the position of the record in the page
-    char *dataPointer = manager->pageHandle.data + (record->id.slot * recordSize);
+static bool isAttrRef(Expr *expr, int attrNum) {
+    return expr->type == EXPR_ATTRREF && expr->expr.attrRef == attrNum;
+}
 
-    // Update the record
-    *dataPointer = '+';  // Set the tombstone to indicate a valid record
-    memcpy(dataPointer + 1, record->data + 1, recordSize - 1);
+// Narrow the keys from low to high an attribute can have to those the condition allows.
+// Only comparisons with an int constant that are part of the condition through ANDs
+// count, the rest of the condition is left to the records the index returns.
+static void narrowIndexRange(Expr *expr, int attrNum, long long *low, long long *high) {
+    if (expr->type != EXPR_OP) {
+        return;
+    }
+    Expr **args = expr->expr.op->args;
+    int value;
 
-    // Unpin the page
-    status = unpinPage(&manager->bufferPool, &manager->pageHandle);
-    if (status != RC_OK) {
-        return status;
+    switch (expr->expr.op->type) {
+        case OP_BOOL_AND:
+            narrowIndexRange(args[0], attrNum, low, high);
+            narrowIndexRange(args[1], attrNum, low, high);
+            break;
+        case OP_COMP_EQUAL:
+            if ((isAttrRef(args[0], attrNum) && isIntConstant(args[1], &value)) ||
+                (isAttrRef(args[1], attrNum) && isIntConstant(args[0], &value))) {
+                *low = (value > *low) ? value : *low;
+                *high = (value < *high) ? value : *high;
+            }
+            break;
+        case OP_COMP_SMALLER:
+            if (isAttrRef(args[0], attrNum) && isIntConstant(args[1], &value)) {
+                *high = (value - 1LL < *high) ? value - 1LL : *high;
+            } else if (isAttrRef(args[1], attrNum) && isIntConstant(args[0], &value)) {
+                *low = (value + 1LL > *low) ? value + 1LL : *low;
+            }
+            break;
+        case OP_BOOL_NOT:
+            // Not smaller is greater or equal, and the other way round
+            if (args[0]->type == EXPR_OP && args[0]->expr.op->type == OP_COMP_SMALLER) {
+                Expr **compared = args[0]->expr.op->args;
+                if (isAttrRef(compared[0], attrNum) && isIntConstant(compared[1], &value)) {
+                    *low = (value > *low) ? value : *low;
+                } else if (isAttrRef(compared[1], attrNum) && isIntConstant(compared[0], &value)) {
+                    *high = (value < *high) ? value : *high;
+                }
+            }
+            break;
+        default:
+            break;
     }
+}
 
+// Let a scan take its records from an index if its condition limits an indexed attribute
+// to a range of keys
+static RC initIndexScan(RecordManager *tableManager, RecordManager *scanManager, Expr *cond) {
+    for (int i = 0; i < tableManager->numIndexes; i++) {
+        long long low = INT_MIN, high = INT_MAX;
+        narrowIndexRange(cond, tableManager->indexes[i].attrNum, &low, &high);
+        if (low == INT_MIN && high == INT_MAX) {
+            continue;
+        }
+
+        IndexScan *indexScan = (IndexScan *) calloc(1, sizeof(IndexScan));
+        if (indexScan == NULL) {
+            return RC_MEMORY_ALLOCATION_FAIL;
+        }
+        indexScan->attrNum = tableManager->indexes[i].attrNum;
+        indexScan->empty = (low > high);
+        indexScan->low = (int) low;
+        indexScan->high = (int) high;
+        scanManager->indexScan = indexScan;
+        return RC_OK;
+    }
     return RC_OK;
 }
 
-RC getRecord(RM_TableData* table, RID id, Record* record) {
-    if (!table || !record) {
-        printf("Error: Invalid table or record.\n");
-        return RC_ERROR;
+// Look up the RIDs of the keys in the range of an index scan, in key order. The scan
+// takes them all at once, so changes to the table while it runs do not move it along
+// the leaves of the tree.
+static RC collectIndexRids(RecordManager *tableManager, IndexScan *indexScan) {
+    TableIndex *index = findTableIndex(tableManager, indexScan->attrNum);
+    BT_ScanHandle *treeScan;
+    int capacity = 16;
+    RID id;
+
+    indexScan->numRids = 0;
+    indexScan->position = 0;
+    indexScan->collected = true;
+    if (indexScan->empty) {
+        return RC_OK;
+    }
+    if (index == NULL) {
+        return RC_INVALID_PARAMETER;
+    }
+
+    Value low = { DT_INT }, high = { DT_INT };
+    low.v.intV = indexScan->low;
+    high.v.intV = indexScan->high;
+    if (openTreeRangeScan(index->tree, indexScan->low == INT_MIN ? NULL : &low,
+                          indexScan->high == INT_MAX ? NULL : &high, &treeScan) != RC_OK) {
+        // An empty tree has nothing to scan
+        return RC_OK;
+    }
+    RC status = RC_OK;
+    while (nextEntry(treeScan, &id) == RC_OK) {
+        if (indexScan->rids == NULL || indexScan->numRids == capacity) {
+            capacity = (indexScan->rids == NULL) ? capacity : capacity * 2;
+            RID *grown = (RID *) realloc(indexScan->rids, sizeof(RID) * capacity);
+            if (grown == NULL) {
+                status = RC_MEMORY_ALLOCATION_FAIL;
+                break;
+            }
+            indexScan->rids = grown;
+        }
+        indexScan->rids[indexScan->numRids++] = id;
     }
+    closeTreeScan(treeScan);
+    return status;
+}
 
-    RecordManager* manager = table->mgmtData;
-    pinPage(&manager->bufferPool, &manager->pageHandle, id.page);
+// Let the next call start the index scan over
+static void resetIndexScan(IndexScan *indexScan) {
+    free(indexScan->rids);
+    indexScan->rids = NULL;
+    indexScan->numRids = 0;
+    indexScan->collected = false;
+}
 
-    int recordSize = getRecordSize(table->schema);
-    char* dataPointer = manager->pageHandle.data + (id.slot * recordSize);
+// The next record of an index scan that satisfies the condition, a record deleted since
+// its RID was looked up is passed over
+static RC nextIndexRecord(RM_ScanHandle *scan, Record *record) {
+    RecordManager *tableManager = scan->rel->mgmtData;
+    RecordManager *scanManager = scan->mgmtData;
+    IndexScan *indexScan = scanManager->indexScan;
+    Schema *schema = scan->rel->schema;
 
-    if (*dataPointer != '+') {
-        return RC_RM_NO_TUPLE_WITH_GIVEN_RID;
+    if (!indexScan->collected) {
+        RC status = collectIndexRids(tableManager, indexScan);
+        if (status != RC_OK) {
+            resetIndexScan(indexScan);
+            return status;
+        }
     }
 
-    record->id = id;
-    memcpy(record->data + 1, dataPointer + 1, recordSize - 1);
-
-    unpinPage(&manager->bufferPool, &manager->pageHandle);
+    while (indexScan->position < indexScan->numRids) {
+        RID id = indexScan->rids[indexScan->position++];
+        RC status = fetchRecord(tableManager, schema, id, scanRecordData(scanManager, record) + 1, scanManager->scanAttrs);
+        if (status == RC_RM_NO_TUPLE_WITH_GIVEN_RID) {
+            continue;
+        }
+        if (status != RC_OK) {
+            return status;
+        }
+        record->id = id;
+        scanManager->scanCount++;
 
-    return RC_OK;
+        bool match;
+        status = matchesScanRecord(scanManager, schema, record, &match);
+        if (status != RC_OK || match) {
+            return status;
+        }
+    }
+    return RC_RM_NO_MORE_TUPLES;
 }
 
 extern RC startScan (RM_TableData *rel, RM_ScanHandle *scan, Expr *cond)
+{
+    return startScanWithOptions(rel, scan, cond, NULL);
+}
+
+extern RC startScanWithOptions (RM_TableData *rel, RM_ScanHandle *scan, Expr *cond, const RM_ScanOptions *options)
 {
     if (rel == NULL || scan == NULL) {
         printf(rel == NULL ? "Error: [startScan]: table data pointer is null.\n" : "Error: scan pointer is null.\n");
         return RC_ERROR;
     }
+    // The workers of a parallel scan read the page file themselves, a ring would go unused
+    if (options != NULL && options->numThreads > 1 && options->ringPages > 0) {
+        return RC_INVALID_PARAMETER;
+    }
 
    // Check if the condition is provided
     if (cond) {
-        // Open the table for scanning
-        openTable(rel, "ScanTable");
-
         // Allocate memory for the scan manager
         RecordManager *scanManager = (RecordManager *)malloc(sizeof(RecordManager));
         if (!scanManager) {
@@ -465,21 +2870,67 @@ extern RC startScan (RM_TableData *rel, RM_ScanHandle *scan, Expr *cond)
         scanManager->recordID.slot = 0;  // Start from the first slot
         scanManager->scanCount = 0;      // Initialize scan count
         scanManager->condition = cond;   // Set the scan condition
+        scanManager->program = compileExpr(cond, rel->schema);
+
+        // Records only get the attributes the caller asked for
+        RC status = initScanAttrs(scanManager, rel->schema, cond, options);
+        if (status != RC_OK) {
+            freeExprProgram(scanManager->program);
+            free(scanManager);
+            return status;
+        }
+
+        // An index on an attribute the condition limits saves reading every page
+        status = initIndexScan(rel->mgmtData, scanManager, cond);
+        if (status != RC_OK) {
+            freeExprProgram(scanManager->program);
+            freeScanAttrs(scanManager);
+            free(scanManager);
+            return status;
+        }
+
+        // A large scan can read its pages through a small ring and leave the rest of the pool alone
+        if (options != NULL && options->ringPages > 0 &&
+            initAccessRing(&scanManager->scanRing, options->ringPages) != RC_OK) {
+            freeExprProgram(scanManager->program);
+            freeScanAttrs(scanManager);
+            free(scanManager->indexScan);
+            free(scanManager);
+            return RC_ERROR;
+        }
+
+        // Or be split up between worker threads, unless it uses an index
+        if (options != NULL && options->numThreads > 1 && scanManager->indexScan == NULL) {
+            status = startParallelScan(rel, scanManager, options->numThreads);
+            if (status != RC_OK) {
+                if (scanManager->scanRing.numFrames > 0) {
+                    shutdownAccessRing(&scanManager->scanRing);
+                }
+                freeExprProgram(scanManager->program);
+                freeScanAttrs(scanManager);
+                free(scanManager->indexScan);
+                free(scanManager);
+                return status;
+            }
+        }
 
         // Set the scan handle's management data
         scan->mgmtData = scanManager;
         scan->rel = rel;
 
-        // Initialize table manager
-        RecordManager *tableManager = rel->mgmtData;
-        tableManager->tuplesCount = attributeSize;
-
         return RC_OK;
     } else {
         return RC_SCAN_CONDITION_NOT_FOUND;
     }
 }
 
+// Pin a page for a scan, through its ring of frames if it has one
+static RC pinScanPage(RecordManager *tableManager, RecordManager *scanManager, int pageNum) {
+    if (scanManager->scanRing.numFrames > 0)
+        return pinPageRing(&tableManager->bufferPool, &scanManager->pageHandle, pageNum, &scanManager->scanRing);
+    return pinPage(&tableManager->bufferPool, &scanManager->pageHandle, pageNum);
+}
+
 RC next(RM_ScanHandle *scan, Record *record) {
     if (!scan || !record) {
         printf("Error: Invalid scan or record.\n");
@@ -493,60 +2944,311 @@ RC next(RM_ScanHandle *scan, Record *record) {
     if (!scanManager->condition) {
         return RC_SCAN_CONDITION_NOT_FOUND;
     }
+    if (scanManager->parallel != NULL) {
+        int numRows;
+        return popScanRows(scanManager->parallel, record, 1, &numRows);
+    }
+    if (scanManager->indexScan != NULL) {
+        RC status = nextIndexRecord(scan, record);
+        if (status == RC_RM_NO_MORE_TUPLES) {
+            resetIndexScan(scanManager->indexScan);
+            scanManager->scanCount = 0;
+        }
+        return status;
+    }
 
-    Value *result = (Value *)malloc(sizeof(Value));
-    memset(result, 0, sizeof(Value));
-    char *data;
+    RID *position = &scanManager->recordID;
+
+    // Walk the slot directories page by page, from where the last call stopped
+    while (position->page < tableManager->numPages) {
+        if (isMapPage(position->page)) {
+            position->page++;
+            continue;
+        }
+        RC status = pinScanPage(tableManager, scanManager, position->page);
+        if (status != RC_OK) {
+            return status;
+        }
+        char *page = scanManager->pageHandle.data;
+        SlotPageHeader *header = (SlotPageHeader *) page;
+
+        // Only the slots in use are looked at, a page without records is passed over
+        while (header->liveSlots > 0 &&
+               (position->slot = nextUsedSlot(page, position->slot)) < header->numSlots) {
+            int slot = position->slot;
+            int flags = slotFlags(tableManager, page, slot);
+            record->id.page = position->page;
+            record->id.slot = slot;
+            position->slot++;
+
+            // A moved record is returned where it is stored now
+            if (flags & SLOT_FORWARD) {
+                continue;
+            }
+            if (flags & SLOT_MOVED_IN) {
+                memcpy(&record->id, page + PAGE_SLOTS(page)[slot].offset, sizeof(RID));
+            }
+            loadRecord(tableManager, schema, page, slot, scanRecordData(scanManager, record) + 1, scanManager->scanAttrs);
+            scanManager->scanCount++;
+
+            bool match;
+            RC evalResult = matchesScanRecord(scanManager, schema, record, &match);
+            if (evalResult != RC_OK) {
+                unpinPage(&tableManager->bufferPool, &scanManager->pageHandle);
+                return evalResult;
+            }
+            if (match) {
+                unpinPage(&tableManager->bufferPool, &scanManager->pageHandle);
+                return RC_OK;
+            }
+        }
+
+        unpinPage(&tableManager->bufferPool, &scanManager->pageHandle);
+        position->page++;
+        position->slot = 0;
+    }
+
+    scanManager->recordID.page = 1;
+    scanManager->recordID.slot = 0;
+    scanManager->scanCount = 0;
+
+    return RC_RM_NO_MORE_TUPLES;
+}
+
+// Check the records of a page from the scan position on one by one and put those that
+// satisfy the condition into the free rows of a batch. pageDone is false if the batch
+// filled up before the end of the page.
+static RC filterPageRows(RecordManager *tableManager, RecordManager *scanManager, Schema *schema,
+                         char *page, RecordBatch *out, int maxRows, bool *pageDone) {
+    SlotPageHeader *header = (SlotPageHeader *) page;
+    RID *position = &scanManager->recordID;
+
+    *pageDone = true;
+    while (header->liveSlots > 0 &&
+           (position->slot = nextUsedSlot(page, position->slot)) < header->numSlots) {
+        if (out->numRows == maxRows) {
+            *pageDone = false;
+            break;
+        }
+        int slot = position->slot;
+        int flags = slotFlags(tableManager, page, slot);
+        Record *record = &out->records[out->numRows];
+        position->slot++;
+
+        // A moved record is returned where it is stored now
+        if (flags & SLOT_FORWARD) {
+            continue;
+        }
+        record->id.page = position->page;
+        record->id.slot = slot;
+        if (flags & SLOT_MOVED_IN) {
+            memcpy(&record->id, page + PAGE_SLOTS(page)[slot].offset, sizeof(RID));
+        }
+        loadRecord(tableManager, schema, page, slot, scanRecordData(scanManager, record) + 1, scanManager->scanAttrs);
+        scanManager->scanCount++;
+
+        bool match;
+        RC status = matchesScanRecord(scanManager, schema, record, &match);
+        if (status != RC_OK) {
+            return status;
+        }
+        if (match) {
+            out->numRows++;
+        }
+    }
+    return RC_OK;
+}
+
+// Run the compiled condition over a whole page at once and hand out the selected records.
+// The minipages of a PAX page are the columns as they are, the records of a slotted page
+// are decoded into a column per attribute first, so both give the vector kernels of the
+// condition packed values.
+static RC selectPageRows(RecordManager *tableManager, RecordManager *scanManager, Schema *schema,
+                         char *page, RecordBatch *out, int maxRows, bool *pageDone) {
+    SlotPageHeader *header = (SlotPageHeader *) page;
+    RID *position = &scanManager->recordID;
+    uint64_t selection[SLOT_MAP_WORDS];
     int recordSize = getRecordSize(schema);
-    int totalSlots = PAGE_SIZE / recordSize;
-    int scanCount = scanManager->scanCount;
-    int totalTuples = tableManager->tuplesCount;
+    int count = 0;
 
-    if (totalTuples == 0) {
-        free(result);
-        return RC_RM_NO_MORE_TUPLES;
+    *pageDone = true;
+    if (header->liveSlots == 0) {
+        return RC_OK;
+    }
+
+    if (scanManager->scanColumns == NULL) {
+        int numAttr = (schema->numAttr > 0) ? schema->numAttr : 1;
+        scanManager->scanColumns = (const char **) malloc(sizeof(char *) * numAttr);
+        scanManager->scanStrides = (int *) malloc(sizeof(int) * numAttr);
+        if (tableManager->layout == RM_LAYOUT_ROW) {
+            scanManager->stage = (char *) calloc(MAX_PAGE_SLOTS, recordSize);
+            scanManager->stageIds = (RID *) malloc(sizeof(RID) * MAX_PAGE_SLOTS);
+            scanManager->stageSlots = (int *) malloc(sizeof(int) * MAX_PAGE_SLOTS);
+        }
+    }
+    if (scanManager->scanColumns == NULL || scanManager->scanStrides == NULL ||
+        (tableManager->layout == RM_LAYOUT_ROW &&
+         (scanManager->stage == NULL || scanManager->stageIds == NULL || scanManager->stageSlots == NULL))) {
+        return RC_MEMORY_ALLOCATION_FAIL;
     }
 
-    while (scanCount <= totalTuples) {
-        if (scanCount > 0) {
-            scanManager->recordID.slot++;
-            if (scanManager->recordID.slot >= totalSlots) {
-                scanManager->recordID.slot = 0;
-                scanManager->recordID.page++;
+    if (tableManager->layout == RM_LAYOUT_PAX) {
+        for (int i = 0; i < schema->numAttr; i++) {
+            scanManager->scanColumns[i] = page + tableManager->paxOffsets[i];
+            scanManager->scanStrides[i] = tableManager->paxWidths[i];
+        }
+        count = header->numSlots;
+    } else {
+        for (int slot = position->slot; (slot = nextUsedSlot(page, slot)) < header->numSlots; slot++) {
+            int flags = slotFlags(tableManager, page, slot);
+            RID *id = &scanManager->stageIds[count];
+
+            // A moved record is returned where it is stored now
+            if (flags & SLOT_FORWARD) {
+                continue;
+            }
+            id->page = position->page;
+            id->slot = slot;
+            if (flags & SLOT_MOVED_IN) {
+                memcpy(id, page + PAGE_SLOTS(page)[slot].offset, sizeof(RID));
+            }
+            decodeRecordColumns(schema, storedRecord(page, slot), scanManager->stage, MAX_PAGE_SLOTS, count, scanManager->scanAttrs);
+            scanManager->stageSlots[count++] = slot;
+        }
+        const char *column = scanManager->stage;
+        for (int i = 0; i < schema->numAttr; i++) {
+            scanManager->scanColumns[i] = column;
+            scanManager->scanStrides[i] = attrSize(schema, i);
+            column += MAX_PAGE_SLOTS * attrSize(schema, i);
+        }
+    }
+    if (count == 0) {
+        return RC_OK;
+    }
+    runExprProgramColumns(scanManager->program, scanManager->scanColumns, scanManager->scanStrides, count, selection);
+
+    // Empty PAX slots and those returned by an earlier call are no candidates
+    if (tableManager->layout == RM_LAYOUT_PAX) {
+        for (int word = 0; word * 64 < count; word++) {
+            selection[word] &= header->slotMap[word];
+            if (word * 64 + 64 <= position->slot) {
+                selection[word] = 0;
+            } else if (word * 64 < position->slot) {
+                selection[word] &= ~(((uint64_t) 1 << (position->slot % 64)) - 1);
+            }
+        }
+    }
+    scanManager->scanCount += count;
+
+    // Hand out the selected records in slot order while the batch has room
+    for (int word = 0; word * 64 < count; word++) {
+        while (selection[word] != 0) {
+            int row = word * 64 + lowestBit(selection[word]);
+            selection[word] &= selection[word] - 1;
+
+            if (out->numRows == maxRows) {
+                position->slot = (tableManager->layout == RM_LAYOUT_PAX) ? row : scanManager->stageSlots[row];
+                *pageDone = false;
+                return RC_OK;
+            }
+            Record *record = &out->records[out->numRows++];
+            if (tableManager->layout == RM_LAYOUT_PAX) {
+                record->id.page = position->page;
+                record->id.slot = row;
+                loadRecord(tableManager, schema, page, row, record->data + 1, scanManager->returnAttrs);
+            } else {
+                record->id = scanManager->stageIds[row];
+                copyColumnAttrs(schema, scanManager->returnAttrs, record->data, scanManager->stage, MAX_PAGE_SLOTS, row);
             }
-        } else {
-            scanManager->recordID.page = 1;
-            scanManager->recordID.slot = 0;
         }
+    }
+    return RC_OK;
+}
 
-        pinPage(&tableManager->bufferPool, &scanManager->pageHandle, scanManager->recordID.page);
-        data = scanManager->pageHandle.data + (scanManager->recordID.slot * recordSize);
-        record->id.page = scanManager->recordID.page;
-        record->id.slot = scanManager->recordID.slot;
-        memcpy(record->data + 1, data + 1, recordSize - 1);
+RC nextBatch(RM_ScanHandle *scan, RecordBatch *out, int maxRows) {
+    if (!scan || !out) {
+        printf("Error: Invalid scan or batch.\n");
+        return RC_ERROR;
+    }
 
-        scanManager->scanCount++;
-        scanCount++;
+    RecordManager *tableManager = scan->rel->mgmtData;
+    RecordManager *scanManager = scan->mgmtData;
+    Schema *schema = scan->rel->schema;
 
-        RC evalResult = evalExpr(record, schema, scanManager->condition, &result);
-        if (evalResult != RC_OK) {
-                    unpinPage(&tableManager->bufferPool, &scanManager->pageHandle);
-                    free(result);
-                    return evalResult;
-                }
-        if (result->v.boolV == TRUE) {
-            unpinPage(&tableManager->bufferPool, &scanManager->pageHandle);
-            free(result);
+    if (!scanManager->condition) {
+        return RC_SCAN_CONDITION_NOT_FOUND;
+    }
+    if (maxRows > out->capacity) {
+        maxRows = out->capacity;
+    }
+    out->numRows = 0;
+    RID *position = &scanManager->recordID;
+
+    if (scanManager->parallel != NULL) {
+        while (out->numRows < maxRows) {
+            int numRows;
+            RC status = popScanRows(scanManager->parallel, out->records + out->numRows, maxRows - out->numRows, &numRows);
+            if (status != RC_OK) {
+                return (out->numRows > 0 && status == RC_RM_NO_MORE_TUPLES) ? RC_OK : status;
+            }
+            out->numRows += numRows;
+        }
+        return RC_OK;
+    }
+
+    // An index scan looks its records up one by one
+    if (scanManager->indexScan != NULL) {
+        while (out->numRows < maxRows) {
+            RC status = nextIndexRecord(scan, &out->records[out->numRows]);
+            if (status == RC_RM_NO_MORE_TUPLES) {
+                break;
+            }
+            if (status != RC_OK) {
+                return status;
+            }
+            out->numRows++;
+        }
+        if (out->numRows > 0) {
             return RC_OK;
         }
+        resetIndexScan(scanManager->indexScan);
+        scanManager->scanCount = 0;
+        return RC_RM_NO_MORE_TUPLES;
+    }
 
+    // Each page is pinned once per call and the condition runs over all of its records at
+    // once, compiled over columns or with evalExpr over the loaded rows
+    while (out->numRows < maxRows && position->page < tableManager->numPages) {
+        if (isMapPage(position->page)) {
+            position->page++;
+            continue;
+        }
+        RC status = pinScanPage(tableManager, scanManager, position->page);
+        if (status != RC_OK) {
+            return status;
+        }
+        bool pageDone;
+        if (scanManager->program != NULL) {
+            status = selectPageRows(tableManager, scanManager, schema, scanManager->pageHandle.data, out, maxRows, &pageDone);
+        } else {
+            status = filterPageRows(tableManager, scanManager, schema, scanManager->pageHandle.data, out, maxRows, &pageDone);
+        }
         unpinPage(&tableManager->bufferPool, &scanManager->pageHandle);
+        if (status != RC_OK) {
+            return status;
+        }
+        if (pageDone) {
+            position->page++;
+            position->slot = 0;
+        }
     }
 
+    if (out->numRows > 0) {
+        return RC_OK;
+    }
     scanManager->recordID.page = 1;
     scanManager->recordID.slot = 0;
     scanManager->scanCount = 0;
-    free(result);
 
     return RC_RM_NO_MORE_TUPLES;
 }
@@ -562,17 +3264,33 @@ extern RC closeScan (RM_ScanHandle *scan)
     RecordManager *scanManager = scan->mgmtData;
     RecordManager *recordManager = scan->rel->mgmtData;
 
-    // Check if there are any scanned records
+    // Check if there are any scanned records. next() unpins every page it pinned
+    // before it returns, so there is no page left to unpin here.
     if (scanManager->scanCount > 0) {
-        // Unpin the page from the buffer pool
-        unpinPage(&recordManager->bufferPool, &scanManager->pageHandle);
-
         // Reset scan manager values
         scanManager->recordID.page = 1;
         scanManager->recordID.slot = 0;
         scanManager->scanCount = 0;
     }
 
+    if (scanManager->scanRing.numFrames > 0) {
+        shutdownAccessRing(&scanManager->scanRing);
+    }
+    if (scanManager->parallel != NULL) {
+        stopParallelScan(scanManager->parallel, scanManager->parallel->numThreads);
+    }
+    freeExprProgram(scanManager->program);
+    free(scanManager->scanColumns);
+    free(scanManager->scanStrides);
+    free(scanManager->stage);
+    free(scanManager->stageIds);
+    free(scanManager->stageSlots);
+    freeScanAttrs(scanManager);
+    if (scanManager->indexScan != NULL) {
+        resetIndexScan(scanManager->indexScan);
+        free(scanManager->indexScan);
+    }
+
     // Free the memory allocated for the scan manager
     free(scan->mgmtData);
     scan->mgmtData = NULL;
@@ -580,6 +3298,24 @@ extern RC closeScan (RM_ScanHandle *scan)
     return RC_OK;
 }
 
+RC getScanIndexRange (RM_ScanHandle *scan, int *attrNum, int *low, int *high)
+{
+    if (scan == NULL || scan->mgmtData == NULL || attrNum == NULL || low == NULL || high == NULL) {
+        return RC_ERROR;
+    }
+
+    IndexScan *indexScan = ((RecordManager *) scan->mgmtData)->indexScan;
+    if (indexScan == NULL) {
+        *attrNum = -1;
+        return RC_OK;
+    }
+    *attrNum = indexScan->attrNum;
+    // An empty range has its low key above its high key
+    *low = indexScan->empty ? 1 : indexScan->low;
+    *high = indexScan->empty ? 0 : indexScan->high;
+    return RC_OK;
+}
+
 extern int getRecordSize (Schema *schema)
 {
     if (schema == NULL) {
@@ -725,6 +3461,49 @@ extern RC freeRecord (Record *record)
 	return RC_OK;
 }
 
+RC createRecordBatch(RecordBatch **batch, Schema *schema, int capacity) {
+    if (!batch || !schema || capacity <= 0) {
+        printf("Error: Invalid batch, schema or capacity.\n");
+        return RC_ERROR;
+    }
+
+    int recordSize = getRecordSize(schema);
+    RecordBatch *newBatch = (RecordBatch *) malloc(sizeof(RecordBatch));
+    Record *records = (Record *) malloc(sizeof(Record) * capacity);
+    char *data = (char *) calloc(capacity, recordSize);
+    if (newBatch == NULL || records == NULL || data == NULL) {
+        free(newBatch);
+        free(records);
+        free(data);
+        return RC_MEMORY_ALLOCATION_FAIL;
+    }
+
+    // The rows share one block of record data, each starts with the tombstone marker
+    for (int i = 0; i < capacity; i++) {
+        records[i].id.page = records[i].id.slot = -1;
+        records[i].data = data + i * recordSize;
+        records[i].data[0] = '-';
+    }
+    newBatch->records = records;
+    newBatch->numRows = 0;
+    newBatch->capacity = capacity;
+    newBatch->block = data;
+    *batch = newBatch;
+
+    return RC_OK;
+}
+
+RC freeRecordBatch(RecordBatch *batch) {
+    if (batch == NULL) {
+        printf("Error: [freeRecordBatch]: batch pointer is null.\n");
+        return RC_ERROR;
+    }
+    free(batch->block);
+    free(batch->records);
+    free(batch);
+    return RC_OK;
+}
+
 extern RC getAttr (Record *record, Schema *schema, int attrNum, Value **value)
 {
     if (record == NULL || schema == NULL) {
@@ -12,32 +12,100 @@ typedef struct RM_ScanHandle
 	void *mgmtData;
 } RM_ScanHandle;
 
-typedef struct ScanMgmtInfo {
-  int page;
-  int slot;
-  int totalPages;
-  int maxSlots;
-  Expr *condition;
-} ScanMgmtInfo;
+// Optional behaviour of a scan, see startScanWithOptions
+typedef struct RM_ScanOptions
+{
+	int ringPages; // read the table through a ring of this many frames of the
+	               // buffer pool instead of caching every page, 0 for no ring
+	int numThreads; // split the table between this many worker threads, records
+	                // come in no particular order, 0 or 1 to scan on the caller.
+	                // Workers read the page file directly, so a ring is refused
+	                // with RC_INVALID_PARAMETER.
+	int *attrs;     // attributes next() and nextBatch() fill in, the others are left
+	int numAttrs;   // as they are in the record, NULL to fill in all of them
+} RM_ScanOptions;
+
+// How the data pages of a table store records
+typedef enum RM_PageLayout {
+	RM_LAYOUT_ROW = 0, // slotted pages, one record after the other
+	RM_LAYOUT_PAX = 1  // a minipage per attribute, the values of all slots of a page
+	                   // next to each other
+} RM_PageLayout;
+
+// Optional settings of the record manager, see initRecordManagerWithOptions
+typedef struct RM_ManagerOptions
+{
+	struct BM_SharedPool *sharedPool; // pool to cache all the tables in, NULL for a pool per table
+	char *catalogFile;                // page file of the catalog of tables, NULL for
+	                                  // CATALOG_FILE_NAME in the working directory
+} RM_ManagerOptions;
+
+// Optional settings of a new table, see createTableWithOptions
+typedef struct RM_TableOptions
+{
+	RM_PageLayout layout;
+} RM_TableOptions;
+
+// Rows returned by nextBatch, created with createRecordBatch
+typedef struct RecordBatch
+{
+	Record *records; // numRows records, getAttr works on each of them
+	int numRows;
+	int capacity;    // rows the batch has room for
+	char *block;     // data of all rows
+} RecordBatch;
+
+// A record read where it is stored, see getRecordView. The page holding it stays
+// pinned until releaseRecordView, the other fields are for getViewAttr.
+typedef struct RecordView
+{
+	RID id;
+	RM_TableData *rel;
+	char *page;
+	int pageNum;
+	int slot;
+} RecordView;
 
 // table and manager
 extern RC initRecordManager (void *mgmtData);
+// Start the record manager with the given options, NULL options are those of
+// initRecordManager(NULL)
+extern RC initRecordManagerWithOptions (const RM_ManagerOptions *options);
 extern RC shutdownRecordManager ();
 extern RC createTable (char *name, Schema *schema);
+// Create a table with the given options, NULL options are those of createTable
+extern RC createTableWithOptions (char *name, Schema *schema, const RM_TableOptions *options);
 extern RC openTable (RM_TableData *rel, char *name);
 extern RC closeTable (RM_TableData *rel);
 extern RC deleteTable (char *name);
 extern int getNumTuples (RM_TableData *rel);
 
+// B+ tree indexes on int attributes of a table. Inserts, updates and deletes keep them
+// current and scans use one when the condition limits its attribute to a range of keys.
+// Several records may have the same key.
+extern RC createIndex (RM_TableData *rel, int attrNum);
+extern RC dropIndex (RM_TableData *rel, int attrNum);
+
 // handling records in a table
 extern RC insertRecord (RM_TableData *rel, Record *record);
+// Insert several records, filling one page at a time, and set their ids. After an
+// error the records before the one that failed stay inserted, it and those after it
+// get the RID -1, -1.
+extern RC insertRecords (RM_TableData *rel, Record **records, int numRecords);
 extern RC deleteRecord (RM_TableData *rel, RID id);
 extern RC updateRecord (RM_TableData *rel, Record *record);
 extern RC getRecord (RM_TableData *rel, RID id, Record *record);
+// Read single attributes of a record without copying all of it
+extern RC getRecordView (RM_TableData *rel, RID id, RecordView *view);
+extern RC getViewAttr (RecordView *view, Schema *schema, int attrNum, Value **value);
+extern RC releaseRecordView (RecordView *view);
 
 // scans
 extern RC startScan (RM_TableData *rel, RM_ScanHandle *scan, Expr *cond);
+extern RC startScanWithOptions (RM_TableData *rel, RM_ScanHandle *scan, Expr *cond, const RM_ScanOptions *options);
 extern RC next (RM_ScanHandle *scan, Record *record);
+// Return up to maxRows records that satisfy the condition, fewer only at the end of the table
+extern RC nextBatch (RM_ScanHandle *scan, RecordBatch *out, int maxRows);
 extern RC closeScan (RM_ScanHandle *scan);
 
 // dealing with schemas
@@ -50,5 +118,12 @@ extern RC createRecord (Record **record, Schema *schema);
 extern RC freeRecord (Record *record);
 extern RC getAttr (Record *record, Schema *schema, int attrNum, Value **value);
 extern RC setAttr (Record *record, Schema *schema, int attrNum, Value *value);
+extern RC createRecordBatch (RecordBatch **batch, Schema *schema, int capacity);
+extern RC freeRecordBatch (RecordBatch *batch);
+
+// debug and test functions
+// The indexed attribute a scan takes its records from and the range of keys it looks up,
+// attrNum is -1 for a scan that reads the pages of the table
+extern RC getScanIndexRange (RM_ScanHandle *scan, int *attrNum, int *low, int *high);
 
 #endif // RECORD_MGR_H
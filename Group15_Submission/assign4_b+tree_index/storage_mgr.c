@@ -6,9 +6,16 @@
 #include<string.h>
 #include<math.h>
 #include<errno.h>
+#include<fcntl.h>
+#include<limits.h>
+#include<sys/uio.h>
 
 #include "storage_mgr.h"
 
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
 FILE *pageFile;
 
 extern void initStorageManager (void) {
@@ -175,12 +182,7 @@ RC writeBlock(int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage) {
         return RC_WRITE_FAILED;
     }
 
-    // Check if page number is within bounds
-    if (pageNum > fHandle->totalNumPages) {
-        return RC_WRITE_FAILED;
-    }
-
-    // Open file for reading and writing
+    // Open file for reading and writing, writing past the end extends the file
     FILE *pageFile = fopen(fHandle->fileName, "r+");
     if (pageFile == NULL) {
         return RC_FILE_NOT_FOUND;
@@ -221,23 +223,21 @@ RC writeCurrentBlock(SM_FileHandle *fHandle, SM_PageHandle memPage) {
         return RC_FILE_NOT_FOUND;
     }
 
-    // Append an empty block to make space for new content
-    RC appendResult = appendEmptyBlock(fHandle);
-    if (appendResult != RC_OK) {
-        fclose(pageFile);
-        return appendResult;
-    }
-
     // Set file pointer to current page position
     fseek(pageFile, fHandle->curPagePos, SEEK_SET);
 
-    // Write memPage contents to file
-    size_t bytesWritten = fwrite(memPage, sizeof(char), strlen(memPage), pageFile);
-    if (bytesWritten != strlen(memPage)) {
+    // Write the whole page, pages hold binary data and may contain zero bytes
+    size_t bytesWritten = fwrite(memPage, sizeof(char), PAGE_SIZE, pageFile);
+    if (bytesWritten != PAGE_SIZE) {
         fclose(pageFile);
         return RC_WRITE_FAILED;
     }
 
+    // Writing past the end of the file extends it
+    if (fHandle->curPagePos / PAGE_SIZE >= fHandle->totalNumPages) {
+        fHandle->totalNumPages = fHandle->curPagePos / PAGE_SIZE + 1;
+    }
+
     // Update current page position
     fHandle->curPagePos = ftell(pageFile);
 
@@ -296,6 +296,174 @@ RC ensureCapacity(int numberOfPages, SM_FileHandle *fHandle) {
         return RC_OK;
 }
 
+// Write iovcnt page buffers starting at offset, retrying on short writes.
+static RC pwriteFully(int fd, struct iovec *iov, int iovcnt, off_t offset) {
+    while (iovcnt > 0) {
+        ssize_t written = pwritev(fd, iov, iovcnt, offset);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return RC_WRITE_FAILED;
+        }
+        offset += written;
+
+        // Skip the buffers that were fully written and trim a partially written one
+        while (iovcnt > 0 && (size_t)written >= iov->iov_len) {
+            written -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = (char *)iov->iov_base + written;
+            iov->iov_len -= written;
+        }
+    }
+    return RC_OK;
+}
+
+RC writeBlocks(int numBlocks, const int *pageNums, SM_FileHandle *fHandle, SM_PageHandle *memPages) {
+    // Validate input parameters
+    if (fHandle == NULL || pageNums == NULL || memPages == NULL || numBlocks < 0) {
+        return RC_WRITE_FAILED;
+    }
+    if (numBlocks == 0) {
+        return RC_OK;
+    }
+
+    // Open the file once for the whole batch
+    int fd = open(fHandle->fileName, O_WRONLY);
+    if (fd < 0) {
+        return RC_FILE_NOT_FOUND;
+    }
+
+    struct iovec *iov = (struct iovec *)malloc(sizeof(struct iovec) * (numBlocks < IOV_MAX ? numBlocks : IOV_MAX));
+    if (iov == NULL) {
+        close(fd);
+        return RC_ERROR;
+    }
+
+    RC result = RC_OK;
+    int i = 0;
+    while (i < numBlocks && result == RC_OK) {
+        if (pageNums[i] < 0 || memPages[i] == NULL || (i > 0 && pageNums[i] <= pageNums[i - 1])) {
+            result = RC_WRITE_FAILED;
+            break;
+        }
+
+        // Coalesce the run of adjacent page numbers starting at i into one vectored write
+        int runLength = 0;
+        do {
+            iov[runLength].iov_base = memPages[i + runLength];
+            iov[runLength].iov_len = PAGE_SIZE;
+            runLength++;
+        } while (i + runLength < numBlocks && runLength < IOV_MAX &&
+                 pageNums[i + runLength] == pageNums[i + runLength - 1] + 1 &&
+                 memPages[i + runLength] != NULL);
+
+        result = pwriteFully(fd, iov, runLength, (off_t)pageNums[i] * PAGE_SIZE);
+        i += runLength;
+
+        // Writing past the end of the file extends it
+        if (result == RC_OK && pageNums[i - 1] >= fHandle->totalNumPages) {
+            fHandle->totalNumPages = pageNums[i - 1] + 1;
+        }
+    }
+    free(iov);
+
+    // One durability barrier for the whole batch
+    if (result == RC_OK && fdatasync(fd) != 0) {
+        result = RC_WRITE_FAILED;
+    }
+    if (close(fd) != 0 && result == RC_OK) {
+        result = RC_WRITE_FAILED;
+    }
+    if (result == RC_OK) {
+        fHandle->curPagePos = (pageNums[numBlocks - 1] + 1) * PAGE_SIZE;
+    }
+    return result;
+}
+
+static RC preadFully(int fd, struct iovec *iov, int iovcnt, off_t offset) {
+    while (iovcnt > 0) {
+        ssize_t bytesRead = preadv(fd, iov, iovcnt, offset);
+        if (bytesRead < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return RC_READING_FAILED;
+        }
+        // End of file before the last page of the run
+        if (bytesRead == 0) {
+            return RC_READ_NON_EXISTING_PAGE;
+        }
+        offset += bytesRead;
+
+        // Skip the buffers that were fully read and trim a partially read one
+        while (iovcnt > 0 && (size_t)bytesRead >= iov->iov_len) {
+            bytesRead -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = (char *)iov->iov_base + bytesRead;
+            iov->iov_len -= bytesRead;
+        }
+    }
+    return RC_OK;
+}
+
+RC readBlocks(int numBlocks, const int *pageNums, SM_FileHandle *fHandle, SM_PageHandle *memPages) {
+    // Validate input parameters
+    if (fHandle == NULL || pageNums == NULL || memPages == NULL || numBlocks < 0) {
+        return RC_READING_FAILED;
+    }
+    if (numBlocks == 0) {
+        return RC_OK;
+    }
+
+    // Open the file once for the whole batch
+    int fd = open(fHandle->fileName, O_RDONLY);
+    if (fd < 0) {
+        return RC_FILE_NOT_FOUND;
+    }
+
+    struct iovec *iov = (struct iovec *)malloc(sizeof(struct iovec) * (numBlocks < IOV_MAX ? numBlocks : IOV_MAX));
+    if (iov == NULL) {
+        close(fd);
+        return RC_ERROR;
+    }
+
+    RC result = RC_OK;
+    int i = 0;
+    while (i < numBlocks && result == RC_OK) {
+        if (pageNums[i] < 0 || memPages[i] == NULL || (i > 0 && pageNums[i] <= pageNums[i - 1])) {
+            result = RC_READING_FAILED;
+            break;
+        }
+
+        // Coalesce the run of adjacent page numbers starting at i into one vectored read
+        int runLength = 0;
+        do {
+            iov[runLength].iov_base = memPages[i + runLength];
+            iov[runLength].iov_len = PAGE_SIZE;
+            runLength++;
+        } while (i + runLength < numBlocks && runLength < IOV_MAX &&
+                 pageNums[i + runLength] == pageNums[i + runLength - 1] + 1 &&
+                 memPages[i + runLength] != NULL);
+
+        result = preadFully(fd, iov, runLength, (off_t)pageNums[i] * PAGE_SIZE);
+        i += runLength;
+    }
+    free(iov);
+    close(fd);
+
+    if (result == RC_OK) {
+        fHandle->curPagePos = (pageNums[numBlocks - 1] + 1) * PAGE_SIZE;
+    }
+    return result;
+}
+
     void freePh(SM_PageHandle fHandle) {
         if (fHandle != NULL) {
             free(fHandle);
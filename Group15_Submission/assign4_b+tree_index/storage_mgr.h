@@ -41,4 +41,10 @@ extern RC writeCurrentBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
 extern RC appendEmptyBlock (SM_FileHandle *fHandle);
 extern RC ensureCapacity (int numberOfPages, SM_FileHandle *fHandle);
 
+/* batched reads and writes: pageNums must be sorted ascending, runs of
+   adjacent pages are coalesced into one vectored read or write and a batch
+   of writes syncs the file once */
+extern RC writeBlocks (int numBlocks, const int *pageNums, SM_FileHandle *fHandle, SM_PageHandle *memPages);
+extern RC readBlocks (int numBlocks, const int *pageNums, SM_FileHandle *fHandle, SM_PageHandle *memPages);
+
 #endif
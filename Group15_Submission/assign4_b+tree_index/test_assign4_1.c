@@ -15,6 +15,7 @@
 static void testInsertAndFind (void);
 static void testDelete (void);
 static void testIndexScan (void);
+static void testDuplicateKeys (void);
 
 // helper methods
 static Value **createValues (char **stringVals, int size);
@@ -33,6 +34,7 @@ main (void)
   testInsertAndFind();
   testDelete();
   testIndexScan();
+  testDuplicateKeys();
 
   return 0;
 }
@@ -265,6 +267,101 @@ testIndexScan (void)
   TEST_DONE();
 }
 
+// ************************************************************ 
+void
+testDuplicateKeys (void)
+{
+  int numInserts = 300, numKeys = 7;
+  int i, k, rc, count, testint;
+  int *permute;
+  bool *seen = (bool *) malloc(numInserts * sizeof(bool));
+  bool *deleted = (bool *) calloc(numInserts, sizeof(bool));
+  BTreeHandle *tree = NULL;
+  BT_ScanHandle *sc = NULL;
+  Value key;
+  RID rid;
+
+  testName = "entries sharing a key";
+  key.dt = DT_INT;
+
+  TEST_CHECK(initIndexManager(NULL));
+  TEST_CHECK(createBtree("testidx", DT_INT, 2));
+  TEST_CHECK(openBtree(&tree, "testidx"));
+
+  // entry i has key i % numKeys and RID (i / 10 + 1, i % 10)
+  permute = createPermutation(numInserts);
+  for(i = 0; i < numInserts; i++)
+    {
+      key.v.intV = permute[i] % numKeys;
+      rid.page = permute[i] / 10 + 1;
+      rid.slot = permute[i] % 10;
+      TEST_CHECK(insertEntry(tree, &key, rid));
+    }
+  TEST_CHECK(getNumEntries(tree, &testint));
+  ASSERT_EQUALS_INT(numInserts, testint, "number of entries in btree");
+
+  // a key already in the tree is still refused by insertKey
+  key.v.intV = 3;
+  rid.page = rid.slot = 0;
+  ASSERT_EQUALS_INT(RC_IM_KEY_ALREADY_EXISTS, insertKey(tree, &key, rid), "insertKey refuses a key it has");
+  TEST_CHECK(findKey(tree, &key, &rid));
+  ASSERT_EQUALS_INT(3, ((rid.page - 1) * 10 + rid.slot) % numKeys, "findKey returns an entry of the key");
+
+  // delete every third entry, once
+  for(i = 0; i < numInserts; i += 3)
+    {
+      key.v.intV = i % numKeys;
+      rid.page = i / 10 + 1;
+      rid.slot = i % 10;
+      TEST_CHECK(deleteEntry(tree, &key, rid));
+      ASSERT_EQUALS_INT(RC_IM_KEY_NOT_FOUND, deleteEntry(tree, &key, rid), "entry deleted once");
+      deleted[i] = TRUE;
+    }
+
+  // every key returns its entries that are left, the full scan goes in key order
+  for(k = 0; k < numKeys; k++)
+    {
+      memset(seen, 0, numInserts * sizeof(bool));
+      key.v.intV = k;
+      TEST_CHECK(openTreeRangeScan(tree, &key, &key, &sc));
+      count = 0;
+      while((rc = nextEntry(sc, &rid)) == RC_OK)
+	{
+	  i = (rid.page - 1) * 10 + rid.slot;
+	  ASSERT_TRUE(i % numKeys == k && !deleted[i] && !seen[i], "range scan returns an entry of the key once");
+	  seen[i] = TRUE;
+	  count++;
+	}
+      ASSERT_EQUALS_INT(RC_IM_NO_MORE_ENTRIES, rc, "range scan ends after the key");
+      TEST_CHECK(closeTreeScan(sc));
+      for(i = k; i < numInserts; i += numKeys)
+	ASSERT_TRUE(seen[i] || deleted[i], "range scan returns every entry of the key");
+    }
+
+  TEST_CHECK(openTreeScan(tree, &sc));
+  count = 0;
+  k = 0;
+  while((rc = nextEntry(sc, &rid)) == RC_OK)
+    {
+      i = (rid.page - 1) * 10 + rid.slot;
+      ASSERT_TRUE(i % numKeys >= k, "entries in key order");
+      k = i % numKeys;
+      count++;
+    }
+  TEST_CHECK(closeTreeScan(sc));
+  ASSERT_EQUALS_INT(numInserts - (numInserts + 2) / 3, count, "scan returns the entries left");
+
+  // cleanup
+  TEST_CHECK(closeBtree(tree));
+  TEST_CHECK(deleteBtree("testidx"));
+  TEST_CHECK(shutdownIndexManager());
+  free(permute);
+  free(seen);
+  free(deleted);
+
+  TEST_DONE();
+}
+
 // ************************************************************ 
 int *
 createPermutation (int size)
@@ -0,0 +1,975 @@
+#include "storage_mgr.h"
+#include "buffer_mgr_stat.h"
+#include "buffer_mgr.h"
+#include "policy_sim.h"
+#include "dberror.h"
+#include "test_helper.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// var to store the current test's name
+char *testName;
+
+// test and helper methods
+static void testPoolStats (void);
+static void testFlushPool (void);
+static void testFailedWriteBack (void);
+static void testSharedPool (void);
+static void testWarmRestart (void);
+static void testTrace (void);
+static void testPolicySimulator (void);
+static void testAdaptivePolicy (void);
+static void testAccessRing (void);
+static void testResizePool (void);
+static void testCompressedTier (void);
+static void testQuotasAndPriorities (void);
+static void testPinPages (void);
+static void testPinTracking (void);
+static void testPinSites (void);
+static void pinAndUnpin (BM_BufferPool *bm, BM_PageHandle *h, int pageNum);
+
+// main method
+int
+main (void)
+{
+  initStorageManager();
+  testName = "";
+
+  testPoolStats();
+  testFlushPool();
+  testFailedWriteBack();
+  testSharedPool();
+  testWarmRestart();
+  testTrace();
+  testPolicySimulator();
+  testAdaptivePolicy();
+  testAccessRing();
+  testResizePool();
+  testCompressedTier();
+  testQuotasAndPriorities();
+  testPinPages();
+  testPinTracking();
+  testPinSites();
+
+  return 0;
+}
+
+// ************************************************************
+void
+testPoolStats (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h1 = MAKE_PAGE_HANDLE();
+  BM_PageHandle *h2 = MAKE_PAGE_HANDLE();
+  BM_PoolStats stats;
+  testName = "Buffer pool statistics";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_LRU, NULL));
+
+  // 4 misses, 1 hit and one LRU eviction (page 1)
+  pinAndUnpin(bm, h1, 0);
+  pinAndUnpin(bm, h1, 1);
+  pinAndUnpin(bm, h1, 2);
+  pinAndUnpin(bm, h1, 0);
+  pinAndUnpin(bm, h1, 3);
+
+  TEST_CHECK(getPoolStats(bm, &stats));
+  ASSERT_EQUALS_INT(1, (int) stats.hits, "hits");
+  ASSERT_EQUALS_INT(4, (int) stats.misses, "misses");
+  ASSERT_EQUALS_INT(1, (int) stats.evictions[RS_LRU], "LRU evictions");
+  ASSERT_EQUALS_INT(0, (int) stats.evictions[RS_FIFO], "FIFO evictions");
+  ASSERT_EQUALS_INT(1, stats.pinnedHighWater, "one page pinned at a time");
+  ASSERT_EQUALS_INT(0, stats.pinnedFrames, "nothing pinned");
+  ASSERT_EQUALS_INT(5, (int) stats.completedPins, "every pin was released");
+  ASSERT_TRUE(stats.hitRatio > 0.19 && stats.hitRatio < 0.21, "hit ratio is 1/5");
+
+  // pin two pages at once and write one of them back
+  CHECK(pinPage(bm, h1, 0));
+  CHECK(pinPage(bm, h2, 2));
+  CHECK(markDirty(bm, h2));
+  TEST_CHECK(getPoolStats(bm, &stats));
+  ASSERT_EQUALS_INT(2, stats.pinnedFrames, "two pages pinned");
+  ASSERT_EQUALS_INT(2, stats.pinnedHighWater, "high-water mark follows");
+  CHECK(unpinPage(bm, h1));
+  CHECK(unpinPage(bm, h2));
+  CHECK(forceFlushPool(bm));
+
+  TEST_CHECK(getPoolStats(bm, &stats));
+  ASSERT_EQUALS_INT(1, (int) stats.dirtyWriteBacks, "one dirty page written back");
+  ASSERT_EQUALS_INT(3, (int) stats.hits, "hits");
+
+  // a reset keeps nothing but the current pins
+  TEST_CHECK(resetPoolStats(bm));
+  TEST_CHECK(getPoolStats(bm, &stats));
+  ASSERT_EQUALS_INT(0, (int) (stats.hits + stats.misses), "counters reset");
+  ASSERT_EQUALS_INT(0, stats.pinnedHighWater, "high-water mark reset");
+
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(h1);
+  free(h2);
+  free(bm);
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testFlushPool (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  char expected[64];
+  int pages[] = { 5, 1, 2, 7, 3 };
+  int i;
+  testName = "Flushing unsorted dirty pages";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  CHECK(initBufferPool(bm, "testbuffer.bin", 5, RS_FIFO, NULL));
+
+  // dirty the pages out of order, the flush writes them sorted
+  for (i = 0; i < 5; i++)
+    {
+      CHECK(pinPage(bm, h, pages[i]));
+      memset(h->data, 0, PAGE_SIZE);
+      sprintf(h->data, "%s-%i", "Page", h->pageNum);
+      CHECK(markDirty(bm, h));
+      CHECK(unpinPage(bm, h));
+    }
+  CHECK(forceFlushPool(bm));
+  ASSERT_EQUALS_INT(5, getNumWriteIO(bm), "all dirty pages written");
+
+  // flushing a clean pool does not write anything
+  CHECK(forceFlushPool(bm));
+  ASSERT_EQUALS_INT(5, getNumWriteIO(bm), "nothing left to write");
+  CHECK(shutdownBufferPool(bm));
+
+  // read the pages back through a fresh pool
+  CHECK(initBufferPool(bm, "testbuffer.bin", 2, RS_FIFO, NULL));
+  for (i = 0; i < 5; i++)
+    {
+      CHECK(pinPage(bm, h, pages[i]));
+      sprintf(expected, "%s-%i", "Page", pages[i]);
+      ASSERT_EQUALS_STRING(expected, h->data, "reading back flushed page");
+      CHECK(unpinPage(bm, h));
+    }
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(h);
+  free(bm);
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testFailedWriteBack (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PoolStats stats;
+  PageNumber *frameContents;
+  bool *dirtyFlags;
+  testName = "Write-back failure on eviction";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  CHECK(initBufferPool(bm, "testbuffer.bin", 1, RS_FIFO, NULL));
+  CHECK(pinPage(bm, h, 0));
+  sprintf(h->data, "%s-%i", "Page", h->pageNum);
+  CHECK(markDirty(bm, h));
+  CHECK(unpinPage(bm, h));
+
+  // the page file is gone, so the dirty page can not make room for another one
+  CHECK(destroyPageFile("testbuffer.bin"));
+  ASSERT_ERROR(pinPage(bm, h, 1), "victim could not be written back");
+  frameContents = getFrameContents(bm);
+  dirtyFlags = getDirtyFlags(bm);
+  ASSERT_EQUALS_INT(0, frameContents[0], "dirty page kept in its frame");
+  ASSERT_TRUE(dirtyFlags[0], "and still dirty");
+  free(frameContents);
+  free(dirtyFlags);
+  TEST_CHECK(getPoolStats(bm, &stats));
+  ASSERT_EQUALS_INT(0, (int) stats.dirtyWriteBacks, "no write-back counted");
+  ASSERT_EQUALS_INT(0, getNumWriteIO(bm), "no write counted");
+  ASSERT_EQUALS_INT(0, stats.pinnedFrames, "the new page is not pinned");
+
+  // forcing the page reports the failure the same way
+  h->pageNum = 0;
+  ASSERT_ERROR(forcePage(bm, h), "forced page could not be written");
+  dirtyFlags = getDirtyFlags(bm);
+  ASSERT_TRUE(dirtyFlags[0], "forced page still dirty");
+  free(dirtyFlags);
+  ASSERT_EQUALS_INT(0, getNumWriteIO(bm), "no write counted");
+
+  // once the file is back the page reaches it
+  CHECK(createPageFile("testbuffer.bin"));
+  CHECK(shutdownBufferPool(bm));
+  CHECK(initBufferPool(bm, "testbuffer.bin", 1, RS_FIFO, NULL));
+  CHECK(pinPage(bm, h, 0));
+  ASSERT_EQUALS_STRING("Page-0", h->data, "page written back later");
+  CHECK(unpinPage(bm, h));
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(h);
+  free(bm);
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testSharedPool (void)
+{
+  BM_SharedPool sp;
+  BM_BufferPool *bmA = MAKE_POOL();
+  BM_BufferPool *bmB = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PoolStats stats;
+  PageNumber *frameContents;
+  int i, pagesOfA = 0, pagesOfB = 0;
+  testName = "Shared buffer pool";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  CHECK(createPageFile("testbuffer2.bin"));
+  CHECK(initSharedPool(&sp, 4, RS_LRU, NULL));
+  CHECK(attachBufferPool(bmA, &sp, "testbuffer.bin", 2));
+  CHECK(attachBufferPool(bmB, &sp, "testbuffer2.bin", 0));
+
+  // file A never takes more than its budget of 2 frames
+  for (i = 0; i < 4; i++)
+    pinAndUnpin(bmA, h, i);
+  ASSERT_EQUALS_INT(2, getPoolFramesUsed(bmA), "file A stays within its budget");
+  TEST_CHECK(getPoolStats(bmA, &stats));
+  ASSERT_EQUALS_INT(2, (int) stats.evictions[RS_LRU], "file A replaced its own pages");
+
+  // file B gets the rest of the pool, the same page number is a different page
+  for (i = 0; i < 2; i++)
+    {
+      CHECK(pinPage(bmB, h, i));
+      sprintf(h->data, "%s-%i", "File2-Page", h->pageNum);
+      CHECK(markDirty(bmB, h));
+      CHECK(unpinPage(bmB, h));
+    }
+  ASSERT_EQUALS_INT(2, getPoolFramesUsed(bmB), "file B uses the free frames");
+  TEST_CHECK(getPoolStats(bmB, &stats));
+  ASSERT_EQUALS_INT(2, (int) stats.misses, "page 1 of file B is not page 1 of file A");
+  ASSERT_EQUALS_INT(0, (int) stats.evictions[RS_LRU], "no eviction needed");
+
+  // each file only sees its own pages
+  frameContents = getFrameContents(bmA);
+  for (i = 0; i < 4; i++)
+    pagesOfA += (frameContents[i] != NO_PAGE);
+  free(frameContents);
+  frameContents = getFrameContents(bmB);
+  for (i = 0; i < 4; i++)
+    pagesOfB += (frameContents[i] != NO_PAGE);
+  free(frameContents);
+  ASSERT_EQUALS_INT(2, pagesOfA, "file A sees two pages");
+  ASSERT_EQUALS_INT(2, pagesOfB, "file B sees two pages");
+
+  // the pool can not go away while files are attached
+  ASSERT_EQUALS_INT(RC_BUFFER_POOL_IN_USE, shutdownSharedPool(&sp), "files still attached");
+  CHECK(shutdownBufferPool(bmB));
+  CHECK(shutdownBufferPool(bmA));
+  CHECK(shutdownSharedPool(&sp));
+
+  // detaching file B wrote its pages to its own file
+  CHECK(initBufferPool(bmB, "testbuffer2.bin", 2, RS_FIFO, NULL));
+  CHECK(pinPage(bmB, h, 1));
+  ASSERT_EQUALS_STRING("File2-Page-1", h->data, "page written to the right file");
+  CHECK(unpinPage(bmB, h));
+  CHECK(shutdownBufferPool(bmB));
+
+  CHECK(destroyPageFile("testbuffer.bin"));
+  CHECK(destroyPageFile("testbuffer2.bin"));
+
+  free(h);
+  free(bmA);
+  free(bmB);
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testWarmRestart (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PoolOptions options = { .warmRestart = true };
+  BM_PoolStats stats;
+  char expected[64];
+  int i;
+  testName = "Warm restart of a buffer pool";
+
+  // write 6 pages, then make page 4 the hottest and page 2 the runner-up
+  CHECK(createPageFile("testbuffer.bin"));
+  CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 6, RS_LRU, NULL, &options));
+  for (i = 0; i < 6; i++)
+    {
+      CHECK(pinPage(bm, h, i));
+      sprintf(h->data, "%s-%i", "Page", h->pageNum);
+      CHECK(markDirty(bm, h));
+      CHECK(unpinPage(bm, h));
+    }
+  for (i = 0; i < 3; i++)
+    pinAndUnpin(bm, h, 4);
+  pinAndUnpin(bm, h, 2);
+  CHECK(shutdownBufferPool(bm));
+
+  // a smaller pool comes back with the two hottest pages
+  CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 2, RS_LRU, NULL, &options));
+  ASSERT_EQUALS_INT(2, getNumReadIO(bm), "hottest pages read on init");
+  pinAndUnpin(bm, h, 2);
+  CHECK(pinPage(bm, h, 4));
+  sprintf(expected, "%s-%i", "Page", 4);
+  ASSERT_EQUALS_STRING(expected, h->data, "prefetched page content");
+  CHECK(unpinPage(bm, h));
+  TEST_CHECK(getPoolStats(bm, &stats));
+  ASSERT_EQUALS_INT(2, (int) stats.hits, "prefetched pages are hits");
+  ASSERT_EQUALS_INT(0, (int) stats.misses, "no misses");
+  CHECK(shutdownBufferPool(bm));
+
+  // without the option the pool starts cold
+  CHECK(initBufferPool(bm, "testbuffer.bin", 2, RS_LRU, NULL));
+  ASSERT_EQUALS_INT(0, getNumReadIO(bm), "cold pool");
+  CHECK(shutdownBufferPool(bm));
+
+  CHECK(destroyPageFile("testbuffer.bin"));
+  remove("testbuffer.bin.warm");
+
+  free(h);
+  free(bm);
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testTrace (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PoolOptions options = { .traceEvents = 4 };
+  BM_TraceEvent events[4];
+  int header[2];
+  FILE *traceFile;
+  int i;
+  testName = "Page access trace";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 3, RS_LRU, NULL, &options));
+  ASSERT_TRUE(dumpPoolTrace(bm, "testbuffer.trace") == RC_OK, "empty trace can be dumped");
+
+  // 7 events, the ring buffer keeps the last 4
+  for (i = 0; i < 3; i++)
+    pinAndUnpin(bm, h, i);
+  CHECK(pinPage(bm, h, 2));
+  CHECK(markDirty(bm, h));
+  CHECK(unpinPage(bm, h));
+  CHECK(dumpPoolTrace(bm, "testbuffer.trace"));
+  CHECK(shutdownBufferPool(bm));
+
+  traceFile = fopen("testbuffer.trace", "rb");
+  ASSERT_TRUE(traceFile != NULL, "trace file written");
+  ASSERT_TRUE(fread(header, sizeof(int), 2, traceFile) == 2, "read trace header");
+  ASSERT_EQUALS_INT(BM_TRACE_MAGIC, header[0], "trace file magic");
+  ASSERT_EQUALS_INT(4, header[1], "only the newest events are kept");
+  ASSERT_TRUE(fread(events, sizeof(BM_TraceEvent), 4, traceFile) == 4, "read trace events");
+  fclose(traceFile);
+
+  ASSERT_EQUALS_INT(TE_UNPIN, events[0].type, "oldest event kept");
+  ASSERT_EQUALS_INT(2, events[0].pageNum, "oldest event page");
+  ASSERT_EQUALS_INT(TE_PIN, events[1].type, "pin");
+  ASSERT_EQUALS_INT(TE_DIRTY, events[2].type, "mark dirty");
+  ASSERT_EQUALS_INT(TE_UNPIN, events[3].type, "newest event last");
+  ASSERT_EQUALS_INT(2, events[3].pageNum, "newest event page");
+
+  // no trace was asked for
+  CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_LRU, NULL));
+  ASSERT_TRUE(dumpPoolTrace(bm, "testbuffer.trace") != RC_OK, "pool without a trace");
+  CHECK(shutdownBufferPool(bm));
+
+  CHECK(destroyPageFile("testbuffer.bin"));
+  remove("testbuffer.trace");
+
+  free(h);
+  free(bm);
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testPolicySimulator (void)
+{
+  PS_Cache cache;
+  long long pages[] = { 1, 2, 1, 3, 1 };
+  int i;
+  testName = "Replacement policy simulator";
+
+  // LRU keeps page 1 when page 3 comes in
+  CHECK(psInit(&cache, 2, RS_LRU));
+  for (i = 0; i < 5; i++)
+    psAccess(&cache, PS_KEY(0, pages[i]));
+  ASSERT_EQUALS_INT(2, (int) cache.hits, "LRU hits");
+  psShutdown(&cache);
+
+  // FIFO drops it because it came in first
+  CHECK(psInit(&cache, 2, RS_FIFO));
+  for (i = 0; i < 5; i++)
+    psAccess(&cache, PS_KEY(0, pages[i]));
+  ASSERT_EQUALS_INT(1, (int) cache.hits, "FIFO hits");
+
+  // the same page number in another file is another page
+  psReset(&cache);
+  psAccess(&cache, PS_KEY(0, 1));
+  ASSERT_TRUE(!psAccess(&cache, PS_KEY(1, 1)), "pages of different files");
+  ASSERT_TRUE(psAccess(&cache, PS_KEY(0, 1)), "page still resident");
+  psShutdown(&cache);
+
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testAdaptivePolicy (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PoolOptions options = { .adaptiveWindow = 40 };
+  BM_PoolStats stats;
+  int i;
+  testName = "Adaptive replacement strategy";
+
+  // page 0 is pinned every other time, FIFO keeps throwing it out
+  CHECK(createPageFile("testbuffer.bin"));
+  CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 3, RS_FIFO, NULL, &options));
+  for (i = 0; i < 200; i++)
+    pinAndUnpin(bm, h, (i % 2) ? 1 + (i / 2) % 10 : 0);
+
+  TEST_CHECK(getPoolStats(bm, &stats));
+  ASSERT_TRUE(bm->strategy != RS_FIFO, "switched away from FIFO");
+  ASSERT_EQUALS_INT(1, (int) stats.policySwitches, "switched once");
+
+  // the ghost lists start over at the new size and the strategy stays
+  CHECK(resizeBufferPool(bm, 5));
+  for (i = 0; i < 200; i++)
+    pinAndUnpin(bm, h, (i % 2) ? 1 + (i / 2) % 10 : 0);
+  TEST_CHECK(getPoolStats(bm, &stats));
+  ASSERT_EQUALS_INT(1, (int) stats.policySwitches, "no switch after the resize");
+  CHECK(shutdownBufferPool(bm));
+
+  // the same workload leaves a fixed pool alone
+  CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL));
+  for (i = 0; i < 200; i++)
+    pinAndUnpin(bm, h, (i % 2) ? 1 + (i / 2) % 10 : 0);
+  TEST_CHECK(getPoolStats(bm, &stats));
+  ASSERT_TRUE(bm->strategy == RS_FIFO, "fixed strategy");
+  ASSERT_EQUALS_INT(0, (int) stats.policySwitches, "no switches");
+  CHECK(shutdownBufferPool(bm));
+
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(h);
+  free(bm);
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testAccessRing (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_AccessRing ring;
+  BM_PoolStats stats;
+  int i;
+  testName = "Scan through an access ring";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  CHECK(initBufferPool(bm, "testbuffer.bin", 6, RS_LRU, NULL));
+
+  // pages 0 to 2 are the hot working set
+  for (i = 0; i < 3; i++)
+    pinAndUnpin(bm, h, i);
+
+  // a scan of 20 pages only ever takes 2 frames
+  CHECK(initAccessRing(&ring, 2));
+  for (i = 3; i < 23; i++)
+    {
+      CHECK(pinPageRing(bm, h, i, &ring));
+      ASSERT_EQUALS_INT(i, h->pageNum, "scanned page pinned");
+      CHECK(unpinPage(bm, h));
+    }
+  CHECK(shutdownAccessRing(&ring));
+  ASSERT_EQUALS_INT(5, getPoolFramesUsed(bm), "one frame never used");
+
+  // the working set survived the scan
+  CHECK(resetPoolStats(bm));
+  for (i = 0; i < 3; i++)
+    pinAndUnpin(bm, h, i);
+  TEST_CHECK(getPoolStats(bm, &stats));
+  ASSERT_EQUALS_INT(3, (int) stats.hits, "hot pages still cached");
+
+  // pages already in the pool are pinned as usual through a ring
+  CHECK(initAccessRing(&ring, 1));
+  CHECK(pinPageRing(bm, h, 0, &ring));
+  CHECK(unpinPage(bm, h));
+  CHECK(shutdownAccessRing(&ring));
+  TEST_CHECK(getPoolStats(bm, &stats));
+  ASSERT_EQUALS_INT(4, (int) stats.hits, "ring pin of a cached page is a hit");
+
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(h);
+  free(bm);
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testResizePool (void)
+{
+  BM_SharedPool sp;
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_BufferPool *bmB = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PageHandle *pinned = MAKE_PAGE_HANDLE();
+  BM_PoolStats stats;
+  int i;
+  testName = "Resize a buffer pool in use";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  CHECK(createPageFile("testbuffer2.bin"));
+  CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_CLOCK, NULL));
+  for (i = 2; i >= 0; i--)
+    pinAndUnpin(bm, h, i);
+
+  // growing keeps the cached pages and makes room for more
+  CHECK(resizeBufferPool(bm, 6));
+  ASSERT_EQUALS_INT(6, bm->numPages, "pool grew");
+  CHECK(resetPoolStats(bm));
+  for (i = 0; i < 6; i++)
+    pinAndUnpin(bm, h, i);
+  TEST_CHECK(getPoolStats(bm, &stats));
+  ASSERT_EQUALS_INT(3, (int) stats.hits, "pages cached before growing are hits");
+  ASSERT_EQUALS_INT(0, (int) stats.evictions[RS_CLOCK], "new frames used first");
+
+  // shrinking keeps a pinned page where the client can still reach it
+  CHECK(pinPage(bm, pinned, 0));
+  sprintf(pinned->data, "%s-%i", "Page", pinned->pageNum);
+  CHECK(markDirty(bm, pinned));
+  CHECK(resizeBufferPool(bm, 2));
+  ASSERT_EQUALS_INT(2, bm->numPages, "pool shrank");
+  ASSERT_EQUALS_INT(2, getPoolFramesUsed(bm), "pages evicted down to the new size");
+  ASSERT_EQUALS_STRING("Page-0", pinned->data, "pinned page kept its data");
+
+  // the pool can not become smaller than the pages pinned in it
+  CHECK(pinPage(bm, h, 1));
+  ASSERT_ERROR(resizeBufferPool(bm, 1), "two pages are pinned");
+  ASSERT_EQUALS_INT(2, bm->numPages, "failed resize changes nothing");
+  CHECK(unpinPage(bm, h));
+  CHECK(unpinPage(bm, pinned));
+
+  // the replacement strategy goes on working at the new size
+  CHECK(resizeBufferPool(bm, 1));
+  for (i = 3; i < 6; i++)
+    pinAndUnpin(bm, h, i);
+  ASSERT_EQUALS_INT(1, getPoolFramesUsed(bm), "one frame left");
+  CHECK(pinPage(bm, h, 0));
+  ASSERT_EQUALS_STRING("Page-0", h->data, "evicted page was written back");
+  CHECK(unpinPage(bm, h));
+  CHECK(shutdownBufferPool(bm));
+
+  // in a shared pool, resizing an attached file changes its budget
+  CHECK(initSharedPool(&sp, 4, RS_LRU, NULL));
+  CHECK(attachBufferPool(bm, &sp, "testbuffer.bin", 0));
+  for (i = 0; i < 4; i++)
+    pinAndUnpin(bm, h, i);
+  CHECK(resizeBufferPool(bm, 2));
+  ASSERT_EQUALS_INT(2, getPoolFramesUsed(bm), "file gave back frames above its budget");
+  ASSERT_EQUALS_INT(4, bm->numPages, "shared pool kept its size");
+
+  // the shared pool itself grows for every file attached to it
+  CHECK(resizeSharedPool(&sp, 8));
+  ASSERT_EQUALS_INT(8, sp.numPages, "shared pool grew");
+  CHECK(attachBufferPool(bmB, &sp, "testbuffer2.bin", 0));
+  for (i = 0; i < 6; i++)
+    pinAndUnpin(bmB, h, i);
+  TEST_CHECK(getPoolStats(bmB, &stats));
+  ASSERT_EQUALS_INT(0, (int) stats.evictions[RS_LRU], "second file fits next to the first");
+  ASSERT_EQUALS_INT(8, bmB->numPages, "attached pool shows the new size");
+
+  CHECK(shutdownBufferPool(bmB));
+  CHECK(shutdownBufferPool(bm));
+  CHECK(shutdownSharedPool(&sp));
+  CHECK(destroyPageFile("testbuffer.bin"));
+  CHECK(destroyPageFile("testbuffer2.bin"));
+
+  free(h);
+  free(pinned);
+  free(bm);
+  free(bmB);
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testCompressedTier (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PoolOptions options = { false, 0, 0, 64 * 1024 };
+  BM_PoolStats stats;
+  int i, readIO;
+  testName = "Compressed second tier";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 2, RS_FIFO, NULL, &options));
+
+  // clean pages pushed out of the two frames are kept compressed
+  for (i = 0; i < 6; i++)
+    pinAndUnpin(bm, h, i);
+  TEST_CHECK(getPoolStats(bm, &stats));
+  ASSERT_EQUALS_INT(4, (int) stats.tierStores, "evicted pages stored");
+
+  // and come back without a disk read
+  readIO = getNumReadIO(bm);
+  for (i = 0; i < 4; i++)
+    pinAndUnpin(bm, h, i);
+  TEST_CHECK(getPoolStats(bm, &stats));
+  ASSERT_EQUALS_INT(4, (int) stats.tierHits, "misses served by the tier");
+  ASSERT_EQUALS_INT(readIO, getNumReadIO(bm), "no page read from disk");
+
+  // a dirty page is written back and read from disk the next time
+  CHECK(pinPage(bm, h, 0));
+  sprintf(h->data, "%s-%i", "Page", h->pageNum);
+  CHECK(markDirty(bm, h));
+  CHECK(unpinPage(bm, h));
+  pinAndUnpin(bm, h, 4);
+  pinAndUnpin(bm, h, 5);
+  CHECK(pinPage(bm, h, 0));
+  ASSERT_EQUALS_STRING("Page-0", h->data, "dirty page read back from disk");
+  CHECK(unpinPage(bm, h));
+  ASSERT_EQUALS_INT(readIO + 1, getNumReadIO(bm), "dirty page was not in the tier");
+
+  // the clean copy survives compression
+  pinAndUnpin(bm, h, 4);
+  pinAndUnpin(bm, h, 5);
+  CHECK(resetPoolStats(bm));
+  CHECK(pinPage(bm, h, 0));
+  ASSERT_EQUALS_STRING("Page-0", h->data, "page decompressed");
+  CHECK(unpinPage(bm, h));
+  TEST_CHECK(getPoolStats(bm, &stats));
+  ASSERT_EQUALS_INT(1, (int) stats.tierHits, "page came from the tier");
+
+  // a page without zeros does not get smaller and is not kept
+  CHECK(pinPage(bm, h, 1));
+  memset(h->data, 'x', PAGE_SIZE);
+  CHECK(unpinPage(bm, h));
+  CHECK(resetPoolStats(bm));
+  pinAndUnpin(bm, h, 2);
+  pinAndUnpin(bm, h, 3);
+  TEST_CHECK(getPoolStats(bm, &stats));
+  ASSERT_EQUALS_INT(1, (int) stats.tierStores, "only the compressible page stored");
+  CHECK(shutdownBufferPool(bm));
+
+  // a miss that finds no frame leaves the compressed copy and the counters alone
+  CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 1, RS_FIFO, NULL, &options));
+  pinAndUnpin(bm, h, 0);
+  CHECK(pinPage(bm, h, 1));
+  CHECK(resetPoolStats(bm));
+  readIO = getNumReadIO(bm);
+  ASSERT_EQUALS_INT(RC_NO_SPACE_IN_POOL, pinPage(bm, h, 0), "the only frame is pinned");
+  TEST_CHECK(getPoolStats(bm, &stats));
+  ASSERT_EQUALS_INT(0, (int) stats.misses, "failed pin is not a miss");
+  ASSERT_EQUALS_INT(readIO, getNumReadIO(bm), "nothing read");
+  h->pageNum = 1;
+  CHECK(unpinPage(bm, h));
+  CHECK(pinPage(bm, h, 0));
+  ASSERT_EQUALS_STRING("Page-0", h->data, "page still in the tier");
+  CHECK(unpinPage(bm, h));
+  TEST_CHECK(getPoolStats(bm, &stats));
+  ASSERT_EQUALS_INT(1, (int) stats.tierHits, "served by the tier");
+  ASSERT_EQUALS_INT(readIO, getNumReadIO(bm), "no page read from disk");
+  CHECK(shutdownBufferPool(bm));
+
+  // a page that can not be read is not handed out and takes no frame
+  CHECK(initBufferPool(bm, "testbuffer.bin", 2, RS_FIFO, NULL));
+  pinAndUnpin(bm, h, 0);
+  CHECK(destroyPageFile("testbuffer.bin"));
+  ASSERT_ERROR(pinPage(bm, h, 1), "page file is gone");
+  ASSERT_EQUALS_INT(1, getPoolFramesUsed(bm), "no frame taken");
+  ASSERT_EQUALS_INT(1, getNumReadIO(bm), "failed read not counted");
+  TEST_CHECK(getPoolStats(bm, &stats));
+  ASSERT_EQUALS_INT(0, stats.pinnedFrames, "nothing left pinned");
+  CHECK(shutdownBufferPool(bm));
+
+  free(h);
+  free(bm);
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testQuotasAndPriorities (void)
+{
+  BM_SharedPool sp;
+  BM_BufferPool *bmIndex = MAKE_POOL();
+  BM_BufferPool *bmTable = MAKE_POOL();
+  BM_BufferPool *bmOther = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PoolOptions important = { false, 0, 0, 0, 0, 1 };
+  BM_PoolOptions reserved = { false, 0, 0, 0, 2, 0 };
+  BM_PoolOptions tooMany = { false, 0, 0, 0, 3, 0 };
+  BM_PoolStats stats;
+  int i;
+  testName = "Buffer quotas and priorities";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  CHECK(createPageFile("testbuffer2.bin"));
+
+  // a table scan replaces its own pages rather than those of a higher priority index
+  CHECK(initSharedPool(&sp, 4, RS_LRU, NULL));
+  CHECK(attachBufferPoolWithOptions(bmIndex, &sp, "testbuffer.bin", 0, &important));
+  CHECK(attachBufferPool(bmTable, &sp, "testbuffer2.bin", 0));
+  pinAndUnpin(bmIndex, h, 0);
+  pinAndUnpin(bmIndex, h, 1);
+  for (i = 0; i < 8; i++)
+    pinAndUnpin(bmTable, h, i);
+  ASSERT_EQUALS_INT(2, getPoolFramesUsed(bmIndex), "index pages not replaced");
+  TEST_CHECK(getPoolStats(bmTable, &stats));
+  ASSERT_EQUALS_INT(6, (int) stats.evictions[RS_LRU], "table replaced its own pages");
+
+  // the index replaces table pages first
+  for (i = 2; i < 4; i++)
+    pinAndUnpin(bmIndex, h, i);
+  ASSERT_EQUALS_INT(4, getPoolFramesUsed(bmIndex), "index took the table's frames");
+  CHECK(shutdownBufferPool(bmTable));
+  CHECK(shutdownBufferPool(bmIndex));
+  CHECK(shutdownSharedPool(&sp));
+
+  // reserved frames stay free for their file, and its pages within them stay cached
+  CHECK(initSharedPool(&sp, 4, RS_LRU, NULL));
+  CHECK(attachBufferPoolWithOptions(bmIndex, &sp, "testbuffer.bin", 0, &reserved));
+  CHECK(attachBufferPool(bmTable, &sp, "testbuffer2.bin", 0));
+  for (i = 0; i < 4; i++)
+    pinAndUnpin(bmTable, h, i);
+  ASSERT_EQUALS_INT(2, getPoolFramesUsed(bmTable), "table kept out of the reserved frames");
+  pinAndUnpin(bmIndex, h, 0);
+  pinAndUnpin(bmIndex, h, 1);
+  TEST_CHECK(getPoolStats(bmIndex, &stats));
+  ASSERT_EQUALS_INT(0, (int) stats.evictions[RS_LRU], "reserved frames were free");
+  for (i = 4; i < 8; i++)
+    pinAndUnpin(bmTable, h, i);
+  ASSERT_EQUALS_INT(2, getPoolFramesUsed(bmIndex), "reserved pages not replaced");
+
+  // the pool can not reserve more frames than it has
+  ASSERT_EQUALS_INT(RC_NO_SPACE_IN_POOL,
+      attachBufferPoolWithOptions(bmOther, &sp, "testbuffer2.bin", 0, &tooMany),
+      "not enough frames left to reserve");
+
+  CHECK(shutdownBufferPool(bmTable));
+  CHECK(shutdownBufferPool(bmIndex));
+  CHECK(shutdownSharedPool(&sp));
+  CHECK(destroyPageFile("testbuffer.bin"));
+  CHECK(destroyPageFile("testbuffer2.bin"));
+
+  free(h);
+  free(bmIndex);
+  free(bmTable);
+  free(bmOther);
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testPinPages (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PageHandle handles[5];
+  PageNumber pageNums[5] = { 3, 0, 2, 3, 1 };
+  PageNumber tooMany[5] = { 4, 5, 6, 7, 8 };
+  PageNumber replacing[3] = { 6, 4, 5 };
+  BM_PoolStats stats;
+  PageNumber *frameContents;
+  int *fixCounts;
+  int i, pagesKept;
+  testName = "Pin several pages at once";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  CHECK(initBufferPool(bm, "testbuffer.bin", 4, RS_LRU, NULL));
+  CHECK(pinPage(bm, h, 0));
+  sprintf(h->data, "%s-%i", "Page", h->pageNum);
+  CHECK(markDirty(bm, h));
+  CHECK(unpinPage(bm, h));
+  CHECK(forcePage(bm, h));
+
+  // one cached page, three read in one batch, page 3 asked for twice
+  CHECK(resetPoolStats(bm));
+  CHECK(pinPages(bm, handles, pageNums, 5));
+  for (i = 0; i < 5; i++)
+    ASSERT_EQUALS_INT(pageNums[i], handles[i].pageNum, "page handed out in request order");
+  ASSERT_EQUALS_STRING("Page-0", handles[1].data, "cached page pinned");
+  ASSERT_TRUE(handles[0].data == handles[3].data, "same page, same frame");
+  TEST_CHECK(getPoolStats(bm, &stats));
+  ASSERT_EQUALS_INT(2, (int) stats.hits, "cached page and repeated page are hits");
+  ASSERT_EQUALS_INT(3, (int) stats.misses, "three pages read");
+  fixCounts = getFixCounts(bm);
+  ASSERT_EQUALS_INT(5, fixCounts[0] + fixCounts[1] + fixCounts[2] + fixCounts[3], "every request holds a pin");
+  free(fixCounts);
+
+  // a batch that does not fit pins nothing
+  ASSERT_EQUALS_INT(RC_NO_SPACE_IN_POOL, pinPages(bm, handles, tooMany, 5), "all frames pinned");
+  CHECK(unpinPages(bm, handles, 5));
+  ASSERT_EQUALS_INT(4, getPoolFramesUsed(bm), "pages stay cached");
+  fixCounts = getFixCounts(bm);
+  ASSERT_EQUALS_INT(0, fixCounts[0] + fixCounts[1] + fixCounts[2] + fixCounts[3], "every pin given back");
+  free(fixCounts);
+
+  // three misses in a full pool take the three least recently used pages in one search
+  CHECK(resetPoolStats(bm));
+  CHECK(pinPages(bm, handles, replacing, 3));
+  TEST_CHECK(getPoolStats(bm, &stats));
+  ASSERT_EQUALS_INT(1, (int) stats.victimScans, "one victim search for the batch");
+  ASSERT_EQUALS_INT(3, (int) stats.evictions[RS_LRU], "three pages replaced");
+  frameContents = getFrameContents(bm);
+  for (i = 0, pagesKept = 0; i < 4; i++)
+    pagesKept += (frameContents[i] == 3);
+  ASSERT_EQUALS_INT(1, pagesKept, "most recently used page kept");
+  free(frameContents);
+  CHECK(unpinPages(bm, handles, 3));
+
+  // pages that can not be read are not pinned and take no frame
+  CHECK(destroyPageFile("testbuffer.bin"));
+  ASSERT_ERROR(pinPages(bm, handles, tooMany + 3, 2), "page file is gone");
+  fixCounts = getFixCounts(bm);
+  ASSERT_EQUALS_INT(0, fixCounts[0] + fixCounts[1] + fixCounts[2] + fixCounts[3], "nothing left pinned");
+  free(fixCounts);
+  ASSERT_EQUALS_INT(2, getPoolFramesUsed(bm), "frames of the failed pages are empty");
+
+  CHECK(shutdownBufferPool(bm));
+
+  free(h);
+  free(bm);
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testPinTracking (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h1 = MAKE_PAGE_HANDLE();
+  BM_PageHandle *h2 = MAKE_PAGE_HANDLE();
+  BM_PoolOptions options = { false, 0, 0, 0, 0, 0, true };
+  BM_PoolStats stats;
+  RC rc;
+  testName = "Pin leak detection";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 2, RS_LRU, NULL, &options));
+
+  // a pin given back twice is counted
+  CHECK(pinPage(bm, h1, 0));
+  CHECK(unpinPage(bm, h1));
+  CHECK(unpinPage(bm, h1));
+  TEST_CHECK(getPoolStats(bm, &stats));
+  ASSERT_EQUALS_INT(1, (int) stats.unbalancedUnpins, "second unpin had no pin");
+
+  // a pool with every frame pinned fails right away
+  CHECK(pinPage(bm, h1, 1));
+  CHECK(pinPage(bm, h2, 2));
+  rc = pinPage(bm, h1, 3);
+  ASSERT_EQUALS_INT(RC_NO_SPACE_IN_POOL, rc, "no frame left");
+
+  // the leaked pin keeps the pool from shutting down
+  CHECK(unpinPage(bm, h1));
+  rc = shutdownBufferPool(bm);
+  ASSERT_EQUALS_INT(RC_PINNED_PAGES_IN_BUFFER, rc, "page 2 still pinned");
+  CHECK(unpinPage(bm, h2));
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(h1);
+  free(h2);
+  free(bm);
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testPinSites (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h1 = MAKE_PAGE_HANDLE();
+  BM_PageHandle *h2 = MAKE_PAGE_HANDLE();
+  BM_PageHandle *h3 = MAKE_PAGE_HANDLE();
+  BM_PageHandle hs[2];
+  PageNumber pageNums[] = { 0, 1 };
+  BM_PoolOptions options = { false, 0, 0, 0, 0, 0, true };
+  BM_AccessRing ring;
+  BM_PinSite sites[4];
+  int lineA, lineB, lineC, lineD;
+  testName = "Call site of each pin still held";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 3, RS_LRU, NULL, &options));
+  CHECK(initAccessRing(&ring, 1));
+
+  // two pinPage calls, a pinPages call that hits page 0 and a ring pin
+  lineA = __LINE__; CHECK(pinPage(bm, h1, 0));
+  lineB = __LINE__; CHECK(pinPage(bm, h2, 0));
+  lineC = __LINE__; CHECK(pinPages(bm, hs, pageNums, 2));
+  lineD = __LINE__; CHECK(pinPageRing(bm, h3, 2, &ring));
+
+  ASSERT_EQUALS_INT(3, getPinSites(bm, 0, sites, 4), "page 0 pinned three times");
+  ASSERT_EQUALS_INT(lineA, sites[0].line, "first pinPage");
+  ASSERT_EQUALS_INT(lineB, sites[1].line, "second pinPage");
+  ASSERT_EQUALS_INT(lineC, sites[2].line, "pinPages hit the page");
+  ASSERT_TRUE(strcmp(sites[2].file, __FILE__) == 0, "site names the file");
+  ASSERT_EQUALS_INT(1, getPinSites(bm, 1, sites, 4), "page 1 pinned once");
+  ASSERT_EQUALS_INT(lineC, sites[0].line, "pinPages read the page");
+  ASSERT_EQUALS_INT(1, getPinSites(bm, 2, sites, 4), "page 2 pinned once");
+  ASSERT_EQUALS_INT(lineD, sites[0].line, "pinPageRing");
+
+  // an unpin gives back the pin taken through its handle
+  CHECK(unpinPage(bm, h1));
+  CHECK(unpinPages(bm, hs, 2));
+  ASSERT_EQUALS_INT(1, getPinSites(bm, 0, sites, 4), "page 0 pinned once");
+  ASSERT_EQUALS_INT(lineB, sites[0].line, "pin of the other handle left");
+  ASSERT_EQUALS_INT(0, getPinSites(bm, 1, sites, 4), "page 1 not pinned");
+
+  // the function called without the macro pins without a site, and its unpin keeps the others
+  CHECK((pinPage)(bm, h1, 0));
+  ASSERT_EQUALS_INT(2, getPinSites(bm, 0, sites, 4), "page 0 pinned twice");
+  ASSERT_EQUALS_INT(lineB, sites[0].line, "earlier pin first");
+  ASSERT_TRUE(sites[1].file == NULL, "pin without a site");
+  CHECK(unpinPage(bm, h1));
+  ASSERT_EQUALS_INT(1, getPinSites(bm, 0, sites, 4), "page 0 pinned once");
+  ASSERT_EQUALS_INT(lineB, sites[0].line, "site of the pin held kept");
+
+  CHECK(unpinPage(bm, h2));
+  CHECK(unpinPage(bm, h3));
+  ASSERT_EQUALS_INT(0, getPinSites(bm, 0, sites, 4), "nothing pinned");
+  CHECK(shutdownBufferPool(bm));
+  CHECK(shutdownAccessRing(&ring));
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(h1);
+  free(h2);
+  free(h3);
+  free(bm);
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+pinAndUnpin (BM_BufferPool *bm, BM_PageHandle *h, int pageNum)
+{
+  CHECK(pinPage(bm, h, pageNum));
+  CHECK(unpinPage(bm, h));
+}
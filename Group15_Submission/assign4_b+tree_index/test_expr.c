@@ -29,6 +29,9 @@
 static void testValueSerialize (void);
 static void testOperators (void);
 static void testExpressions (void);
+static void testCompiledExpressions (void);
+static void testCompiledColumns (void);
+static void testCompiledColumnsConstantFirst (void);
 
 char *testName;
 
@@ -41,6 +44,9 @@ main (void)
 	testValueSerialize();
 	testOperators();
 	testExpressions();
+	testCompiledExpressions();
+	testCompiledColumns();
+	testCompiledColumnsConstantFirst();
 
 	return 0;
 }
@@ -123,3 +129,219 @@ testExpressions (void)
 
 	TEST_DONE();
 }
+
+// ************************************************************
+// the compiled program of a condition has to agree with evalExpr
+#define PROG_MATCHES_EVAL(program, expr, record, schema, message)	\
+		do {							\
+			Value *res;					\
+			TEST_CHECK(evalExpr(record, schema, expr, &res));	\
+			bool b = res->v.boolV;				\
+			freeVal(res);					\
+			ASSERT_TRUE(runExprProgram(program, (record)->data) == b, message); \
+		} while (0)
+
+void
+testCompiledExpressions (void)
+{
+	Expr *a, *b, *c, *lt, *eq, *op;
+	ExprProgram *program;
+	Record *r;
+	char *names[] = { "a", "b", "c" };
+	DataType dt[] = { DT_INT, DT_STRING, DT_FLOAT };
+	int sizes[] = { 0, 4, 0 };
+	int keys[] = { 0 };
+	Schema *schema = createSchema(3, names, dt, sizes, 1, keys);
+	testName = "test compiled expressions";
+
+	TEST_CHECK(createRecord(&r, schema));
+
+	// (a < 10 AND b = "abcd") OR NOT (c < 1.5)
+	MAKE_ATTRREF(a, 0);
+	MAKE_CONS(b, stringToValue("i10"));
+	MAKE_BINOP_EXPR(lt, a, b, OP_COMP_SMALLER);
+	MAKE_ATTRREF(a, 1);
+	MAKE_CONS(b, stringToValue("sabcd"));
+	MAKE_BINOP_EXPR(eq, a, b, OP_COMP_EQUAL);
+	MAKE_BINOP_EXPR(op, lt, eq, OP_BOOL_AND);
+	MAKE_ATTRREF(a, 2);
+	MAKE_CONS(b, stringToValue("f1.5"));
+	MAKE_BINOP_EXPR(lt, a, b, OP_COMP_SMALLER);
+	MAKE_UNOP_EXPR(c, lt, OP_BOOL_NOT);
+	MAKE_BINOP_EXPR(eq, op, c, OP_BOOL_OR);
+
+	program = compileExpr(eq, schema);
+	ASSERT_TRUE(program != NULL, "condition compiles");
+
+	TEST_CHECK(setAttr(r, schema, 0, stringToValue("i3")));
+	TEST_CHECK(setAttr(r, schema, 1, stringToValue("sabcd")));
+	TEST_CHECK(setAttr(r, schema, 2, stringToValue("f1.0")));
+	PROG_MATCHES_EVAL(program, eq, r, schema, "a < 10 and b = abcd");
+	ASSERT_TRUE(runExprProgram(program, r->data), "3 < 10 AND abcd = abcd");
+
+	TEST_CHECK(setAttr(r, schema, 1, stringToValue("sabc")));
+	PROG_MATCHES_EVAL(program, eq, r, schema, "b is a prefix of the constant");
+	ASSERT_TRUE(!runExprProgram(program, r->data), "abc != abcd and NOT 1.0 < 1.5");
+
+	TEST_CHECK(setAttr(r, schema, 2, stringToValue("f2.0")));
+	PROG_MATCHES_EVAL(program, eq, r, schema, "NOT c < 1.5");
+	ASSERT_TRUE(runExprProgram(program, r->data), "NOT 2.0 < 1.5");
+	freeExprProgram(program);
+
+	// comparisons of different types are left to evalExpr
+	MAKE_ATTRREF(a, 0);
+	MAKE_CONS(b, stringToValue("sabcd"));
+	MAKE_BINOP_EXPR(op, a, b, OP_COMP_EQUAL);
+	ASSERT_TRUE(compileExpr(op, schema) == NULL, "int = string does not compile");
+
+	freeExpr(op);
+	freeExpr(eq);
+	freeRecord(r);
+	freeSchema(schema);
+
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testCompiledColumns (void)
+{
+	Expr *a, *b, *lt, *eq, *op;
+	ExprProgram *program;
+	int ints[1000];
+	float floats[1000];
+	const char *columns[2] = { (const char *) ints, (const char *) floats };
+	int strides[2] = { sizeof(int), sizeof(float) };
+	uint64_t selection[(1000 + 63) / 64];
+	char *names[] = { "a", "b" };
+	DataType dt[] = { DT_INT, DT_FLOAT };
+	int sizes[] = { 0, 0 };
+	int keys[] = { 0 };
+	Schema *schema = createSchema(2, names, dt, sizes, 1, keys);
+	int selected = 0;
+	testName = "test compiled expressions over columns";
+
+	for (int i = 0; i < 1000; i++)
+	{
+		ints[i] = (i * 37) % 1000;
+		floats[i] = (float) (i % 3);
+	}
+
+	// a < 300 AND NOT b = 1.0
+	MAKE_ATTRREF(a, 0);
+	MAKE_CONS(b, stringToValue("i300"));
+	MAKE_BINOP_EXPR(lt, a, b, OP_COMP_SMALLER);
+	MAKE_ATTRREF(a, 1);
+	MAKE_CONS(b, stringToValue("f1.0"));
+	MAKE_BINOP_EXPR(eq, a, b, OP_COMP_EQUAL);
+	MAKE_UNOP_EXPR(b, eq, OP_BOOL_NOT);
+	MAKE_BINOP_EXPR(op, lt, b, OP_BOOL_AND);
+
+	program = compileExpr(op, schema);
+	ASSERT_TRUE(program != NULL, "condition compiles");
+	runExprProgramColumns(program, columns, strides, 1000, selection);
+
+	for (int i = 0; i < 1000; i++)
+	{
+		bool bit = (selection[i / 64] >> (i % 64)) & 1;
+		if (bit != (ints[i] < 300 && floats[i] != 1.0f))
+		{
+			printf("record %i selected %i\n", i, bit);
+			ASSERT_TRUE(false, "selection matches the condition");
+		}
+		selected += bit;
+	}
+	ASSERT_TRUE((selection[1000 / 64] >> (1000 % 64)) == 0, "no bits past the last record");
+	ASSERT_EQUALS_INT(189, selected, "a < 300 and b != 1.0 for 189 records");
+
+	freeExprProgram(program);
+	freeExpr(op);
+	freeSchema(schema);
+
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testCompiledColumnsConstantFirst (void)
+{
+	Expr *a, *b, *lt, *eq, *op;
+	ExprProgram *program;
+	int ints[1000];
+	float floats[1000];
+	const char *columns[2] = { (const char *) ints, (const char *) floats };
+	int strides[2] = { sizeof(int), sizeof(float) };
+	uint64_t selection[(1000 + 63) / 64];
+	char *names[] = { "a", "b" };
+	DataType dt[] = { DT_INT, DT_FLOAT };
+	int sizes[] = { 0, 0 };
+	int keys[] = { 0 };
+	Schema *schema = createSchema(2, names, dt, sizes, 1, keys);
+	int selected;
+	testName = "test compiled expressions over columns with the constant first";
+
+	for (int i = 0; i < 1000; i++)
+	{
+		ints[i] = (i * 37) % 1000 - 500;
+		floats[i] = (float) (i % 3);
+	}
+
+	// -200 < a AND 1.0 = b
+	MAKE_CONS(a, stringToValue("i-200"));
+	MAKE_ATTRREF(b, 0);
+	MAKE_BINOP_EXPR(lt, a, b, OP_COMP_SMALLER);
+	MAKE_CONS(a, stringToValue("f1.0"));
+	MAKE_ATTRREF(b, 1);
+	MAKE_BINOP_EXPR(eq, a, b, OP_COMP_EQUAL);
+	MAKE_BINOP_EXPR(op, lt, eq, OP_BOOL_AND);
+
+	program = compileExpr(op, schema);
+	ASSERT_TRUE(program != NULL, "condition compiles");
+	runExprProgramColumns(program, columns, strides, 1000, selection);
+	selected = 0;
+	for (int i = 0; i < 1000; i++)
+	{
+		bool bit = (selection[i / 64] >> (i % 64)) & 1;
+		if (bit != (ints[i] > -200 && floats[i] == 1.0f))
+		{
+			printf("record %i selected %i\n", i, bit);
+			ASSERT_TRUE(false, "selection matches the condition");
+		}
+		selected += bit;
+	}
+	ASSERT_EQUALS_INT(222, selected, "a > -200 and b = 1.0 for 222 records");
+	freeExprProgram(program);
+	freeExpr(op);
+
+	// 7 = a OR 0.5 < b
+	MAKE_CONS(a, stringToValue("i7"));
+	MAKE_ATTRREF(b, 0);
+	MAKE_BINOP_EXPR(eq, a, b, OP_COMP_EQUAL);
+	MAKE_CONS(a, stringToValue("f0.5"));
+	MAKE_ATTRREF(b, 1);
+	MAKE_BINOP_EXPR(lt, a, b, OP_COMP_SMALLER);
+	MAKE_BINOP_EXPR(op, eq, lt, OP_BOOL_OR);
+
+	program = compileExpr(op, schema);
+	ASSERT_TRUE(program != NULL, "condition compiles");
+	runExprProgramColumns(program, columns, strides, 1000, selection);
+	selected = 0;
+	for (int i = 0; i < 1000; i++)
+	{
+		bool bit = (selection[i / 64] >> (i % 64)) & 1;
+		if (bit != (ints[i] == 7 || floats[i] > 0.5f))
+		{
+			printf("record %i selected %i\n", i, bit);
+			ASSERT_TRUE(false, "selection matches the condition");
+		}
+		selected += bit;
+	}
+	ASSERT_TRUE((selection[1000 / 64] >> (1000 % 64)) == 0, "no bits past the last record");
+	ASSERT_EQUALS_INT(666, selected, "a = 7 or b > 0.5 for 666 records");
+	freeExprProgram(program);
+	freeExpr(op);
+
+	freeSchema(schema);
+
+	TEST_DONE();
+}
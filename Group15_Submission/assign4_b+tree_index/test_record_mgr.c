@@ -0,0 +1,1974 @@
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "btree_mgr.h"
+#include "buffer_mgr.h"
+#include "const.h"
+#include "dberror.h"
+#include "expr.h"
+#include "record_mgr.h"
+#include "storage_mgr.h"
+#include "tables.h"
+#include "test_helper.h"
+
+#define ASSERT_EQUALS_RECORDS(_l,_r, schema, message)			\
+  do {									\
+    ASSERT_TRUE(memcmp((_l)->data, (_r)->data, getRecordSize(schema)) == 0, message); \
+  } while(0)
+
+#define ASSERT_EQUALS_RID(_l,_r, message)				\
+  do {									\
+    ASSERT_TRUE((_l).page == (_r).page && (_l).slot == (_r).slot, message); \
+  } while(0)
+
+// test methods
+static void testRoundTrip (void);
+static void testVariableLengthStrings (void);
+static void testForwardOnUpdate (void);
+static void testCompaction (void);
+static void testFreeSpaceMap (void);
+static void testInsertRecords (void);
+static void testInsertRecordsIndexFailure (void);
+static void testCatalogReopen (void);
+static void testCatalogFile (void);
+static void testOpenTableTwice (void);
+static void testPaxTable (void);
+static void testNextBatch (void);
+static void testScanReadFailure (void);
+static void testRecordView (void);
+static void testRingScan (void);
+static void testParallelScan (void);
+static void testProjectedScan (void);
+static void testDuplicateKeys (void);
+static void testUpdateIndexFailure (void);
+static void testIndexRanges (void);
+static void testRowPageColumns (void);
+
+// helper methods
+static Schema *testSchema (int stringLength);
+static Record *testRecord (Schema *schema, int a, char *b, int c);
+static Record *repeatedRecord (Schema *schema, int a, char fill, int length, int c);
+static Expr *attrAtLeast (int attrNum, int value);
+static Expr *attrEquals (int attrNum, int value);
+static Expr *attrCompare (int attrNum, OpType op, int value, bool constFirst);
+static int countRecords (RM_TableData *table, Expr *cond);
+static void checkIndexRange (RM_TableData *table, Expr *cond, int attrNum, int low, int high, int expected);
+static void checkBatchScan (RM_TableData *table, Expr *cond, int maxRows, Record **records, int numRecords, int expected);
+static void checkProjectedScan (RM_TableData *table, Expr *cond, RM_ScanOptions *options, Record **records, int numRecords, int expected);
+static void checkProjectedRecord (Record *r, Schema *schema, Record **records, bool *seen);
+
+// test name
+char *testName;
+
+// main method
+int
+main (void)
+{
+  testName = "";
+
+  testRoundTrip();
+  testVariableLengthStrings();
+  testForwardOnUpdate();
+  testCompaction();
+  testFreeSpaceMap();
+  testInsertRecords();
+  testInsertRecordsIndexFailure();
+  testCatalogReopen();
+  testCatalogFile();
+  testOpenTableTwice();
+  testPaxTable();
+  testNextBatch();
+  testScanReadFailure();
+  testRecordView();
+  testRingScan();
+  testParallelScan();
+  testProjectedScan();
+  testDuplicateKeys();
+  testUpdateIndexFailure();
+  testIndexRanges();
+  testRowPageColumns();
+
+  return 0;
+}
+
+// ************************************************************
+void
+testRoundTrip (void)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  int numInserts = 300;
+  Record **records = (Record **) malloc(sizeof(Record *) * numInserts);
+  bool *deleted = (bool *) calloc(numInserts, sizeof(bool));
+  int *seen = (int *) calloc(numInserts, sizeof(int));
+  int numDeleted = 0;
+  Schema *schema;
+  Record *r;
+  Expr *sel;
+  RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+  int i, rc;
+  testName = "test inserting, updating, deleting and scanning records";
+
+  schema = testSchema(600);
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTable("test_table_rm", schema));
+  TEST_CHECK(openTable(table, "test_table_rm"));
+
+  // strings of all lengths up to the width of the attribute
+  for(i = 0; i < numInserts; i++)
+    {
+      records[i] = repeatedRecord(schema, i, 'a' + i % 26, (i * 7) % 600, i * 2);
+      TEST_CHECK(insertRecord(table, records[i]));
+    }
+  ASSERT_EQUALS_INT(numInserts, getNumTuples(table), "all records inserted");
+
+  TEST_CHECK(createRecord(&r, schema));
+  for(i = 0; i < numInserts; i++)
+    {
+      TEST_CHECK(getRecord(table, records[i]->id, r));
+      ASSERT_EQUALS_RECORDS(records[i], r, schema, "read back what was inserted");
+    }
+
+  // every third record changes its string length, every fifth goes away
+  for(i = 0; i < numInserts; i += 3)
+    {
+      RID id = records[i]->id;
+      freeRecord(records[i]);
+      records[i] = repeatedRecord(schema, i, 'A' + i % 26, (i * 13) % 599 + 1, i * 2 + 1);
+      records[i]->id = id;
+      TEST_CHECK(updateRecord(table, records[i]));
+    }
+  for(i = 0; i < numInserts; i += 5)
+    {
+      TEST_CHECK(deleteRecord(table, records[i]->id));
+      deleted[i] = TRUE;
+      numDeleted++;
+    }
+
+  // the records come back the same after the table was closed
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(openTable(table, "test_table_rm"));
+  ASSERT_EQUALS_INT(numInserts - numDeleted, getNumTuples(table), "deleted records are not counted");
+
+  for(i = 0; i < numInserts; i++)
+    {
+      if (deleted[i])
+	{
+	  rc = getRecord(table, records[i]->id, r);
+	  ASSERT_EQUALS_INT(RC_RM_NO_TUPLE_WITH_GIVEN_RID, rc, "deleted record is gone");
+	}
+      else
+	{
+	  TEST_CHECK(getRecord(table, records[i]->id, r));
+	  ASSERT_EQUALS_RECORDS(records[i], r, schema, "read back after update and reopen");
+	}
+    }
+
+  // a scan returns every record that is left once
+  sel = attrAtLeast(0, 0);
+  TEST_CHECK(startScan(table, sc, sel));
+  while((rc = next(sc, r)) == RC_OK)
+    {
+      Value *a;
+      TEST_CHECK(getAttr(r, schema, 0, &a));
+      ASSERT_TRUE(a->v.intV >= 0 && a->v.intV < numInserts && !deleted[a->v.intV], "scan returns a live record");
+      ASSERT_EQUALS_RID(records[a->v.intV]->id, r->id, "scan returns the RID of the record");
+      ASSERT_EQUALS_RECORDS(records[a->v.intV], r, schema, "scan returns the record");
+      seen[a->v.intV]++;
+      freeVal(a);
+    }
+  ASSERT_EQUALS_INT(RC_RM_NO_MORE_TUPLES, rc, "scan ends after the last record");
+  TEST_CHECK(closeScan(sc));
+  for(i = 0; i < numInserts; i++)
+    ASSERT_EQUALS_INT(deleted[i] ? 0 : 1, seen[i], "scan returns each record once");
+
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("test_table_rm"));
+  TEST_CHECK(shutdownRecordManager());
+  TEST_CHECK(destroyPageFile(CATALOG_FILE_NAME));
+
+  for(i = 0; i < numInserts; i++)
+    freeRecord(records[i]);
+  freeRecord(r);
+  freeExpr(sel);
+  free(records);
+  free(deleted);
+  free(seen);
+  free(sc);
+  free(table);
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testVariableLengthStrings (void)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  int numInserts = 40;
+  Record **records = (Record **) malloc(sizeof(Record *) * numInserts);
+  Schema *schema;
+  Record *r;
+  int i;
+  testName = "test short strings of a wide attribute share a page";
+
+  // at its full width only three records would fit on a page
+  schema = testSchema(2000);
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTable("test_table_rm", schema));
+  TEST_CHECK(openTable(table, "test_table_rm"));
+
+  for(i = 0; i < numInserts; i++)
+    {
+      records[i] = testRecord(schema, i, "short", i);
+      TEST_CHECK(insertRecord(table, records[i]));
+      ASSERT_EQUALS_INT(records[0]->id.page, records[i]->id.page, "record on the first page");
+    }
+
+  TEST_CHECK(createRecord(&r, schema));
+  for(i = 0; i < numInserts; i++)
+    {
+      TEST_CHECK(getRecord(table, records[i]->id, r));
+      ASSERT_EQUALS_RECORDS(records[i], r, schema, "string padded to its width again");
+    }
+
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("test_table_rm"));
+  TEST_CHECK(shutdownRecordManager());
+  TEST_CHECK(destroyPageFile(CATALOG_FILE_NAME));
+
+  for(i = 0; i < numInserts; i++)
+    freeRecord(records[i]);
+  freeRecord(r);
+  free(records);
+  free(table);
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testForwardOnUpdate (void)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  int capacity = 1000;
+  Record **records = (Record **) malloc(sizeof(Record *) * capacity);
+  Schema *schema;
+  Record *r, *grown;
+  Expr *sel;
+  RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+  int i, n, rc, found;
+  testName = "test a record that outgrows its page keeps its RID";
+
+  schema = testSchema(2000);
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTable("test_table_rm", schema));
+  TEST_CHECK(openTable(table, "test_table_rm"));
+
+  // fill the first data page with short records, the last one goes to the next page
+  for(n = 0; n < capacity; n++)
+    {
+      records[n] = repeatedRecord(schema, n, 'a', 10, n);
+      TEST_CHECK(insertRecord(table, records[n]));
+      if (records[n]->id.page != records[0]->id.page)
+	{
+	  n++;
+	  break;
+	}
+    }
+  ASSERT_TRUE(n < capacity, "first page filled up");
+
+  // the first record grows past what its full page has room for
+  grown = repeatedRecord(schema, 0, 'z', 1990, 0);
+  grown->id = records[0]->id;
+  TEST_CHECK(updateRecord(table, grown));
+  freeRecord(records[0]);
+  records[0] = grown;
+
+  TEST_CHECK(createRecord(&r, schema));
+  for(i = 0; i < n; i++)
+    {
+      TEST_CHECK(getRecord(table, records[i]->id, r));
+      ASSERT_EQUALS_RECORDS(records[i], r, schema, "records read back after one moved");
+    }
+
+  // a scan returns the moved record once, under its home RID
+  sel = attrAtLeast(0, 0);
+  TEST_CHECK(startScan(table, sc, sel));
+  found = 0;
+  i = 0;
+  while((rc = next(sc, r)) == RC_OK)
+    {
+      if (r->id.page == records[0]->id.page && r->id.slot == records[0]->id.slot)
+	{
+	  ASSERT_EQUALS_RECORDS(records[0], r, schema, "scan returns the moved record");
+	  found++;
+	}
+      i++;
+    }
+  ASSERT_EQUALS_INT(RC_RM_NO_MORE_TUPLES, rc, "scan ends after the last record");
+  TEST_CHECK(closeScan(sc));
+  ASSERT_EQUALS_INT(1, found, "moved record scanned once");
+  ASSERT_EQUALS_INT(n, i, "scan returns every record once");
+
+  // the moved record grows and shrinks again where it is now
+  for(i = 0; i < 2; i++)
+    {
+      grown = repeatedRecord(schema, 0, 'y' - i, i == 0 ? 1999 : 5, 0);
+      grown->id = records[0]->id;
+      TEST_CHECK(updateRecord(table, grown));
+      freeRecord(records[0]);
+      records[0] = grown;
+      TEST_CHECK(getRecord(table, records[0]->id, r));
+      ASSERT_EQUALS_RECORDS(records[0], r, schema, "moved record updated");
+    }
+
+  // deleting it removes it from where it moved to as well
+  TEST_CHECK(deleteRecord(table, records[0]->id));
+  rc = getRecord(table, records[0]->id, r);
+  ASSERT_EQUALS_INT(RC_RM_NO_TUPLE_WITH_GIVEN_RID, rc, "moved record deleted");
+  ASSERT_EQUALS_INT(n - 1, countRecords(table, sel), "deleted moved record is not scanned");
+  ASSERT_EQUALS_INT(n - 1, getNumTuples(table), "deleted moved record is not counted");
+
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("test_table_rm"));
+  TEST_CHECK(shutdownRecordManager());
+  TEST_CHECK(destroyPageFile(CATALOG_FILE_NAME));
+
+  for(i = 0; i < n; i++)
+    freeRecord(records[i]);
+  freeRecord(r);
+  freeExpr(sel);
+  free(records);
+  free(sc);
+  free(table);
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testCompaction (void)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  int capacity = 100;
+  Record **records = (Record **) malloc(sizeof(Record *) * capacity);
+  bool *deleted = (bool *) calloc(capacity, sizeof(bool));
+  Schema *schema;
+  Record *r, *large;
+  int i, n, firstPage;
+  testName = "test deleted records leave room for a larger one on their page";
+
+  schema = testSchema(3000);
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTable("test_table_rm", schema));
+  TEST_CHECK(openTable(table, "test_table_rm"));
+
+  for(n = 0; n < capacity; n++)
+    {
+      records[n] = repeatedRecord(schema, n, 'a' + n % 26, 900, n);
+      TEST_CHECK(insertRecord(table, records[n]));
+      if (records[n]->id.page != records[0]->id.page)
+	{
+	  n++;
+	  break;
+	}
+    }
+  firstPage = records[0]->id.page;
+
+  // every other record of the first page leaves a gap smaller than the new record
+  for(i = 0; i < n - 1; i += 2)
+    {
+      TEST_CHECK(deleteRecord(table, records[i]->id));
+      deleted[i] = TRUE;
+    }
+
+  large = repeatedRecord(schema, n, 'Z', 2500, n);
+  TEST_CHECK(insertRecord(table, large));
+  ASSERT_EQUALS_INT(firstPage, large->id.page, "gaps were closed to make room");
+
+  TEST_CHECK(createRecord(&r, schema));
+  TEST_CHECK(getRecord(table, large->id, r));
+  ASSERT_EQUALS_RECORDS(large, r, schema, "large record read back");
+  for(i = 0; i < n; i++)
+    {
+      if (deleted[i])
+	continue;
+      TEST_CHECK(getRecord(table, records[i]->id, r));
+      ASSERT_EQUALS_RECORDS(records[i], r, schema, "records moved on their page read back");
+    }
+
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("test_table_rm"));
+  TEST_CHECK(shutdownRecordManager());
+  TEST_CHECK(destroyPageFile(CATALOG_FILE_NAME));
+
+  for(i = 0; i < n; i++)
+    freeRecord(records[i]);
+  freeRecord(large);
+  freeRecord(r);
+  free(records);
+  free(deleted);
+  free(table);
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testFreeSpaceMap (void)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  int numInserts = FSM_PAGES_PER_MAP + 3;
+  int secondMap = 1 + FSM_PAGES_PER_MAP + 1;
+  RID *rids = (RID *) malloc(sizeof(RID) * numInserts);
+  bool *seen = (bool *) calloc(numInserts, sizeof(bool));
+  Schema *schema;
+  Record *r;
+  Value *value;
+  Expr *sel;
+  RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+  bool onMapPage = FALSE, inOrder = TRUE, once = TRUE;
+  int i, rc, count, lastPage;
+  testName = "test the free-space map past its first map page";
+
+  // a record with a string this long takes up a page of its own
+  schema = testSchema(5000);
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTable("test_table_rm", schema));
+  TEST_CHECK(openTable(table, "test_table_rm"));
+
+  r = repeatedRecord(schema, 0, 'f', 5000, 0);
+  for(i = 0; i < numInserts; i++)
+    {
+      MAKE_VALUE(value, DT_INT, i);
+      TEST_CHECK(setAttr(r, schema, 0, value));
+      freeVal(value);
+      TEST_CHECK(insertRecord(table, r));
+      rids[i] = r->id;
+      onMapPage = onMapPage || rids[i].page == 1 || rids[i].page == secondMap;
+      inOrder = inOrder && (i == 0 || rids[i].page > rids[i - 1].page);
+    }
+  ASSERT_EQUALS_INT(2, rids[0].page, "first record after the first map page");
+  ASSERT_TRUE(!onMapPage, "no record on a map page");
+  ASSERT_TRUE(inOrder, "every record on a page of its own");
+  ASSERT_EQUALS_INT(secondMap + 3, rids[numInserts - 1].page, "table grew past the second map page");
+  rc = getRecord(table, (RID) { secondMap, 0 }, r);
+  ASSERT_EQUALS_INT(RC_RM_NO_TUPLE_WITH_GIVEN_RID, rc, "a map page holds no records");
+
+  // a scan reads the data pages on both sides of the map pages only
+  sel = attrAtLeast(0, 0);
+  TEST_CHECK(startScan(table, sc, sel));
+  count = 0;
+  while((rc = next(sc, r)) == RC_OK)
+    {
+      TEST_CHECK(getAttr(r, schema, 0, &value));
+      once = once && !seen[value->v.intV];
+      seen[value->v.intV] = TRUE;
+      onMapPage = onMapPage || r->id.page == 1 || r->id.page == secondMap;
+      freeVal(value);
+      count++;
+    }
+  ASSERT_EQUALS_INT(RC_RM_NO_MORE_TUPLES, rc, "scan ends after the last record");
+  TEST_CHECK(closeScan(sc));
+  ASSERT_EQUALS_INT(numInserts, count, "scan returns every record");
+  ASSERT_TRUE(once && !onMapPage, "scan returns each record once and none from a map page");
+
+  // pages emptied on both sides of the second map page are filled again, the lower one
+  // first, before the table grows, also after the table was closed in between
+  lastPage = rids[numInserts - 1].page;
+  TEST_CHECK(deleteRecord(table, rids[numInserts - 2]));
+  TEST_CHECK(deleteRecord(table, rids[10]));
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(openTable(table, "test_table_rm"));
+
+  TEST_CHECK(insertRecord(table, r));
+  ASSERT_EQUALS_RID(rids[10], r->id, "freed page before the second map page reused");
+  TEST_CHECK(insertRecord(table, r));
+  ASSERT_EQUALS_RID(rids[numInserts - 2], r->id, "freed page after the second map page reused");
+  TEST_CHECK(insertRecord(table, r));
+  ASSERT_EQUALS_INT(lastPage + 1, r->id.page, "table grows once no page has room");
+  ASSERT_EQUALS_INT(numInserts + 1, getNumTuples(table), "records counted");
+
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("test_table_rm"));
+  TEST_CHECK(shutdownRecordManager());
+  TEST_CHECK(destroyPageFile(CATALOG_FILE_NAME));
+
+  freeRecord(r);
+  freeExpr(sel);
+  free(rids);
+  free(seen);
+  free(sc);
+  free(table);
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testInsertRecords (void)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  int numInserts = 500;
+  Record **records = (Record **) malloc(sizeof(Record *) * numInserts);
+  Schema *schema;
+  Record *r;
+  Expr *sel;
+  int i, numPages;
+  testName = "test inserting records in one batch";
+
+  schema = testSchema(300);
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTable("test_table_rm", schema));
+  TEST_CHECK(openTable(table, "test_table_rm"));
+  TEST_CHECK(createIndex(table, 2));
+
+  for(i = 0; i < numInserts; i++)
+    records[i] = repeatedRecord(schema, i, 'a' + i % 26, (i * 11) % 300, numInserts - i);
+  TEST_CHECK(insertRecords(table, records, numInserts));
+  ASSERT_EQUALS_INT(numInserts, getNumTuples(table), "all records of the batch counted");
+
+  // the batch fills its pages one after the other
+  numPages = 1;
+  for(i = 1; i < numInserts; i++)
+    if (records[i]->id.page != records[i - 1]->id.page)
+      {
+	ASSERT_TRUE(records[i]->id.page > records[i - 1]->id.page, "batch goes on on a later page");
+	numPages++;
+      }
+  ASSERT_TRUE(numPages > 1 && numPages < numInserts, "batch spread over a few pages");
+
+  TEST_CHECK(createRecord(&r, schema));
+  for(i = 0; i < numInserts; i++)
+    {
+      TEST_CHECK(getRecord(table, records[i]->id, r));
+      ASSERT_EQUALS_RECORDS(records[i], r, schema, "batch record read back");
+    }
+
+  // the index scan finds every record of the batch
+  sel = attrAtLeast(2, 1);
+  checkIndexRange(table, sel, 2, 1, INT_MAX, numInserts);
+
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("test_table_rm"));
+  TEST_CHECK(shutdownRecordManager());
+  TEST_CHECK(destroyPageFile(CATALOG_FILE_NAME));
+
+  for(i = 0; i < numInserts; i++)
+    freeRecord(records[i]);
+  freeRecord(r);
+  freeExpr(sel);
+  free(records);
+  free(table);
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testInsertRecordsIndexFailure (void)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  int numFirst = 60;
+  int numBatch = 10;
+  Record **records = (Record **) malloc(sizeof(Record *) * numBatch);
+  Schema *schema;
+  Record *r;
+  Expr *sel;
+  int i, rc, inserted;
+  testName = "test a batch stops at a record its index can not take";
+
+  schema = testSchema(20);
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTable("test_table_rm", schema));
+  TEST_CHECK(openTable(table, "test_table_rm"));
+  TEST_CHECK(createIndex(table, 0));
+
+  // the keys so far fit in the root leaf of the index
+  for(i = 0; i < numFirst; i++)
+    {
+      r = testRecord(schema, i, "first", i);
+      TEST_CHECK(insertRecord(table, r));
+      freeRecord(r);
+    }
+
+  // with the index file gone the leaf can not be split to make room for more keys,
+  // the page file of the index is named after the table and the attribute
+  TEST_CHECK(destroyPageFile("test_table_rm.idx0"));
+  for(i = 0; i < numBatch; i++)
+    records[i] = testRecord(schema, numFirst + i, "batch", i);
+  rc = insertRecords(table, records, numBatch);
+  ASSERT_TRUE(rc != RC_OK, "batch reports the index error");
+
+  // the records before the failure are in, the one that failed and the rest are not
+  inserted = 0;
+  while(inserted < numBatch && records[inserted]->id.page != -1)
+    inserted++;
+  ASSERT_TRUE(inserted > 0 && inserted < numBatch, "batch stopped part of the way");
+  for(i = inserted; i < numBatch; i++)
+    ASSERT_EQUALS_INT(-1, records[i]->id.page, "record after the failure has no RID");
+  ASSERT_EQUALS_INT(numFirst + inserted, getNumTuples(table), "only inserted records counted");
+
+  TEST_CHECK(createRecord(&r, schema));
+  for(i = 0; i < inserted; i++)
+    {
+      TEST_CHECK(getRecord(table, records[i]->id, r));
+      ASSERT_EQUALS_RECORDS(records[i], r, schema, "inserted batch record read back");
+    }
+  sel = attrAtLeast(2, 0);
+  ASSERT_EQUALS_INT(numFirst + inserted, countRecords(table, sel), "failed record not stored");
+
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("test_table_rm"));
+  TEST_CHECK(shutdownRecordManager());
+  TEST_CHECK(destroyPageFile(CATALOG_FILE_NAME));
+
+  for(i = 0; i < numBatch; i++)
+    freeRecord(records[i]);
+  freeRecord(r);
+  freeExpr(sel);
+  free(records);
+  free(table);
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testCatalogReopen (void)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  int numInserts = 50;
+  RID *rids = (RID *) malloc(sizeof(RID) * numInserts);
+  Schema *schema, *other;
+  Record *r, *expected;
+  int i, rc;
+  testName = "test the catalog outlives the record manager";
+
+  schema = testSchema(40);
+  other = testSchema(7);
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTable("test_table_rm", schema));
+  TEST_CHECK(createTable("test_table_rm2", other));
+  TEST_CHECK(openTable(table, "test_table_rm"));
+  TEST_CHECK(createIndex(table, 0));
+  for(i = 0; i < numInserts; i++)
+    {
+      r = testRecord(schema, i, "catalog", i * 3);
+      TEST_CHECK(insertRecord(table, r));
+      rids[i] = r->id;
+      freeRecord(r);
+    }
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(shutdownRecordManager());
+
+  // the schema, the counts and the index come back from the catalog file
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(openTable(table, "test_table_rm"));
+  ASSERT_EQUALS_INT(schema->numAttr, table->schema->numAttr, "number of attributes");
+  for(i = 0; i < schema->numAttr; i++)
+    {
+      ASSERT_EQUALS_STRING(schema->attrNames[i], table->schema->attrNames[i], "attribute name");
+      ASSERT_EQUALS_INT(schema->dataTypes[i], table->schema->dataTypes[i], "attribute type");
+      ASSERT_EQUALS_INT(schema->typeLength[i], table->schema->typeLength[i], "attribute length");
+    }
+  ASSERT_EQUALS_INT(schema->keySize, table->schema->keySize, "key size");
+  ASSERT_EQUALS_INT(schema->keyAttrs[0], table->schema->keyAttrs[0], "key attribute");
+  ASSERT_EQUALS_INT(numInserts, getNumTuples(table), "number of records");
+  rc = createIndex(table, 0);
+  ASSERT_EQUALS_INT(RC_INVALID_PARAMETER, rc, "index still there");
+
+  TEST_CHECK(createRecord(&r, schema));
+  for(i = 0; i < numInserts; i++)
+    {
+      expected = testRecord(schema, i, "catalog", i * 3);
+      TEST_CHECK(getRecord(table, rids[i], r));
+      ASSERT_EQUALS_RECORDS(expected, r, schema, "record read back after a restart");
+      freeRecord(expected);
+    }
+  TEST_CHECK(closeTable(table));
+
+  // a deleted table stays deleted, the other one is still there
+  TEST_CHECK(deleteTable("test_table_rm2"));
+  TEST_CHECK(shutdownRecordManager());
+  TEST_CHECK(initRecordManager(NULL));
+  rc = openTable(table, "test_table_rm2");
+  ASSERT_EQUALS_INT(RC_FILE_NOT_FOUND, rc, "deleted table is gone");
+  TEST_CHECK(openTable(table, "test_table_rm"));
+  ASSERT_EQUALS_INT(numInserts, getNumTuples(table), "other table kept its records");
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("test_table_rm"));
+  TEST_CHECK(shutdownRecordManager());
+  TEST_CHECK(destroyPageFile(CATALOG_FILE_NAME));
+
+  freeRecord(r);
+  free(rids);
+  free(table);
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testCatalogFile (void)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  RM_ManagerOptions options = { NULL, "test_catalog_rm.bin" };
+  Schema *schema;
+  int rc;
+  testName = "test the catalog goes to the file it is given";
+
+  schema = testSchema(10);
+  TEST_CHECK(initRecordManagerWithOptions(&options));
+  TEST_CHECK(createTable("test_table_rm", schema));
+  TEST_CHECK(openTable(table, "test_table_rm"));
+  TEST_CHECK(createIndex(table, 0));
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(shutdownRecordManager());
+  ASSERT_TRUE(access("test_catalog_rm.bin", F_OK) == 0, "named catalog written");
+  ASSERT_TRUE(access(CATALOG_FILE_NAME, F_OK) == -1, "default catalog not written");
+
+  // the index comes back from the named catalog
+  TEST_CHECK(initRecordManagerWithOptions(&options));
+  TEST_CHECK(openTable(table, "test_table_rm"));
+  rc = createIndex(table, 0);
+  ASSERT_EQUALS_INT(RC_INVALID_PARAMETER, rc, "index still there");
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("test_table_rm"));
+  TEST_CHECK(shutdownRecordManager());
+  TEST_CHECK(destroyPageFile("test_catalog_rm.bin"));
+
+  // without options the default file is used again
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTable("test_table_rm", schema));
+  TEST_CHECK(deleteTable("test_table_rm"));
+  TEST_CHECK(shutdownRecordManager());
+  ASSERT_TRUE(access("test_catalog_rm.bin", F_OK) == -1, "named catalog left alone");
+  TEST_CHECK(destroyPageFile(CATALOG_FILE_NAME));
+
+  freeSchema(schema);
+  free(table);
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testOpenTableTwice (void)
+{
+  RM_TableData *first = (RM_TableData *) malloc(sizeof(RM_TableData));
+  RM_TableData *second = (RM_TableData *) malloc(sizeof(RM_TableData));
+  Schema *schema;
+  Record *r, *s;
+  Expr *sel;
+  int i;
+  testName = "test a table opened twice shares its records";
+
+  schema = testSchema(10);
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTable("test_table_rm", schema));
+  TEST_CHECK(openTable(first, "test_table_rm"));
+  TEST_CHECK(openTable(second, "test_table_rm"));
+
+  // what one handle changes the other one sees
+  TEST_CHECK(createRecord(&r, schema));
+  for(i = 0; i < 20; i++)
+    {
+      s = testRecord(schema, i, "twice", i);
+      TEST_CHECK(insertRecord(first, s));
+      TEST_CHECK(getRecord(second, s->id, r));
+      ASSERT_EQUALS_RECORDS(s, r, schema, "record inserted through the other handle");
+      freeRecord(s);
+    }
+  ASSERT_EQUALS_INT(20, getNumTuples(second), "count seen through the other handle");
+  s = testRecord(schema, 0, "changed", 0);
+  s->id = r->id;
+  TEST_CHECK(updateRecord(second, s));
+  TEST_CHECK(getRecord(first, s->id, r));
+  ASSERT_EQUALS_RECORDS(s, r, schema, "update seen through the other handle");
+  freeRecord(s);
+
+  // closing one handle leaves the table open for the other
+  TEST_CHECK(closeTable(first));
+  ASSERT_TRUE(first->schema == NULL, "closed handle gave back its schema");
+  ASSERT_EQUALS_STRING(schema->attrNames[1], second->schema->attrNames[1], "schema of the other handle kept");
+  s = testRecord(schema, 20, "after", 20);
+  TEST_CHECK(insertRecord(second, s));
+  TEST_CHECK(getRecord(second, s->id, r));
+  ASSERT_EQUALS_RECORDS(s, r, schema, "table still open after the first close");
+  sel = attrAtLeast(0, 0);
+  ASSERT_EQUALS_INT(21, countRecords(second, sel), "scan through the handle left open");
+  TEST_CHECK(closeTable(second));
+
+  // the last close wrote the table back
+  TEST_CHECK(openTable(first, "test_table_rm"));
+  ASSERT_EQUALS_INT(21, getNumTuples(first), "count after both handles were closed");
+  TEST_CHECK(getRecord(first, s->id, r));
+  ASSERT_EQUALS_RECORDS(s, r, schema, "record read back after both handles were closed");
+  TEST_CHECK(closeTable(first));
+  TEST_CHECK(deleteTable("test_table_rm"));
+  TEST_CHECK(shutdownRecordManager());
+  TEST_CHECK(destroyPageFile(CATALOG_FILE_NAME));
+
+  freeRecord(s);
+  freeRecord(r);
+  freeExpr(sel);
+  free(first);
+  free(second);
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testPaxTable (void)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  RM_TableOptions options = { RM_LAYOUT_PAX };
+  RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+  int numInserts = 2000;
+  RID *rids = (RID *) malloc(sizeof(RID) * numInserts);
+  bool *seen = (bool *) calloc(numInserts, sizeof(bool));
+  char b[16];
+  Schema *schema;
+  Record *r, *expected;
+  Value *value;
+  Expr *sel;
+  int i, rc, count;
+  testName = "test a table with PAX pages";
+
+  schema = testSchema(16);
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTableWithOptions("test_table_rm", schema, &options));
+  TEST_CHECK(openTable(table, "test_table_rm"));
+
+  for(i = 0; i < numInserts; i++)
+    {
+      sprintf(b, "pax%d", i);
+      r = testRecord(schema, i, b, i % 100);
+      TEST_CHECK(insertRecord(table, r));
+      rids[i] = r->id;
+      freeRecord(r);
+    }
+  ASSERT_TRUE(rids[numInserts - 1].page > rids[0].page, "records spread over several pages");
+
+  // every attribute comes back from its minipage
+  TEST_CHECK(createRecord(&r, schema));
+  for(i = 0; i < numInserts; i += 7)
+    {
+      TEST_CHECK(getRecord(table, rids[i], r));
+      TEST_CHECK(getAttr(r, schema, 0, &value));
+      ASSERT_EQUALS_INT(i, value->v.intV, "first attribute");
+      freeVal(value);
+      TEST_CHECK(getAttr(r, schema, 1, &value));
+      sprintf(b, "pax%d", i);
+      ASSERT_EQUALS_STRING(b, value->v.stringV, "second attribute");
+      freeVal(value);
+      TEST_CHECK(getAttr(r, schema, 2, &value));
+      ASSERT_EQUALS_INT(i % 100, value->v.intV, "third attribute");
+      freeVal(value);
+    }
+
+  // a record is updated in its slot, a deleted one leaves its slot to the next insert
+  expected = testRecord(schema, 1, "updated", 1);
+  expected->id = rids[1];
+  TEST_CHECK(updateRecord(table, expected));
+  TEST_CHECK(getRecord(table, rids[1], r));
+  ASSERT_EQUALS_RECORDS(expected, r, schema, "updated PAX record");
+  TEST_CHECK(deleteRecord(table, rids[2]));
+  rc = getRecord(table, rids[2], r);
+  ASSERT_EQUALS_INT(RC_RM_NO_TUPLE_WITH_GIVEN_RID, rc, "deleted PAX record");
+  freeRecord(expected);
+  expected = testRecord(schema, 2, "again", 2);
+  TEST_CHECK(insertRecord(table, expected));
+  ASSERT_EQUALS_RID(rids[2], expected->id, "empty slot filled again");
+  freeRecord(expected);
+
+  // a scan returns the records that satisfy its condition, across the pages
+  sel = attrAtLeast(2, 90);
+  TEST_CHECK(startScan(table, sc, sel));
+  count = 0;
+  while((rc = next(sc, r)) == RC_OK)
+    {
+      TEST_CHECK(getAttr(r, schema, 0, &value));
+      ASSERT_TRUE(value->v.intV % 100 >= 90 && !seen[value->v.intV], "scanned record satisfies the condition");
+      ASSERT_EQUALS_RID(rids[value->v.intV], r->id, "scan returns the RID of the record");
+      seen[value->v.intV] = TRUE;
+      freeVal(value);
+      count++;
+    }
+  ASSERT_EQUALS_INT(RC_RM_NO_MORE_TUPLES, rc, "scan ends after the last record");
+  TEST_CHECK(closeScan(sc));
+  ASSERT_EQUALS_INT(numInserts / 10, count, "scan returns every matching record");
+
+  // the table keeps its layout after a restart
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(shutdownRecordManager());
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(openTable(table, "test_table_rm"));
+  ASSERT_EQUALS_INT(numInserts, getNumTuples(table), "records counted after a restart");
+  ASSERT_EQUALS_INT(numInserts / 10, countRecords(table, sel), "records scanned after a restart");
+  TEST_CHECK(getRecord(table, rids[numInserts - 1], r));
+  TEST_CHECK(getAttr(r, schema, 0, &value));
+  ASSERT_EQUALS_INT(numInserts - 1, value->v.intV, "record read back after a restart");
+  freeVal(value);
+
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("test_table_rm"));
+  TEST_CHECK(shutdownRecordManager());
+  TEST_CHECK(destroyPageFile(CATALOG_FILE_NAME));
+
+  freeRecord(r);
+  freeExpr(sel);
+  free(rids);
+  free(seen);
+  free(sc);
+  free(table);
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testNextBatch (void)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  RM_TableOptions options = { RM_LAYOUT_PAX };
+  int numInserts = 1000;
+  Record **records = (Record **) malloc(sizeof(Record *) * numInserts);
+  Schema *schema;
+  ExprProgram *program;
+  Expr *sel, *slow, *inner;
+  int i, layout;
+  testName = "test scanning records in batches";
+
+  schema = testSchema(100);
+  sel = attrAtLeast(2, 5);
+
+  // wrapped in more NOTs than a program has instructions the condition is left to evalExpr
+  slow = attrAtLeast(2, 5);
+  for(i = 0; i < EXPR_MAX_INSTRUCTIONS + 2; i++)
+    {
+      inner = slow;
+      MAKE_UNOP_EXPR(slow, inner, OP_BOOL_NOT);
+    }
+  program = compileExpr(slow, schema);
+  ASSERT_TRUE(program == NULL, "condition too long to compile");
+
+  TEST_CHECK(initRecordManager(NULL));
+  for(layout = RM_LAYOUT_ROW; layout <= RM_LAYOUT_PAX; layout++)
+    {
+      TEST_CHECK(createTableWithOptions("test_table_rm", schema, layout == RM_LAYOUT_PAX ? &options : NULL));
+      TEST_CHECK(openTable(table, "test_table_rm"));
+      for(i = 0; i < numInserts; i++)
+	{
+	  records[i] = repeatedRecord(schema, i, 'a' + i % 26, i % 100, i % 10);
+	  TEST_CHECK(insertRecord(table, records[i]));
+	}
+
+      // full batches up to the last one, compiled and evaluated record by record
+      checkBatchScan(table, sel, 50, records, numInserts, numInserts / 2);
+      checkBatchScan(table, sel, 1, records, numInserts, numInserts / 2);
+      checkBatchScan(table, slow, 64, records, numInserts, numInserts / 2);
+
+      TEST_CHECK(closeTable(table));
+      TEST_CHECK(deleteTable("test_table_rm"));
+      for(i = 0; i < numInserts; i++)
+	freeRecord(records[i]);
+    }
+  TEST_CHECK(shutdownRecordManager());
+  TEST_CHECK(destroyPageFile(CATALOG_FILE_NAME));
+
+  freeExpr(sel);
+  freeExpr(slow);
+  free(records);
+  free(table);
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testScanReadFailure (void)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+  RecordBatch *batch;
+  Schema *schema;
+  Record *r;
+  Expr *sel;
+  int i, rc;
+  testName = "test a scan reports a page it can not read";
+
+  schema = testSchema(10);
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTable("test_table_rm", schema));
+  TEST_CHECK(openTable(table, "test_table_rm"));
+  for(i = 0; i < 100; i++)
+    {
+      r = testRecord(schema, i, "gone", i);
+      TEST_CHECK(insertRecord(table, r));
+      freeRecord(r);
+    }
+  TEST_CHECK(closeTable(table));
+
+  // opened again nothing of the table is cached, and its file is gone
+  TEST_CHECK(openTable(table, "test_table_rm"));
+  TEST_CHECK(destroyPageFile("test_table_rm"));
+  sel = attrAtLeast(0, 0);
+  TEST_CHECK(createRecord(&r, schema));
+  TEST_CHECK(createRecordBatch(&batch, schema, 10));
+
+  TEST_CHECK(startScan(table, sc, sel));
+  rc = next(sc, r);
+  ASSERT_TRUE(rc != RC_OK && rc != RC_RM_NO_MORE_TUPLES, "next reports the read error");
+  TEST_CHECK(closeScan(sc));
+  TEST_CHECK(startScan(table, sc, sel));
+  rc = nextBatch(sc, batch, 10);
+  ASSERT_TRUE(rc != RC_OK && rc != RC_RM_NO_MORE_TUPLES, "nextBatch reports the read error");
+  TEST_CHECK(closeScan(sc));
+
+  TEST_CHECK(closeTable(table));
+  deleteTable("test_table_rm");
+  TEST_CHECK(shutdownRecordManager());
+  TEST_CHECK(destroyPageFile(CATALOG_FILE_NAME));
+
+  TEST_CHECK(freeRecordBatch(batch));
+  freeRecord(r);
+  freeExpr(sel);
+  free(sc);
+  free(table);
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testRecordView (void)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  int numFrames = 4;
+  int numInserts = numFrames + 2;
+  Record **records = (Record **) malloc(sizeof(Record *) * numInserts);
+  RecordView *views = (RecordView *) malloc(sizeof(RecordView) * numFrames);
+  BM_SharedPool pool;
+  Schema *schema;
+  Record *r;
+  Value *value;
+  int i, rc;
+  testName = "test a record view keeps its page pinned until it is released";
+
+  // a record per page, and a pool with a frame for each view
+  schema = testSchema(5000);
+  TEST_CHECK(initSharedPool(&pool, numFrames, RS_LRU, NULL));
+  TEST_CHECK(initRecordManager(&pool));
+  TEST_CHECK(createTable("test_table_rm", schema));
+  TEST_CHECK(openTable(table, "test_table_rm"));
+  for(i = 0; i < numInserts; i++)
+    {
+      records[i] = repeatedRecord(schema, i, 'a' + i, 5000 - 10, 100 + i);
+      TEST_CHECK(insertRecord(table, records[i]));
+    }
+  TEST_CHECK(createRecord(&r, schema));
+
+  for(i = 0; i < numFrames; i++)
+    {
+      TEST_CHECK(getRecordView(table, records[i]->id, &views[i]));
+      ASSERT_EQUALS_INT(records[i]->id.page, views[i].pageNum, "view on the page of the record");
+    }
+
+  // every frame holds a view, so no other page can be read
+  rc = getRecord(table, records[numFrames]->id, r);
+  ASSERT_EQUALS_INT(RC_NO_SPACE_IN_POOL, rc, "pages of the views stay pinned");
+
+  // one released view makes room, the others still read their records
+  TEST_CHECK(releaseRecordView(&views[0]));
+  TEST_CHECK(getRecord(table, records[numFrames]->id, r));
+  ASSERT_EQUALS_RECORDS(records[numFrames], r, schema, "record read after a view was released");
+  TEST_CHECK(getRecord(table, records[numFrames + 1]->id, r));
+  ASSERT_EQUALS_RECORDS(records[numFrames + 1], r, schema, "released frame is reused");
+  for(i = 1; i < numFrames; i++)
+    {
+      TEST_CHECK(getViewAttr(&views[i], schema, 0, &value));
+      ASSERT_EQUALS_INT(i, value->v.intV, "first attribute read through the view");
+      freeVal(value);
+      TEST_CHECK(getViewAttr(&views[i], schema, 1, &value));
+      ASSERT_EQUALS_INT(5000 - 10, (int) strlen(value->v.stringV), "string read through the view");
+      ASSERT_TRUE(value->v.stringV[0] == 'a' + i, "string of the record read through the view");
+      freeVal(value);
+      TEST_CHECK(getViewAttr(&views[i], schema, 2, &value));
+      ASSERT_EQUALS_INT(100 + i, value->v.intV, "attribute after the string read through the view");
+      freeVal(value);
+    }
+
+  for(i = 1; i < numFrames; i++)
+    TEST_CHECK(releaseRecordView(&views[i]));
+  rc = releaseRecordView(&views[0]);
+  ASSERT_EQUALS_INT(RC_ERROR, rc, "a view is released once");
+  rc = getViewAttr(&views[0], schema, 0, &value);
+  ASSERT_EQUALS_INT(RC_ERROR, rc, "released view is not read");
+
+  // with every page unpinned again the table closes and the pool shuts down
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("test_table_rm"));
+  TEST_CHECK(shutdownRecordManager());
+  TEST_CHECK(destroyPageFile(CATALOG_FILE_NAME));
+  TEST_CHECK(shutdownSharedPool(&pool));
+
+  for(i = 0; i < numInserts; i++)
+    freeRecord(records[i]);
+  freeRecord(r);
+  free(records);
+  free(views);
+  free(table);
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testRingScan (void)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+  RM_ScanOptions options = { 0 };
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  int numFrames = 8;
+  int numOther = 3;
+  int numInserts = 20;
+  Record **records = (Record **) malloc(sizeof(Record *) * numInserts);
+  BM_SharedPool pool;
+  BM_BufferPool other;
+  PageNumber *frameContents;
+  Schema *schema;
+  Record *r;
+  Value *value;
+  Expr *sel;
+  int i, rc, numRing, numPlain, numResident;
+  testName = "test a scan through a ring leaves the other pages of the pool alone";
+
+  // a record per page, the table is larger than the pool
+  schema = testSchema(5000);
+  TEST_CHECK(initSharedPool(&pool, numFrames, RS_LRU, NULL));
+  TEST_CHECK(initRecordManager(&pool));
+  TEST_CHECK(createTable("test_table_rm", schema));
+  TEST_CHECK(openTable(table, "test_table_rm"));
+  for(i = 0; i < numInserts; i++)
+    {
+      records[i] = repeatedRecord(schema, i, 'a' + i, 5000 - 10, 100 + i);
+      TEST_CHECK(insertRecord(table, records[i]));
+    }
+
+  // pages of another file the scan should not push out
+  TEST_CHECK(createPageFile("test_ring_rm.bin"));
+  TEST_CHECK(attachBufferPool(&other, &pool, "test_ring_rm.bin", 0));
+  for(i = 0; i < numOther; i++)
+    {
+      TEST_CHECK(pinPage(&other, h, i));
+      TEST_CHECK(unpinPage(&other, h));
+    }
+
+  sel = attrAtLeast(2, 0);
+  TEST_CHECK(createRecord(&r, schema));
+  options.ringPages = 2;
+  TEST_CHECK(startScanWithOptions(table, sc, sel, &options));
+  numRing = 0;
+  while((rc = next(sc, r)) == RC_OK)
+    {
+      TEST_CHECK(getAttr(r, schema, 0, &value));
+      ASSERT_EQUALS_RECORDS(records[value->v.intV], r, schema, "ring scan returns the record");
+      freeVal(value);
+      numRing++;
+    }
+  ASSERT_EQUALS_INT(RC_RM_NO_MORE_TUPLES, rc, "ring scan ends after the last record");
+  TEST_CHECK(closeScan(sc));
+  ASSERT_EQUALS_INT(numInserts, numRing, "ring scan returns every record");
+
+  frameContents = getFrameContents(&other);
+  numResident = 0;
+  for(i = 0; i < numFrames; i++)
+    if (frameContents[i] != NO_PAGE)
+      numResident++;
+  free(frameContents);
+  ASSERT_EQUALS_INT(numOther, numResident, "pages of the other file still resident");
+
+  // a plain scan returns the same records and caches every page it reads
+  TEST_CHECK(startScan(table, sc, sel));
+  numPlain = 0;
+  while((rc = next(sc, r)) == RC_OK)
+    {
+      TEST_CHECK(getAttr(r, schema, 0, &value));
+      ASSERT_EQUALS_RECORDS(records[value->v.intV], r, schema, "plain scan returns the record");
+      freeVal(value);
+      numPlain++;
+    }
+  ASSERT_EQUALS_INT(RC_RM_NO_MORE_TUPLES, rc, "plain scan ends after the last record");
+  TEST_CHECK(closeScan(sc));
+  ASSERT_EQUALS_INT(numRing, numPlain, "both scans return as many records");
+
+  frameContents = getFrameContents(&other);
+  numResident = 0;
+  for(i = 0; i < numFrames; i++)
+    if (frameContents[i] != NO_PAGE)
+      numResident++;
+  free(frameContents);
+  ASSERT_EQUALS_INT(0, numResident, "plain scan pushed the other pages out");
+
+  TEST_CHECK(shutdownBufferPool(&other));
+  TEST_CHECK(destroyPageFile("test_ring_rm.bin"));
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("test_table_rm"));
+  TEST_CHECK(shutdownRecordManager());
+  TEST_CHECK(destroyPageFile(CATALOG_FILE_NAME));
+  TEST_CHECK(shutdownSharedPool(&pool));
+
+  for(i = 0; i < numInserts; i++)
+    freeRecord(records[i]);
+  freeRecord(r);
+  freeExpr(sel);
+  free(records);
+  free(table);
+  free(sc);
+  free(h);
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testParallelScan (void)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+  RM_ScanOptions options = { 0 };
+  int numInserts = 3000;
+  Record **records = (Record **) malloc(sizeof(Record *) * numInserts);
+  bool *serial = (bool *) calloc(numInserts, sizeof(bool));
+  bool *parallel = (bool *) calloc(numInserts, sizeof(bool));
+  RecordView view;
+  Schema *schema;
+  Record *r;
+  Expr *sel;
+  int i, rc, numSerial, numParallel;
+  testName = "test a parallel scan returns the records a serial scan does";
+
+  schema = testSchema(20);
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTable("test_table_rm", schema));
+  TEST_CHECK(openTable(table, "test_table_rm"));
+  for(i = 0; i < numInserts; i++)
+    {
+      records[i] = testRecord(schema, i, "parallel", i % 100);
+      TEST_CHECK(insertRecord(table, records[i]));
+    }
+
+  // the first page stays pinned by a view while updates make it dirty
+  TEST_CHECK(getRecordView(table, records[0]->id, &view));
+  for(i = 0; i < numInserts && records[i]->id.page == view.id.page; i++)
+    {
+      r = testRecord(schema, i, "updated", 100 + i);
+      r->id = records[i]->id;
+      freeRecord(records[i]);
+      records[i] = r;
+      TEST_CHECK(updateRecord(table, records[i]));
+    }
+  ASSERT_TRUE(i > 1 && i < numInserts, "records of the pinned page updated");
+
+  sel = attrAtLeast(2, 50);
+  TEST_CHECK(createRecord(&r, schema));
+  TEST_CHECK(startScan(table, sc, sel));
+  numSerial = 0;
+  while((rc = next(sc, r)) == RC_OK)
+    {
+      Value *value;
+      TEST_CHECK(getAttr(r, schema, 0, &value));
+      serial[value->v.intV] = true;
+      freeVal(value);
+      numSerial++;
+    }
+  ASSERT_EQUALS_INT(RC_RM_NO_MORE_TUPLES, rc, "serial scan ends after the last record");
+  TEST_CHECK(closeScan(sc));
+
+  options.numThreads = 4;
+  TEST_CHECK(startScanWithOptions(table, sc, sel, &options));
+  numParallel = 0;
+  while((rc = next(sc, r)) == RC_OK)
+    {
+      Value *value;
+      TEST_CHECK(getAttr(r, schema, 0, &value));
+      ASSERT_TRUE(!parallel[value->v.intV], "record returned once");
+      parallel[value->v.intV] = true;
+      ASSERT_EQUALS_RECORDS(records[value->v.intV], r, schema, "parallel scan returns the record as it is now");
+      freeVal(value);
+      numParallel++;
+    }
+  ASSERT_EQUALS_INT(RC_RM_NO_MORE_TUPLES, rc, "parallel scan ends after the last record");
+  TEST_CHECK(closeScan(sc));
+  ASSERT_EQUALS_INT(numSerial, numParallel, "both scans return as many records");
+  for(i = 0; i < numInserts; i++)
+    ASSERT_TRUE(serial[i] == parallel[i], "both scans return the same records");
+
+  // the workers do not read through a ring
+  options.ringPages = 2;
+  ASSERT_EQUALS_INT(RC_INVALID_PARAMETER, startScanWithOptions(table, sc, sel, &options), "ring refused for workers");
+  options.ringPages = 0;
+
+  TEST_CHECK(releaseRecordView(&view));
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("test_table_rm"));
+  TEST_CHECK(shutdownRecordManager());
+  TEST_CHECK(destroyPageFile(CATALOG_FILE_NAME));
+
+  for(i = 0; i < numInserts; i++)
+    freeRecord(records[i]);
+  freeRecord(r);
+  freeExpr(sel);
+  free(serial);
+  free(parallel);
+  free(records);
+  free(sc);
+  free(table);
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testProjectedScan (void)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  RM_TableOptions tableOptions = { RM_LAYOUT_PAX };
+  RM_ScanOptions options = { 0 };
+  int attrs[] = { 1 };
+  int numInserts = 1000;
+  Record **records = (Record **) malloc(sizeof(Record *) * numInserts);
+  char name[16];
+  Schema *schema;
+  Expr *sel;
+  int i, layout;
+  testName = "test a projected scan filters on an attribute it does not return";
+
+  schema = testSchema(16);
+  // c >= 5, and only b is returned
+  sel = attrAtLeast(2, 5);
+  options.attrs = attrs;
+  options.numAttrs = 1;
+
+  TEST_CHECK(initRecordManager(NULL));
+  for(layout = RM_LAYOUT_ROW; layout <= RM_LAYOUT_PAX; layout++)
+    {
+      TEST_CHECK(createTableWithOptions("test_table_rm", schema, layout == RM_LAYOUT_PAX ? &tableOptions : NULL));
+      TEST_CHECK(openTable(table, "test_table_rm"));
+      for(i = 0; i < numInserts; i++)
+	{
+	  sprintf(name, "r%i", i);
+	  records[i] = testRecord(schema, i, name, i % 10);
+	  TEST_CHECK(insertRecord(table, records[i]));
+	}
+
+      options.numThreads = 0;
+      checkProjectedScan(table, sel, &options, records, numInserts, numInserts / 2);
+      options.numThreads = 4;
+      checkProjectedScan(table, sel, &options, records, numInserts, numInserts / 2);
+
+      TEST_CHECK(closeTable(table));
+      TEST_CHECK(deleteTable("test_table_rm"));
+      for(i = 0; i < numInserts; i++)
+	freeRecord(records[i]);
+    }
+  TEST_CHECK(shutdownRecordManager());
+  TEST_CHECK(destroyPageFile(CATALOG_FILE_NAME));
+
+  freeExpr(sel);
+  free(records);
+  free(table);
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testDuplicateKeys (void)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  int numInserts = 1500, numKeys = 10, numBatch = 500;
+  Record **records = (Record **) malloc(sizeof(Record *) * numInserts);
+  int *keys = (int *) malloc(sizeof(int) * numInserts);
+  bool *deleted = (bool *) calloc(numInserts, sizeof(bool));
+  BTreeHandle *tree;
+  Schema *schema;
+  Record *r;
+  Expr *sel;
+  int i, k, pass, expected, live;
+  testName = "test records sharing the key of an index";
+
+  schema = testSchema(20);
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTable("test_table_rm", schema));
+  TEST_CHECK(openTable(table, "test_table_rm"));
+
+  // the index is created on a table that has every key many times, then takes more of them
+  for(i = 0; i < numInserts; i++)
+    {
+      keys[i] = i % numKeys;
+      records[i] = testRecord(schema, i, "shared", keys[i]);
+      if (i < numInserts - numBatch)
+	TEST_CHECK(insertRecord(table, records[i]));
+    }
+  TEST_CHECK(createIndex(table, 2));
+  TEST_CHECK(insertRecords(table, records + numInserts - numBatch, numBatch));
+
+  // records move to another key, keep theirs, or go
+  for(i = 0; i < numInserts; i++)
+    {
+      if (i % 30 == 3 || i % 30 == 5)
+	{
+	  if (i % 30 == 3)
+	    keys[i] = 4;
+	  r = testRecord(schema, i, "updated", keys[i]);
+	  r->id = records[i]->id;
+	  freeRecord(records[i]);
+	  records[i] = r;
+	  TEST_CHECK(updateRecord(table, records[i]));
+	}
+      else if (i % 7 == 4)
+	{
+	  TEST_CHECK(deleteRecord(table, records[i]->id));
+	  deleted[i] = TRUE;
+	}
+    }
+  live = 0;
+  for(i = 0; i < numInserts; i++)
+    live += !deleted[i];
+
+  // every key finds all its records through the index, before and after a restart
+  for(pass = 0; pass < 2; pass++)
+    {
+      for(k = 0; k < numKeys; k++)
+	{
+	  expected = 0;
+	  for(i = 0; i < numInserts; i++)
+	    expected += !deleted[i] && keys[i] == k;
+	  sel = attrEquals(2, k);
+	  checkIndexRange(table, sel, 2, k, k, expected);
+	  freeExpr(sel);
+	}
+      TEST_CHECK(closeTable(table));
+      TEST_CHECK(shutdownRecordManager());
+
+      // the index has an entry for each record and none left over
+      TEST_CHECK(openBtree(&tree, "test_table_rm.idx2"));
+      TEST_CHECK(getNumEntries(tree, &expected));
+      ASSERT_EQUALS_INT(live, expected, "an index entry per record");
+      TEST_CHECK(closeBtree(tree));
+
+      TEST_CHECK(initRecordManager(NULL));
+      TEST_CHECK(openTable(table, "test_table_rm"));
+    }
+
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("test_table_rm"));
+  TEST_CHECK(shutdownRecordManager());
+  TEST_CHECK(destroyPageFile(CATALOG_FILE_NAME));
+
+  for(i = 0; i < numInserts; i++)
+    freeRecord(records[i]);
+  free(records);
+  free(keys);
+  free(deleted);
+  free(table);
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testUpdateIndexFailure (void)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  int numInserts = 100;
+  RID *rids = (RID *) malloc(sizeof(RID) * numInserts);
+  BTreeHandle *tree;
+  Schema *schema;
+  Record *r, *expected;
+  Expr *sel;
+  Value key;
+  RID rid;
+  int i, rc, failed, testint;
+  testName = "test an update its index can not take leaves the record and its keys";
+
+  schema = testSchema(20);
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTable("test_table_rm", schema));
+  TEST_CHECK(openTable(table, "test_table_rm"));
+  TEST_CHECK(createIndex(table, 0));
+  TEST_CHECK(createIndex(table, 2));
+
+  // the keys fill two leaves of each index
+  for(i = 0; i < numInserts; i++)
+    {
+      r = testRecord(schema, i, "first", i);
+      TEST_CHECK(insertRecord(table, r));
+      rids[i] = r->id;
+      freeRecord(r);
+    }
+
+  // an update that keeps the key of attribute 2 does not need its index
+  TEST_CHECK(destroyPageFile("test_table_rm.idx2"));
+  r = testRecord(schema, 1000, "moved", 0);
+  r->id = rids[0];
+  TEST_CHECK(updateRecord(table, r));
+  freeRecord(r);
+
+  // records move to the last leaf of each index, until the second one can not split it
+  failed = -1;
+  for(i = 1; i < numInserts && failed == -1; i++)
+    {
+      r = testRecord(schema, 1000 + i, "moved", 1000 + i);
+      r->id = rids[i];
+      rc = updateRecord(table, r);
+      if (rc != RC_OK)
+	failed = i;
+      freeRecord(r);
+    }
+  ASSERT_TRUE(failed != -1, "update reports the index error");
+
+  // the record and the index of attribute 0 are as they were before the update
+  TEST_CHECK(createRecord(&r, schema));
+  TEST_CHECK(getRecord(table, rids[failed], r));
+  expected = testRecord(schema, failed, "first", failed);
+  ASSERT_EQUALS_RECORDS(expected, r, schema, "record kept its old values");
+  sel = attrEquals(0, failed);
+  ASSERT_EQUALS_INT(1, countRecords(table, sel), "old key still finds the record");
+  freeExpr(sel);
+  sel = attrEquals(0, 1000);
+  ASSERT_EQUALS_INT(1, countRecords(table, sel), "earlier update kept its new key");
+  freeExpr(sel);
+
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(shutdownRecordManager());
+
+  TEST_CHECK(openBtree(&tree, "test_table_rm.idx0"));
+  TEST_CHECK(getNumEntries(tree, &testint));
+  ASSERT_EQUALS_INT(numInserts, testint, "an index entry per record");
+  key.dt = DT_INT;
+  key.v.intV = failed;
+  TEST_CHECK(findKey(tree, &key, &rid));
+  ASSERT_TRUE(rid.page == rids[failed].page && rid.slot == rids[failed].slot, "old entry back in the index");
+  key.v.intV = 1000 + failed;
+  ASSERT_EQUALS_INT(RC_IM_KEY_NOT_FOUND, findKey(tree, &key, &rid), "no entry for the new key");
+  TEST_CHECK(closeBtree(tree));
+
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(deleteTable("test_table_rm"));
+  TEST_CHECK(shutdownRecordManager());
+  TEST_CHECK(destroyPageFile(CATALOG_FILE_NAME));
+
+  freeRecord(r);
+  freeRecord(expected);
+  free(rids);
+  free(table);
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testIndexRanges (void)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  int numInserts = 200;
+  Schema *schema;
+  Record *r;
+  Expr *sel, *left, *right;
+  int i;
+  testName = "test the range of keys an index scan looks up";
+
+  schema = testSchema(20);
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTable("test_table_rm", schema));
+  TEST_CHECK(openTable(table, "test_table_rm"));
+  TEST_CHECK(createIndex(table, 2));
+
+  // c is the number of the record, a counts down
+  for(i = 0; i < numInserts; i++)
+    {
+      r = testRecord(schema, numInserts - i, "range", i);
+      TEST_CHECK(insertRecord(table, r));
+      freeRecord(r);
+    }
+
+  // c < 120 and 120 < c
+  sel = attrCompare(2, OP_COMP_SMALLER, 120, FALSE);
+  checkIndexRange(table, sel, 2, INT_MIN, 119, 120);
+  freeExpr(sel);
+  sel = attrCompare(2, OP_COMP_SMALLER, 120, TRUE);
+  checkIndexRange(table, sel, 2, 121, INT_MAX, 79);
+  freeExpr(sel);
+
+  // NOT(c < 120) and NOT(120 < c)
+  sel = attrAtLeast(2, 120);
+  checkIndexRange(table, sel, 2, 120, INT_MAX, 80);
+  freeExpr(sel);
+  MAKE_UNOP_EXPR(sel, attrCompare(2, OP_COMP_SMALLER, 120, TRUE), OP_BOOL_NOT);
+  checkIndexRange(table, sel, 2, INT_MIN, 120, 121);
+  freeExpr(sel);
+
+  // 120 = c
+  sel = attrCompare(2, OP_COMP_EQUAL, 120, TRUE);
+  checkIndexRange(table, sel, 2, 120, 120, 1);
+  freeExpr(sel);
+
+  // NOT(c < 50) AND c < 60, the other attribute is checked on the records
+  MAKE_BINOP_EXPR(left, attrAtLeast(2, 50), attrCompare(2, OP_COMP_SMALLER, 60, FALSE), OP_BOOL_AND);
+  checkIndexRange(table, left, 2, 50, 59, 10);
+  MAKE_BINOP_EXPR(sel, left, attrCompare(0, OP_COMP_SMALLER, 145, FALSE), OP_BOOL_AND);
+  checkIndexRange(table, sel, 2, 50, 59, 4);
+  freeExpr(sel);
+
+  // c < 50 AND 60 < c has no keys
+  MAKE_BINOP_EXPR(sel, attrCompare(2, OP_COMP_SMALLER, 50, FALSE), attrCompare(2, OP_COMP_SMALLER, 60, TRUE), OP_BOOL_AND);
+  checkIndexRange(table, sel, 2, 1, 0, 0);
+  freeExpr(sel);
+
+  // an OR and a condition on another attribute read the pages
+  MAKE_BINOP_EXPR(sel, attrCompare(2, OP_COMP_SMALLER, 10, FALSE), attrCompare(2, OP_COMP_SMALLER, 190, TRUE), OP_BOOL_OR);
+  checkIndexRange(table, sel, -1, 0, 0, 19);
+  freeExpr(sel);
+  left = attrCompare(0, OP_COMP_SMALLER, 11, FALSE);
+  checkIndexRange(table, left, -1, 0, 0, 10);
+  freeExpr(left);
+
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("test_table_rm"));
+  TEST_CHECK(shutdownRecordManager());
+  TEST_CHECK(destroyPageFile(CATALOG_FILE_NAME));
+
+  free(table);
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testRowPageColumns (void)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  int numInserts = 1000;
+  Record **records = (Record **) malloc(sizeof(Record *) * numInserts);
+  Schema *schema;
+  Expr *sel;
+  int i, expected;
+  testName = "test compiled conditions over the records of slotted pages";
+
+  schema = testSchema(100);
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTable("test_table_rm", schema));
+  TEST_CHECK(openTable(table, "test_table_rm"));
+
+  // strings of every length, some of them grow later and move to another page
+  for(i = 0; i < numInserts; i++)
+    {
+      records[i] = repeatedRecord(schema, i, 'a' + i % 26, i % 40, i % 10);
+      TEST_CHECK(insertRecord(table, records[i]));
+    }
+  for(i = 0; i < numInserts; i++)
+    if (i % 7 == 0)
+      {
+	Record *r = repeatedRecord(schema, i, 'z', 99, i % 10);
+	r->id = records[i]->id;
+	freeRecord(records[i]);
+	records[i] = r;
+	TEST_CHECK(updateRecord(table, records[i]));
+      }
+    else if (i % 11 == 0)
+      TEST_CHECK(deleteRecord(table, records[i]->id));
+
+  // 300 < a AND 5 = c, the constants on the left
+  MAKE_BINOP_EXPR(sel, attrCompare(0, OP_COMP_SMALLER, 300, TRUE), attrCompare(2, OP_COMP_EQUAL, 5, TRUE), OP_BOOL_AND);
+  expected = 0;
+  for(i = 301; i < numInserts; i++)
+    expected += (i % 10 == 5 && (i % 7 == 0 || i % 11 != 0));
+  checkBatchScan(table, sel, 64, records, numInserts, expected);
+  ASSERT_EQUALS_INT(expected, countRecords(table, sel), "records scanned one by one");
+  freeExpr(sel);
+
+  // a < 200 AND c = 5
+  MAKE_BINOP_EXPR(sel, attrCompare(0, OP_COMP_SMALLER, 200, FALSE), attrCompare(2, OP_COMP_EQUAL, 5, FALSE), OP_BOOL_AND);
+  expected = 0;
+  for(i = 0; i < 200; i++)
+    expected += (i % 10 == 5 && (i % 7 == 0 || i % 11 != 0));
+  checkBatchScan(table, sel, 7, records, numInserts, expected);
+  freeExpr(sel);
+
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("test_table_rm"));
+  TEST_CHECK(shutdownRecordManager());
+  TEST_CHECK(destroyPageFile(CATALOG_FILE_NAME));
+
+  for(i = 0; i < numInserts; i++)
+    freeRecord(records[i]);
+  free(records);
+  free(table);
+  TEST_DONE();
+}
+
+// ************************************************************
+Schema *
+testSchema (int stringLength)
+{
+  char *names[] = { "a", "b", "c" };
+  DataType dt[] = { DT_INT, DT_STRING, DT_INT };
+  int sizes[] = { 0, stringLength, 0 };
+  char **cpNames = (char **) malloc(sizeof(char*) * 3);
+  DataType *cpDt = (DataType *) malloc(sizeof(DataType) * 3);
+  int *cpSizes = (int *) malloc(sizeof(int) * 3);
+  int *cpKeys = (int *) malloc(sizeof(int));
+  int i;
+
+  for(i = 0; i < 3; i++)
+    cpNames[i] = strdup(names[i]);
+  memcpy(cpDt, dt, sizeof(DataType) * 3);
+  memcpy(cpSizes, sizes, sizeof(int) * 3);
+  cpKeys[0] = 0;
+
+  return createSchema(3, cpNames, cpDt, cpSizes, 1, cpKeys);
+}
+
+// ************************************************************
+Record *
+testRecord (Schema *schema, int a, char *b, int c)
+{
+  Record *result;
+  Value *value;
+
+  TEST_CHECK(createRecord(&result, schema));
+
+  MAKE_VALUE(value, DT_INT, a);
+  TEST_CHECK(setAttr(result, schema, 0, value));
+  freeVal(value);
+
+  MAKE_STRING_VALUE(value, b);
+  TEST_CHECK(setAttr(result, schema, 1, value));
+  freeVal(value);
+
+  MAKE_VALUE(value, DT_INT, c);
+  TEST_CHECK(setAttr(result, schema, 2, value));
+  freeVal(value);
+
+  return result;
+}
+
+// ************************************************************
+Record *
+repeatedRecord (Schema *schema, int a, char fill, int length, int c)
+{
+  char *b = (char *) malloc(length + 1);
+  Record *result;
+
+  memset(b, fill, length);
+  b[length] = '\0';
+  result = testRecord(schema, a, b, c);
+  free(b);
+
+  return result;
+}
+
+// ************************************************************
+Expr *
+attrAtLeast (int attrNum, int value)
+{
+  Expr *attr, *cons, *smaller, *result;
+  Value *v;
+
+  MAKE_VALUE(v, DT_INT, value);
+  MAKE_ATTRREF(attr, attrNum);
+  MAKE_CONS(cons, v);
+  MAKE_BINOP_EXPR(smaller, attr, cons, OP_COMP_SMALLER);
+  MAKE_UNOP_EXPR(result, smaller, OP_BOOL_NOT);
+
+  return result;
+}
+
+// ************************************************************
+Expr *
+attrEquals (int attrNum, int value)
+{
+  Expr *attr, *cons, *result;
+  Value *v;
+
+  MAKE_VALUE(v, DT_INT, value);
+  MAKE_ATTRREF(attr, attrNum);
+  MAKE_CONS(cons, v);
+  MAKE_BINOP_EXPR(result, attr, cons, OP_COMP_EQUAL);
+
+  return result;
+}
+
+// ************************************************************
+Expr *
+attrCompare (int attrNum, OpType op, int value, bool constFirst)
+{
+  Expr *attr, *cons, *result;
+  Value *v;
+
+  MAKE_VALUE(v, DT_INT, value);
+  MAKE_ATTRREF(attr, attrNum);
+  MAKE_CONS(cons, v);
+  if (constFirst)
+    MAKE_BINOP_EXPR(result, cons, attr, op);
+  else
+    MAKE_BINOP_EXPR(result, attr, cons, op);
+
+  return result;
+}
+
+// ************************************************************
+int
+countRecords (RM_TableData *table, Expr *cond)
+{
+  RM_ScanHandle sc;
+  Record *r;
+  int count = 0;
+  int rc;
+
+  TEST_CHECK(createRecord(&r, table->schema));
+  TEST_CHECK(startScan(table, &sc, cond));
+  while((rc = next(&sc, r)) == RC_OK)
+    count++;
+  ASSERT_EQUALS_INT(RC_RM_NO_MORE_TUPLES, rc, "scan ends after the last record");
+  TEST_CHECK(closeScan(&sc));
+  freeRecord(r);
+
+  return count;
+}
+
+// ************************************************************
+void
+checkIndexRange (RM_TableData *table, Expr *cond, int attrNum, int low, int high, int expected)
+{
+  RM_ScanHandle sc;
+  Record *r;
+  int count = 0;
+  int rc, scanAttr, scanLow, scanHigh;
+
+  TEST_CHECK(createRecord(&r, table->schema));
+  TEST_CHECK(startScan(table, &sc, cond));
+  TEST_CHECK(getScanIndexRange(&sc, &scanAttr, &scanLow, &scanHigh));
+  ASSERT_EQUALS_INT(attrNum, scanAttr, "scan takes its records from the index");
+  if (attrNum != -1)
+    {
+      ASSERT_EQUALS_INT(low, scanLow, "lowest key the index scan looks up");
+      ASSERT_EQUALS_INT(high, scanHigh, "highest key the index scan looks up");
+    }
+  while((rc = next(&sc, r)) == RC_OK)
+    count++;
+  ASSERT_EQUALS_INT(RC_RM_NO_MORE_TUPLES, rc, "scan ends after the last record");
+  ASSERT_EQUALS_INT(expected, count, "records the scan returns");
+  TEST_CHECK(closeScan(&sc));
+  freeRecord(r);
+}
+
+// ************************************************************
+void
+checkBatchScan (RM_TableData *table, Expr *cond, int maxRows, Record **records, int numRecords, int expected)
+{
+  RM_ScanHandle sc;
+  RecordBatch *batch;
+  bool *seen = (bool *) calloc(numRecords, sizeof(bool));
+  bool ended = FALSE;
+  int pass, i, rc, count;
+
+  TEST_CHECK(createRecordBatch(&batch, table->schema, 64));
+  TEST_CHECK(startScan(table, &sc, cond));
+
+  // the scan starts over after its last batch
+  for(pass = 0; pass < 2; pass++)
+    {
+      memset(seen, 0, sizeof(bool) * numRecords);
+      count = 0;
+      while((rc = nextBatch(&sc, batch, maxRows)) == RC_OK)
+	{
+	  ASSERT_TRUE(!ended && batch->numRows > 0 && batch->numRows <= maxRows, "batch holds up to maxRows records");
+	  ended = batch->numRows < maxRows;
+	  for(i = 0; i < batch->numRows; i++)
+	    {
+	      Record *r = &batch->records[i];
+	      Value *a;
+	      TEST_CHECK(getAttr(r, table->schema, 0, &a));
+	      ASSERT_TRUE(!seen[a->v.intV], "batch record returned once");
+	      ASSERT_EQUALS_RID(records[a->v.intV]->id, r->id, "batch returns the RID of the record");
+	      ASSERT_EQUALS_RECORDS(records[a->v.intV], r, table->schema, "batch returns the record");
+	      seen[a->v.intV] = TRUE;
+	      freeVal(a);
+	    }
+	  count += batch->numRows;
+	}
+      ASSERT_EQUALS_INT(RC_RM_NO_MORE_TUPLES, rc, "batches end after the last record");
+      ASSERT_EQUALS_INT(expected, count, "batches return every matching record");
+      ended = FALSE;
+    }
+
+  TEST_CHECK(closeScan(&sc));
+  TEST_CHECK(freeRecordBatch(batch));
+  free(seen);
+}
+
+// ************************************************************
+void
+checkProjectedScan (RM_TableData *table, Expr *cond, RM_ScanOptions *options, Record **records, int numRecords, int expected)
+{
+  RM_ScanHandle sc;
+  RecordBatch *batch;
+  Record *r;
+  bool *seen = (bool *) calloc(numRecords, sizeof(bool));
+  int i, rc, count;
+
+  // the attributes that are not returned keep what the records held before
+  TEST_CHECK(createRecord(&r, table->schema));
+  TEST_CHECK(createRecordBatch(&batch, table->schema, 64));
+  for(i = 0; i <= batch->capacity; i++)
+    {
+      Record *row = (i < batch->capacity) ? &batch->records[i] : r;
+      Value *value;
+      MAKE_VALUE(value, DT_INT, -1);
+      TEST_CHECK(setAttr(row, table->schema, 0, value));
+      TEST_CHECK(setAttr(row, table->schema, 2, value));
+      freeVal(value);
+    }
+
+  TEST_CHECK(startScanWithOptions(table, &sc, cond, options));
+  count = 0;
+  while((rc = next(&sc, r)) == RC_OK)
+    {
+      checkProjectedRecord(r, table->schema, records, seen);
+      count++;
+    }
+  ASSERT_EQUALS_INT(RC_RM_NO_MORE_TUPLES, rc, "projected scan ends after the last record");
+  ASSERT_EQUALS_INT(expected, count, "projected scan returns every matching record");
+  TEST_CHECK(closeScan(&sc));
+
+  memset(seen, 0, sizeof(bool) * numRecords);
+  TEST_CHECK(startScanWithOptions(table, &sc, cond, options));
+  count = 0;
+  while((rc = nextBatch(&sc, batch, 64)) == RC_OK)
+    {
+      for(i = 0; i < batch->numRows; i++)
+	checkProjectedRecord(&batch->records[i], table->schema, records, seen);
+      count += batch->numRows;
+    }
+  ASSERT_EQUALS_INT(RC_RM_NO_MORE_TUPLES, rc, "projected batches end after the last record");
+  ASSERT_EQUALS_INT(expected, count, "projected batches return every matching record");
+  TEST_CHECK(closeScan(&sc));
+
+  TEST_CHECK(freeRecordBatch(batch));
+  freeRecord(r);
+  free(seen);
+}
+
+// ************************************************************
+void
+checkProjectedRecord (Record *r, Schema *schema, Record **records, bool *seen)
+{
+  Value *value;
+  int i;
+
+  // b names the record, a and c were not returned
+  TEST_CHECK(getAttr(r, schema, 1, &value));
+  i = atoi(value->v.stringV + 1);
+  freeVal(value);
+  ASSERT_TRUE(!seen[i], "projected record returned once");
+  seen[i] = TRUE;
+  ASSERT_EQUALS_RID(records[i]->id, r->id, "projected scan returns the RID of the record");
+  ASSERT_TRUE(i % 10 >= 5, "condition on an attribute that is not returned holds");
+  ASSERT_TRUE(r->data[0] == '-', "tombstone marker kept");
+
+  TEST_CHECK(getAttr(r, schema, 0, &value));
+  ASSERT_EQUALS_INT(-1, value->v.intV, "first attribute not returned");
+  freeVal(value);
+  TEST_CHECK(getAttr(r, schema, 2, &value));
+  ASSERT_EQUALS_INT(-1, value->v.intV, "attribute of the condition not returned");
+  freeVal(value);
+}